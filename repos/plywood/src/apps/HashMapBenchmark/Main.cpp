@@ -0,0 +1,141 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Base.h>
+#include <ply-runtime/container/FlatHashMap.h>
+#include <ply-runtime/algorithm/Random.h>
+#include <ply-runtime/string/Label.h>
+
+using namespace ply;
+
+// Compares HashMap and FlatHashMap on the kinds of keys Plywood uses most: Labels, StringViews
+// and pointers. Each benchmark inserts every key, looks up every key, looks up keys that aren't
+// present, then erases every key.
+
+static constexpr u32 NumKeys = 200000;
+static constexpr u32 NumRepeats = 5;
+
+struct LabelTraits {
+    using Key = Label;
+    using Item = Label;
+    static PLY_INLINE bool match(Item item, Key key) {
+        return item == key;
+    }
+};
+
+struct StringViewTraits {
+    using Key = StringView;
+    using Item = StringView;
+    static PLY_INLINE bool match(Item item, Key key) {
+        return item == key;
+    }
+};
+
+struct PointerTraits {
+    using Key = const void*;
+    using Item = const void*;
+    static PLY_INLINE bool match(Item item, Key key) {
+        return item == key;
+    }
+};
+
+struct Timings {
+    float insert = 0;
+    float find = 0;
+    float findMissing = 0;
+    float erase = 0;
+};
+
+template <typename Map, typename Key>
+Timings runBenchmark(ArrayView<const Key> keys, ArrayView<const Key> missingKeys) {
+    CPUTimer::Converter converter;
+    Timings best;
+    u32 numFound = 0;
+    for (u32 r = 0; r < NumRepeats; r++) {
+        Map map;
+        CPUTimer::Point start = CPUTimer::get();
+        for (const Key& key : keys) {
+            map.insertOrFind(key);
+        }
+        CPUTimer::Point inserted = CPUTimer::get();
+        for (const Key& key : keys) {
+            numFound += map.find(key).wasFound();
+        }
+        CPUTimer::Point found = CPUTimer::get();
+        for (const Key& key : missingKeys) {
+            numFound += map.find(key).wasFound();
+        }
+        CPUTimer::Point foundMissing = CPUTimer::get();
+        for (const Key& key : keys) {
+            map.find(key).erase();
+        }
+        CPUTimer::Point erased = CPUTimer::get();
+
+        Timings t;
+        t.insert = converter.toSeconds(inserted - start);
+        t.find = converter.toSeconds(found - inserted);
+        t.findMissing = converter.toSeconds(foundMissing - found);
+        t.erase = converter.toSeconds(erased - foundMissing);
+        if (r == 0 || t.insert < best.insert)
+            best.insert = t.insert;
+        if (r == 0 || t.find < best.find)
+            best.find = t.find;
+        if (r == 0 || t.findMissing < best.findMissing)
+            best.findMissing = t.findMissing;
+        if (r == 0 || t.erase < best.erase)
+            best.erase = t.erase;
+    }
+    PLY_ASSERT(numFound == keys.numItems * NumRepeats);
+    PLY_UNUSED(numFound);
+    return best;
+}
+
+template <typename Traits>
+void compare(OutStream* outs, StringView keyType, ArrayView<const typename Traits::Key> keys,
+             ArrayView<const typename Traits::Key> missingKeys) {
+    using Key = typename Traits::Key;
+    Timings a = runBenchmark<HashMap<Traits>, Key>(keys, missingKeys);
+    Timings b = runBenchmark<FlatHashMap<Traits>, Key>(keys, missingKeys);
+    float nsPerKey = 1e9f / keys.numItems;
+    outs->format("{} keys (ns per operation, HashMap -> FlatHashMap):\n", keyType);
+    outs->format("    insert:       {} -> {}\n", a.insert * nsPerKey, b.insert * nsPerKey);
+    outs->format("    find:         {} -> {}\n", a.find * nsPerKey, b.find * nsPerKey);
+    outs->format("    find missing: {} -> {}\n", a.findMissing * nsPerKey,
+                 b.findMissing * nsPerKey);
+    outs->format("    erase:        {} -> {}\n", a.erase * nsPerKey, b.erase * nsPerKey);
+}
+
+int main() {
+    OutStream outs = StdOut::text();
+    Random random{1};
+
+    Array<String> strings;
+    for (u32 i = 0; i < NumKeys * 2; i++) {
+        strings.append(String::format("identifier_{}_{}", i, random.next32()));
+    }
+    Array<StringView> stringKeys;
+    Array<StringView> missingStringKeys;
+    Array<Label> labelKeys;
+    Array<Label> missingLabelKeys;
+    for (u32 i = 0; i < NumKeys; i++) {
+        stringKeys.append(strings[i]);
+        missingStringKeys.append(strings[NumKeys + i]);
+        labelKeys.append(LabelMap::instance.insertOrFind(strings[i]));
+        missingLabelKeys.append(LabelMap::instance.insertOrFind(strings[NumKeys + i]));
+    }
+
+    // Pointers to separately allocated objects, like the keys of an object-to-ID map.
+    Array<Owned<u64>> objects;
+    Array<const void*> pointerKeys;
+    Array<const void*> missingPointerKeys;
+    for (u32 i = 0; i < NumKeys * 2; i++) {
+        objects.append(new u64{i});
+        ((i < NumKeys) ? pointerKeys : missingPointerKeys).append(objects.back().get());
+    }
+
+    compare<LabelTraits>(&outs, "Label", labelKeys, missingLabelKeys);
+    compare<StringViewTraits>(&outs, "StringView", stringKeys, missingStringKeys);
+    compare<PointerTraits>(&outs, "Pointer", pointerKeys, missingPointerKeys);
+    return 0;
+}
@@ -34,7 +34,7 @@ using namespace ply;
 
 Array<Reference<cook::CookJob>> copyStaticFiles(cook::CookContext* ctx, StringView srcRoot) {
     Array<Reference<cook::CookJob>> copyJobs;
-    for (WalkTriple& triple : FileSystem::native()->walk(srcRoot)) {
+    for (WalkTriple& triple : FileSystem::native()->walk(srcRoot, 0)) {
         for (const WalkTriple::FileInfo& file : triple.files) {
             String relativeDir = NativePath::makeRelative(srcRoot, triple.dirPath);
             copyJobs.append(ctx->cook(
@@ -46,7 +46,7 @@ Array<Reference<cook::CookJob>> copyStaticFiles(cook::CookContext* ctx, StringVi
 
 Array<String> getSourceFileKeys(StringView srcRoot) {
     Array<String> srcKeys;
-    for (WalkTriple& triple : FileSystem::native()->walk(srcRoot)) {
+    FileSystem::native()->walkParallel(srcRoot, 0, [&](WalkTriple& triple) {
         for (const WalkTriple::FileInfo& file : triple.files) {
             if (file.name.endsWith(".cpp") || file.name.endsWith(".h")) {
                 // FIXME: Eliminate exclusions
@@ -77,7 +77,9 @@ Array<String> getSourceFileKeys(StringView srcRoot) {
                 triple.dirNames.erase(i);
             }
         }
-    }
+    });
+    // Directories are visited in an arbitrary order, so sort the keys to keep the output stable.
+    sort(srcKeys.view());
     return srcKeys;
 }
 
@@ -6,6 +6,7 @@
 #include <ply-web-serve-docs/DocServer.h>
 #include <WebServer/Config.h>
 #include <web-common/FetchFromFileSystem.h>
+#include <web-common/ResponseCache.h>
 #include <web-common/SourceCode.h>
 #include <web-common/Echo.h>
 #include <web-common/OutPipe_HTTPChunked.h>
@@ -14,6 +15,7 @@ using namespace ply;
 using namespace web;
 
 struct AllParams {
+    ResponseCache cache;
     DocServer docs;
     FetchFromFileSystem fileSys;
     SourceCode sourceCode;
@@ -118,7 +120,10 @@ int main(int argc, char* argv[]) {
     }
     StdOut::text().format("Serving from {} on port {}\n", dataRoot, port);
     AllParams allParams;
+    allParams.cache.watch(dataRoot);
     allParams.fileSys.rootDir = dataRoot;
+    allParams.fileSys.cache = &allParams.cache;
+    allParams.docs.cache = &allParams.cache;
     allParams.docs.init(dataRoot);
     allParams.sourceCode.rootDir = NativePath::normalize(PLY_WORKSPACE_FOLDER);
     if (!runServer(port, {&allParams, myRequestHandler})) {
@@ -173,7 +173,7 @@ InstantiatedDLLs buildInstantiatorDLLs(bool force) {
         // Recursively find all files named *.modules.cpp:
         String repoFolder = NativePath::join(ctx.repoRootFolder, entry.name);
         Array<ModuleDefinitionFile> modDefFiles;
-        for (const WalkTriple& triple : FileSystem::native()->walk(repoFolder)) {
+        for (const WalkTriple& triple : FileSystem::native()->walk(repoFolder, 0)) {
             for (const WalkTriple::FileInfo& file : triple.files) {
                 if (file.name == "Instantiators.inl") {
                     // FIXME: Remove this later
@@ -5,6 +5,7 @@
 #include <ply-cook/Core.h>
 #include <ply-cook/CookJob.h>
 #include <ply-runtime/algorithm/Find.h>
+#include <ply-runtime/filesystem/FileStatusCache.h>
 #include <ply-reflect/Asset.h>
 
 namespace ply {
@@ -55,7 +56,7 @@ DependencyType DependencyType_File = {
     [](Dependency* dep_, CookResult* result, AnyObject) -> bool { //
         // FIXME: Use a safe cast once reflection supports derived classes
         Dependency_File* depFile = static_cast<Dependency_File*>(dep_);
-        FileStatus stat = FileSystem::native()->getFileStatus(depFile->path);
+        FileStatus stat = FileStatusCache::native().getFileStatus(depFile->path);
         PLY_ASSERT(stat.result == FSResult::OK);
         if (stat.modificationTime != depFile->modificationTime) {
             SLOG(Cook, "Recooking \"{}\" because \"{}\" changed", result->job->id.str(),
@@ -79,7 +80,8 @@ CookResult::FileDepScope CookResult::createFileDependency(StringView path) {
     fds.depFile->path = path;
     this->dependencies.append(fds.depFile);
 
-    FileStatus status = FileSystem::native()->getFileStatus(path);
+    // Many jobs depend on the same files, so query the shared cache instead of the filesystem.
+    FileStatus status = FileStatusCache::native().getFileStatus(path);
     if (status.result == FSResult::OK) {
         fds.modificationTime = status.modificationTime;
     } else {
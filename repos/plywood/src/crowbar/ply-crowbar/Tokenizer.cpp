@@ -3,12 +3,13 @@
   \\\/  https://plywood.arc80.com/
 ------------------------------------*/
 #include <ply-crowbar/Tokenizer.h>
+#include <ply-runtime/string/ByteClass.h>
 
 namespace ply {
 namespace crowbar {
 
 PLY_NO_INLINE Tokenizer::Tokenizer()
-    : tokenData{1024 * 1024 * 1024}, fileOffsetTable{4 * 1024 * 1024} {
+    : fileOffsetTable{4 * 1024 * 1024} {
 }
 
 PLY_NO_INLINE void Tokenizer::setSourceInput(StringView src) {
@@ -150,14 +151,19 @@ ExpandedToken Tokenizer::expandToken(u32 tokenIdx) {
     return result;
 }
 
+// Character classes used to scan runs of characters with the SIMD kernels in ByteClass.
+static constexpr u32 IdentifierMask[8] = {0,          0x3ff0000,  0x87fffffe, 0x7fffffe,
+                                          0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+static constexpr u32 DigitMask[8] = {0, 0x3ff0000, 0, 0, 0, 0, 0, 0};
+static constexpr u32 SpaceMask[8] = {0x2200, 0x1, 0, 0, 0, 0, 0, 0}; // '\t', '\r' and ' '
+static constexpr ByteClass IdentifierClass{IdentifierMask};
+static constexpr ByteClass DigitClass{DigitMask};
+static constexpr ByteClass SpaceClass{SpaceMask};
+
 PLY_NO_INLINE void skipLineComment(Tokenizer* tkr) {
     tkr->vin.next();
-    while (!tkr->vin.atEOF()) {
-        char c = tkr->vin.peek();
-        if (c == '\n')
-            return; // End of line comment
-        tkr->vin.next();
-    }
+    // Stop at the end of the line comment.
+    tkr->vin.cur = findByteInRange(tkr->vin.cur, tkr->vin.end, '\n');
 }
 
 PLY_NO_INLINE void skipCStyleComment(Tokenizer* tkr) {
@@ -179,15 +185,7 @@ PLY_NO_INLINE void readIdentifier(ExpandedToken& expToken, Tokenizer* tkr) {
     // Find end of identifier
     const char* start = tkr->vin.cur;
     tkr->vin.next();
-    while (!tkr->vin.atEOF()) {
-        char c = tkr->vin.peek();
-        if (c < 0 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
-            (c >= '0' && c <= '9')) {
-            tkr->vin.next();
-        } else {
-            break;
-        }
-    }
+    tkr->vin.cur = IdentifierClass.findFirstNotIn(tkr->vin.cur, tkr->vin.end);
 
     StringView text = StringView::fromRange(start, tkr->vin.cur);
     expToken.type = TokenType::Identifier;
@@ -199,14 +197,7 @@ PLY_NO_INLINE void readNumeric(ExpandedToken& expToken, Tokenizer* tkr) {
     // Find end of identifier
     const char* start = tkr->vin.cur;
     tkr->vin.next();
-    while (!tkr->vin.atEOF()) {
-        char c = tkr->vin.peek();
-        if (c >= '0' && c <= '9') {
-            tkr->vin.next();
-        } else {
-            break;
-        }
-    }
+    tkr->vin.cur = DigitClass.findFirstNotIn(tkr->vin.cur, tkr->vin.end);
 
     StringView text = StringView::fromRange(start, tkr->vin.cur);
     expToken.type = TokenType::NumericLiteral;
@@ -308,12 +299,7 @@ PLY_NO_INLINE ExpandedToken Tokenizer::readToken() {
             case '\r':
             case '\t':
             case ' ': {
-                while (!this->vin.atEOF()) {
-                    char n = this->vin.peek();
-                    if (!(n == '\r' || n == '\t' || n == ' '))
-                        break;
-                    this->vin.next();
-                }
+                this->vin.cur = SpaceClass.findFirstNotIn(this->vin.cur, this->vin.end);
                 break;
             }
 
@@ -21,6 +21,11 @@ void module_plyPlatform(ModuleArgs* args) {
 #define PLY_USE_DLMALLOC 1
 #define PLY_DLMALLOC_DEBUG_CHECKS 0
 #define PLY_DLMALLOC_FAST_STATS 0
+// The per-thread cache is opt-in. A build can enable it with -DPLY_DLMALLOC_THREAD_CACHE=1.
+#ifndef PLY_DLMALLOC_THREAD_CACHE
+#define PLY_DLMALLOC_THREAD_CACHE 0
+#endif
+#define PLY_HEAP_PROFILING 0
 
 // Avoid degraded performance caused by Mutex_Win32 (FIXME: Make this the default?):
 #define PLY_IMPL_MUTEX_PATH "impl/Mutex_CPP11.h"
@@ -74,6 +74,32 @@ PLY_INLINE std::enable_if_t<std::is_integral<I>::value, u32> countSetBits(I mask
     return count;
 }
 
+PLY_INLINE u32 countTrailingZeros(u64 v) {
+    PLY_ASSERT(v != 0);
+#if PLY_COMPILER_MSVC
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long) v))
+        return index;
+    _BitScanForward(&index, (unsigned long) (v >> 32));
+    return index + 32;
+#else
+    return (u32) __builtin_ctzll(v);
+#endif
+}
+
+PLY_INLINE u32 countLeadingZeros(u64 v) {
+    PLY_ASSERT(v != 0);
+#if PLY_COMPILER_MSVC
+    unsigned long index;
+    if (_BitScanReverse(&index, (unsigned long) (v >> 32)))
+        return 31 - index;
+    _BitScanReverse(&index, (unsigned long) v);
+    return 63 - index;
+#else
+    return (u32) __builtin_clzll(v);
+#endif
+}
+
 template <typename Dst, typename Src>
 PLY_INLINE constexpr std::enable_if_t<std::is_unsigned<Src>::value, Dst> safeDemote(Src src) {
     // src is unsigned
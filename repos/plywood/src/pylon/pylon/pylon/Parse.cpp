@@ -5,6 +5,7 @@
 #include <pylon/Core.h>
 #include <pylon/Parse.h>
 #include <ply-runtime/io/StdIO.h>
+#include <ply-runtime/string/ByteClass.h>
 
 namespace pylon {
 
@@ -13,6 +14,13 @@ bool isAlnumUnit(u32 c) {
            (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || (c >= 128);
 }
 
+// Units accepted by isAlnumUnit, and whitespace other than '\n', for use with Parser::skipWhile.
+static constexpr u32 AlnumMask[8] = {0,          0x3ff6010,  0x87fffffe, 0x7fffffe,
+                                     0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+static constexpr u32 SpaceMask[8] = {0x2200, 0x1, 0, 0, 0, 0, 0, 0};
+static constexpr ByteClass AlnumClass{AlnumMask};
+static constexpr ByteClass SpaceClass{SpaceMask};
+
 void Parser::dumpError(const ParseError& error, OutStream& outs) const {
     FileLocation errorLoc = this->fileLocMap.getFileLocation(error.fileOfs);
     outs.format("({}, {}): error: {}\n", errorLoc.lineNumber, errorLoc.columnNumber, error.message);
@@ -59,6 +67,20 @@ void Parser::advanceChar() {
     }
 }
 
+void Parser::skipWhile(const ByteClass& cls) {
+    // Like calling advanceChar() while nextUnit belongs to cls, but scans for the end of the run
+    // using the SIMD kernels.
+    if (readOfs >= srcView.numBytes)
+        return;
+    const char* stop = cls.findFirstNotIn(srcView.bytes + readOfs, srcView.end());
+    readOfs = safeDemote<u32>(stop - srcView.bytes);
+    if (readOfs < srcView.numBytes) {
+        nextUnit = *stop;
+    } else {
+        nextUnit = -1;
+    }
+}
+
 Parser::Token Parser::readPlainToken(Token::Type type) {
     Token result = {type, this->readOfs, {}};
     advanceChar();
@@ -207,9 +229,7 @@ Parser::Token Parser::readLiteral() {
     Token token = {Token::Text, this->readOfs, {}};
     u32 startOfs = readOfs;
 
-    while (isAlnumUnit(nextUnit)) {
-        advanceChar();
-    }
+    skipWhile(AlnumClass);
 
     token.text = StringView{(char*) srcView.bytes + startOfs, readOfs - startOfs};
     return token;
@@ -227,7 +247,7 @@ Parser::Token Parser::readToken(bool tokenizeNewLine) {
             case ' ':
             case '\t':
             case '\r':
-                advanceChar();
+                skipWhile(SpaceClass);
                 break;
 
             case '\n': {
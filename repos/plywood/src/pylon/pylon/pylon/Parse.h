@@ -100,6 +100,7 @@ private:
 
     void error(u32 fileOfs, HybridString&& message);
     void advanceChar();
+    void skipWhile(const ByteClass& cls);
     Token readPlainToken(Token::Type type);
     bool readEscapedHex(OutStream* outs, u32 escapeFileOfs);
     Token readQuotedString();
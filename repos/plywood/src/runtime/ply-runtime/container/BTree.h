@@ -4,6 +4,7 @@
 ------------------------------------*/
 #pragma once
 #include <ply-runtime/Core.h>
+#include <ply-runtime/container/Array.h>
 
 #define PLY_BTREE_VALIDATE 0
 
@@ -69,6 +70,22 @@ private:
             return links[lo].child;
         }
 
+        Node* getLastChildLessOrEqual(const Index& index) {
+            PLY_ASSERT(!isLeaf);
+            PLY_ASSERT(size > 0);
+            Link* links = getLinks();
+            u32 lo = 0;
+            u32 hi = size - 1;
+            while (lo < hi) {
+                u32 mid = (lo + hi + 1) / 2;
+                if (!Traits::less(index, links[mid].index))
+                    lo = mid;
+                else
+                    hi = mid - 1;
+            }
+            return links[lo].child;
+        }
+
         u32 findLink(Node* child) {
             PLY_ASSERT(!isLeaf);
             u32 s = size;
@@ -241,6 +258,23 @@ private:
             }
         }
 
+        void deleteItems(u32 pos, u32 count) {
+            PLY_ASSERT(isLeaf);
+            PLY_ASSERT(count > 0 && pos + count <= size);
+            u32 s = size;
+            Item* items = getItems();
+            for (u32 i = pos; i + count < s; i++) {
+                items[i] = std::move(items[i + count]);
+            }
+            for (u32 i = s - count; i < s; i++) {
+                items[i].~Item();
+            }
+            size = s - count;
+            if (pos == 0 && size > 0) {
+                this->updateIndexInParent(Traits::getIndex(items[0]));
+            }
+        }
+
         Node* splitLeaf() {
             PLY_ASSERT(isLeaf);
             PLY_ASSERT(size >= 2);
@@ -388,6 +422,24 @@ private:
         }
     }
 
+    // Builds one level of the tree from left to right, distributing numChildren as evenly as
+    // possible across the fewest nodes that can hold them.
+    template <typename FillNode>
+    static Array<Node*> buildLevel(u32 numChildren, bool isLeaf, const FillNode& fillNode) {
+        u32 numNodes = (numChildren + Traits::NodeCapacity - 1) / Traits::NodeCapacity;
+        Array<Node*> nodes;
+        nodes.reserve(numNodes);
+        for (u32 i = 0; i < numNodes; i++) {
+            u32 begin = u32(u64(numChildren) * i / numNodes);
+            u32 end = u32(u64(numChildren) * (i + 1) / numNodes);
+            Node* node = isLeaf ? Node::createLeaf() : Node::createInnerNode();
+            fillNode(node, begin, end);
+            node->size = u16(end - begin);
+            nodes.append(node);
+        }
+        return nodes;
+    }
+
     Node* split(Node* node) {
         PLY_ASSERT(node->isLeaf);
         Node* rightSibling = node->splitLeaf();
@@ -593,6 +645,29 @@ public:
         }
     }
 
+    // Returns an iterator to the first item whose index is greater than index.
+    Iterator findFirstGreaterThan(const Index& index) const {
+        if (!m_root)
+            return {nullptr, 0};
+        Node* node = m_root;
+        while (!node->isLeaf) {
+            node = node->getLastChildLessOrEqual(index);
+        }
+        u32 pos = node->findInsertPos(index);
+        if (pos >= node->size)
+            return {node->getRightSibling(), 0};
+        return {node, pos};
+    }
+
+    // lowerBound() and upperBound() follow the naming of std::lower_bound and std::upper_bound.
+    Iterator lowerBound(const Index& index) const {
+        return findFirstGreaterOrEqualTo(index);
+    }
+
+    Iterator upperBound(const Index& index) const {
+        return findFirstGreaterThan(index);
+    }
+
     Iterator findFirstGreaterOrEqualTo(const Index& index) const {
         if (!m_root)
             return {nullptr, 0};
@@ -606,6 +681,96 @@ public:
         return {node, pos};
     }
 
+    // Replaces the contents of the tree with the given items, which must already be sorted by
+    // index. The tree is built bottom-up in O(n) time, which is much faster than inserting the
+    // items one at a time.
+    void bulkLoad(ArrayView<const Item> items) {
+        clear();
+        if (items.isEmpty())
+            return;
+        Array<Node*> level = buildLevel(items.numItems, true, [&](Node* leaf, u32 begin, u32 end) {
+            Item* dstItems = leaf->getItems();
+            for (u32 i = begin; i < end; i++) {
+                PLY_ASSERT(i == 0 || !Traits::less(Traits::getIndex(items[i]),
+                                                   Traits::getIndex(items[i - 1])));
+                Item* dst = new (dstItems + (i - begin)) Item(items[i]);
+                Traits::onItemMoved(*dst, leaf);
+            }
+        });
+        while (level.numItems() > 1) {
+            level = buildLevel(level.numItems(), false, [&](Node* node, u32 begin, u32 end) {
+                Link* links = node->getLinks();
+                for (u32 i = begin; i < end; i++) {
+                    Node* child = level[i];
+                    new (links + (i - begin)) Link{child->getFirstIndex(), child};
+                    child->parent = node;
+                }
+            });
+        }
+        m_root = level[0];
+    }
+
+    // Removes every item whose index is in the range [first, last) and returns the number of
+    // items removed. Items are removed a leaf at a time.
+    u32 eraseRange(const Index& first, const Index& last) {
+        u32 numErased = 0;
+        for (;;) {
+            Iterator iter = findFirstGreaterOrEqualTo(first);
+            if (!iter.isValid())
+                break;
+            Node* leaf = iter.getLeaf();
+            u32 pos = iter.getPos();
+            Item* items = leaf->getItems();
+            u32 endPos = pos;
+            while (endPos < leaf->size && Traits::less(Traits::getIndex(items[endPos]), last)) {
+                endPos++;
+            }
+            if (endPos == pos)
+                break;
+            leaf->deleteItems(pos, endPos - pos);
+            numErased += endPos - pos;
+            tryCompact(leaf);
+        }
+        return numErased;
+    }
+
+    struct SubRange {
+        Iterator first;
+        Iterator last; // Exclusive
+    };
+
+    // Splits the tree into consecutive ranges of items, one per subtree, at the shallowest level
+    // of the tree that has at least minNumRanges nodes (or at the leaves). The ranges don't
+    // overlap, so they can be iterated in parallel as long as the tree isn't modified.
+    Array<SubRange> splitIntoRanges(u32 minNumRanges) const {
+        Array<SubRange> ranges;
+        if (!m_root)
+            return ranges;
+        Array<Node*> level;
+        level.append(m_root);
+        while (level.numItems() < minNumRanges && !level[0]->isLeaf) {
+            Array<Node*> children;
+            for (Node* node : level) {
+                Link* links = node->getLinks();
+                for (u32 i = 0; i < node->size; i++) {
+                    children.append(links[i].child);
+                }
+            }
+            level = std::move(children);
+        }
+        for (u32 i = 0; i < level.numItems(); i++) {
+            Node* leaf = level[i];
+            while (!leaf->isLeaf) {
+                leaf = leaf->getLinks()[0].child;
+            }
+            if (i > 0) {
+                ranges.back().last = Iterator{leaf, 0};
+            }
+            ranges.append({Iterator{leaf, 0}, Iterator{nullptr, 0}});
+        }
+        return ranges;
+    }
+
     Iterator prepareInsert(const Index& index) {
         if (!m_root)
             m_root = Node::createLeaf();
@@ -5,10 +5,19 @@
 #include <ply-runtime/Precomp.h>
 #include <ply-runtime/container/BigPool.h>
 #include <ply-runtime/memory/MemPage.h>
+#if PLY_TARGET_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <ply-runtime/filesystem/FileSystem.h>
+#endif
 
 namespace ply {
 
-PLY_NO_INLINE BaseBigPool::BaseBigPool(uptr numReservedBytes) {
+PLY_NO_INLINE BaseBigPool::BaseBigPool(uptr numReservedBytes, GrowMode growMode)
+    : growMode{growMode} {
     uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
     this->numReservedBytes = alignPowerOf2(numReservedBytes, allocationGranularity);
     bool rc = MemPage::reserve(this->base, this->numReservedBytes);
@@ -16,8 +25,65 @@ PLY_NO_INLINE BaseBigPool::BaseBigPool(uptr numReservedBytes) {
     PLY_UNUSED(rc);
 }
 
+PLY_NO_INLINE BaseBigPool::BaseBigPool(StringView filePath, uptr numReservedBytes)
+    : filePath{filePath} {
+#if PLY_TARGET_POSIX
+    this->fd = open(this->filePath.withNullTerminator().bytes, O_RDWR | O_CREAT | O_CLOEXEC,
+                    mode_t(0644));
+    struct stat buf;
+    if (this->fd >= 0 && fstat(this->fd, &buf) == 0) {
+        this->numLoadedBytes = (uptr) buf.st_size;
+    } else {
+        this->fileError = true;
+    }
+#else
+    // No shared file mapping on this platform, so load the contents now and write them back in
+    // closeFile(). loadBinary() returns an empty string if the file doesn't exist yet.
+    String contents = FileSystem::native()->loadBinary(filePath);
+    FSResult result = FileSystem::native()->lastResult();
+    if (result != FSResult::OK && result != FSResult::NotFound) {
+        this->fileError = true;
+    }
+    this->numLoadedBytes = contents.numBytes;
+#endif
+
+    uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
+    this->numReservedBytes =
+        alignPowerOf2(max(numReservedBytes, this->numLoadedBytes), allocationGranularity);
+    bool rc = MemPage::reserve(this->base, this->numReservedBytes);
+    PLY_ASSERT(rc);
+    PLY_UNUSED(rc);
+    if (!this->fileError && this->numLoadedBytes > 0) {
+#if PLY_TARGET_POSIX
+        if (!this->mapFilePages(alignPowerOf2(this->numLoadedBytes, allocationGranularity))) {
+            // Leave the file as it was.
+            int rc2 = ftruncate(this->fd, (off_t) this->numLoadedBytes);
+            PLY_UNUSED(rc2);
+            this->fileError = true;
+        }
+#else
+        this->commitPages(this->numLoadedBytes);
+        memcpy(this->base, contents.bytes, contents.numBytes);
+#endif
+    }
+
+    if (this->fileError) {
+        // Continue as an empty pool that isn't backed by a file.
+#if PLY_TARGET_POSIX
+        if (this->fd >= 0) {
+            close(this->fd);
+            this->fd = -1;
+        }
+#endif
+        this->filePath = {};
+        this->numLoadedBytes = 0;
+    }
+}
+
 PLY_NO_INLINE BaseBigPool::~BaseBigPool() {
-    MemPage::free(this->base, this->numReservedBytes);
+    if (this->base) {
+        MemPage::free(this->base, this->numReservedBytes);
+    }
 }
 
 PLY_NO_INLINE void BaseBigPool::commitPages(uptr newTotalBytes) {
@@ -25,9 +91,139 @@ PLY_NO_INLINE void BaseBigPool::commitPages(uptr newTotalBytes) {
     PLY_ASSERT(isAlignedPowerOf2(this->numCommittedBytes, allocationGranularity));
     uptr newPageBoundary = alignPowerOf2(newTotalBytes, allocationGranularity);
     PLY_ASSERT(newPageBoundary > this->numCommittedBytes);
+    if (newPageBoundary > this->numReservedBytes) {
+        this->growReservation(newPageBoundary);
+    }
+#if PLY_TARGET_POSIX
+    if (this->fd >= 0) {
+        if (!this->mapFilePages(newPageBoundary)) {
+            // Out of disk space or address space. There's no way to report this from an append.
+            PLY_FORCE_CRASH();
+        }
+        return;
+    }
+#endif
     MemPage::commit(this->base + this->numCommittedBytes,
                     newPageBoundary - this->numCommittedBytes);
     this->numCommittedBytes = newPageBoundary;
 }
 
+#if PLY_TARGET_POSIX
+PLY_NO_INLINE bool BaseBigPool::mapFilePages(uptr newPageBoundary) {
+    // Extend the file, then map the new part of it over the reserved pages.
+    if (ftruncate(this->fd, (off_t) newPageBoundary) != 0)
+        return false;
+    void* addr = mmap(this->base + this->numCommittedBytes,
+                      newPageBoundary - this->numCommittedBytes, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, this->fd, (off_t) this->numCommittedBytes);
+    if (addr != this->base + this->numCommittedBytes)
+        return false;
+    this->numCommittedBytes = newPageBoundary;
+    return true;
+}
+#endif
+
+PLY_NO_INLINE void BaseBigPool::decommitPagesAfter(uptr numBytesInUse) {
+    uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
+    uptr newPageBoundary = alignPowerOf2(numBytesInUse, allocationGranularity);
+    if (newPageBoundary >= this->numCommittedBytes)
+        return;
+#if PLY_TARGET_POSIX
+    if (this->fd >= 0) {
+        // Replace the file pages with reserved-only pages, then shrink the file.
+        void* addr = mmap(this->base + newPageBoundary, this->numCommittedBytes - newPageBoundary,
+                          PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        PLY_ASSERT(addr == this->base + newPageBoundary);
+        PLY_UNUSED(addr);
+        int rc = ftruncate(this->fd, (off_t) newPageBoundary);
+        PLY_ASSERT(rc == 0);
+        PLY_UNUSED(rc);
+        this->numCommittedBytes = newPageBoundary;
+        return;
+    }
+#endif
+    MemPage::decommit(this->base + newPageBoundary, this->numCommittedBytes - newPageBoundary);
+    this->numCommittedBytes = newPageBoundary;
+}
+
+PLY_NO_INLINE void BaseBigPool::growReservation(uptr minNumBytes) {
+    uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
+    // Double the reservation, taking care not to overflow on 32-bit targets.
+    uptr doubled = this->numReservedBytes + min(this->numReservedBytes, uptr(-1) / 2);
+    uptr newNumReservedBytes = alignPowerOf2(max(minNumBytes, doubled), allocationGranularity);
+    PLY_ASSERT(newNumReservedBytes > this->numReservedBytes);
+
+#if PLY_TARGET_POSIX
+    {
+        // Try to reserve the address range immediately following the current reservation. Passing
+        // it as a hint (instead of MAP_FIXED) leaves any existing mapping there untouched.
+        char* desired = this->base + this->numReservedBytes;
+        uptr numExtraBytes = newNumReservedBytes - this->numReservedBytes;
+        void* addr =
+            mmap(desired, numExtraBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == desired) {
+            this->numReservedBytes = newNumReservedBytes;
+            return;
+        }
+        if (addr != MAP_FAILED) {
+            munmap(addr, numExtraBytes);
+        }
+    }
+#endif
+
+    // An InPlaceOnly pool can't exceed its reservation unless the adjacent address range is free.
+    // Callers read it without a lock, so moving it would leave them with a dangling pointer.
+    if (this->growMode == InPlaceOnly) {
+        PLY_FORCE_CRASH();
+    }
+    char* newBase = nullptr;
+    bool rc = MemPage::reserve(newBase, newNumReservedBytes);
+    PLY_ASSERT(rc);
+    PLY_UNUSED(rc);
+    if (this->numCommittedBytes > 0) {
+#if PLY_TARGET_POSIX
+        if (this->fd >= 0) {
+            // The file holds the data, so just map it again at the new address.
+            void* addr = mmap(newBase, this->numCommittedBytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, this->fd, 0);
+            PLY_ASSERT(addr == newBase);
+            PLY_UNUSED(addr);
+        } else
+#endif
+        {
+#if PLY_KERNEL_LINUX
+            // Move the committed pages without copying them.
+            void* addr = mremap(this->base, this->numCommittedBytes, this->numCommittedBytes,
+                                MREMAP_MAYMOVE | MREMAP_FIXED, newBase);
+            PLY_ASSERT(addr == newBase);
+            PLY_UNUSED(addr);
+#else
+            MemPage::commit(newBase, this->numCommittedBytes);
+            memcpy(newBase, this->base, this->numCommittedBytes);
+#endif
+        }
+    }
+    MemPage::free(this->base, this->numReservedBytes);
+    this->base = newBase;
+    this->numReservedBytes = newNumReservedBytes;
+}
+
+PLY_NO_INLINE void BaseBigPool::closeFile(uptr numBytesInUse) {
+    PLY_ASSERT(this->filePath);
+    PLY_ASSERT(numBytesInUse <= this->numCommittedBytes);
+#if PLY_TARGET_POSIX
+    MemPage::free(this->base, this->numReservedBytes);
+    this->base = nullptr;
+    // Drop the unused part of the last page.
+    int rc = ftruncate(this->fd, (off_t) numBytesInUse);
+    PLY_ASSERT(rc == 0);
+    PLY_UNUSED(rc);
+    close(this->fd);
+    this->fd = -1;
+#else
+    FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(
+        this->filePath, {this->base, safeDemote<u32>(numBytesInUse)});
+#endif
+}
+
 } // namespace ply
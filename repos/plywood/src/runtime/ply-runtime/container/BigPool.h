@@ -4,36 +4,109 @@
 ------------------------------------*/
 #pragma once
 #include <ply-runtime/Core.h>
+#include <ply-runtime/string/String.h>
 
 namespace ply {
 
-// FIXME: Implement a 32-bit friendly BigPool, especially for crowbar::Tokenizer
-PLY_STATIC_ASSERT(PLY_PTR_SIZE == 8);
-
 struct BaseBigPool {
+    // Determines what happens when the reserved address range is exhausted. MayMove pools can be
+    // relocated to a larger range; InPlaceOnly pools only grow if the adjacent address range is
+    // free, which lets callers read from the pool without a lock while another thread appends.
+    enum GrowMode {
+        MayMove,
+        InPlaceOnly,
+    };
+
     char* base = nullptr;
     uptr numReservedBytes = 0;
     uptr numCommittedBytes = 0;
+    GrowMode growMode = MayMove;
 
+    // When the pool is backed by a file, the committed pages are shared with the file, and the
+    // file is truncated to the number of bytes in use when the pool is destroyed.
+    String filePath;
+    uptr numLoadedBytes = 0; // Size of the file when it was opened
+    bool fileError = false;  // The file couldn't be opened, so the pool isn't backed by it
+#if PLY_TARGET_POSIX
+    int fd = -1;
+#endif
+
+#if PLY_PTR_SIZE == 8
     static constexpr uptr DefaultNumReservedBytes = 1024 * 1024 * 1024;
+#else
+    // Leave room in a 32-bit address space. The pool grows past this if needed.
+    static constexpr uptr DefaultNumReservedBytes = 64 * 1024 * 1024;
+#endif
 
-    BaseBigPool(uptr numReservedBytes = DefaultNumReservedBytes);
+    BaseBigPool(uptr numReservedBytes = DefaultNumReservedBytes, GrowMode growMode = MayMove);
+    BaseBigPool(StringView filePath, uptr numReservedBytes = DefaultNumReservedBytes);
     ~BaseBigPool();
     void commitPages(uptr newTotalBytes);
+    void decommitPagesAfter(uptr numBytesInUse);
+    void growReservation(uptr minNumBytes);
+#if PLY_TARGET_POSIX
+    bool mapFilePages(uptr newPageBoundary);
+#endif
+    void closeFile(uptr numBytesInUse);
 };
 
+//------------------------------------------------------------------------------------------------
+/*!
+A `BigPool` is an append-only array that reserves a large range of virtual address space up front
+and commits pages as items are added, so that existing items never need to be copied while the
+pool grows within its reservation.
+
+If the reservation is exhausted, a `MayMove` pool relocates to a larger range, which invalidates
+pointers to its items. An `InPlaceOnly` pool never moves. It only grows when the address range
+after the reservation is free, and crashes otherwise, so reserve enough address space up front.
+
+Items are never destructed by the pool. `truncate()` and `clear()` discard items, and `trim()`
+returns unused pages at the end of the pool to the operating system.
+
+A `BigPool` can be backed by a file to persist its contents between runs. Items that were in the
+pool when it was last destroyed are available immediately after construction. Only trivially
+copyable `T` is supported. If the file can't be opened, the pool starts out empty, isn't backed by
+any file, and `hasFileError()` returns `true`.
+*/
 template <typename T = char>
 class BigPool : protected BaseBigPool {
 private:
     uptr numItems_ = 0;
 
 public:
-    PLY_INLINE BigPool(uptr numReservedBytes = DefaultNumReservedBytes)
-        : BaseBigPool{numReservedBytes} {
+    using BaseBigPool::GrowMode;
+    using BaseBigPool::InPlaceOnly;
+    using BaseBigPool::MayMove;
+
+    PLY_INLINE BigPool(uptr numReservedBytes = DefaultNumReservedBytes,
+                       GrowMode growMode = MayMove)
+        : BaseBigPool{numReservedBytes, growMode} {
+    }
+    /*!
+    Opens or creates a file-backed pool.
+    */
+    PLY_INLINE BigPool(StringView filePath, uptr numReservedBytes = DefaultNumReservedBytes)
+        : BaseBigPool{filePath, numReservedBytes} {
+        PLY_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+        this->numItems_ = this->numLoadedBytes / sizeof(T);
+    }
+    PLY_INLINE ~BigPool() {
+        if (this->filePath) {
+            this->closeFile(sizeof(T) * this->numItems_);
+        }
+    }
+    /*!
+    Returns `true` if the pool was constructed from a file that couldn't be opened.
+    */
+    PLY_INLINE bool hasFileError() const {
+        return this->fileError;
     }
     PLY_INLINE uptr numItems() const {
         return this->numItems_;
     }
+    PLY_INLINE uptr numBytesCommitted() const {
+        return this->numCommittedBytes;
+    }
     PLY_INLINE const T& operator[](uptr idx) const {
         PLY_ASSERT(idx < this->numItems_);
         return ((const T*) this->base)[idx];
@@ -79,6 +152,24 @@ public:
     PLY_INLINE T& append(Args&&... args) {
         return *new (this->alloc()) T{std::forward<Args>(args)...};
     }
+    /*!
+    Discards all items after the first `numItems`. Their pages stay committed until `trim()` is
+    called.
+    */
+    PLY_INLINE void truncate(uptr numItems) {
+        PLY_ASSERT(numItems <= this->numItems_);
+        this->numItems_ = numItems;
+    }
+    /*!
+    Decommits every page that doesn't contain an item.
+    */
+    PLY_INLINE void trim() {
+        this->decommitPagesAfter(sizeof(T) * this->numItems_);
+    }
+    PLY_INLINE void clear() {
+        this->numItems_ = 0;
+        this->trim();
+    }
 };
 
 } // namespace ply
@@ -79,6 +79,7 @@ PLY_NO_INLINE void BlockList::appendBlockWithRecycle(Reference<Footer>& block, u
     // When possible, just reuse the existing block.
     if (block->refCount == 1 && block->blockSize == numBytes) {
         block->fileOffset += block->numBytesUsed;
+        block->startOffset = 0;
         block->numBytesUsed = 0;
         return;
     }
@@ -0,0 +1,142 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/container/ConcurrentBlockList.h>
+#include <ply-runtime/memory/Heap.h>
+#include <ply-runtime/io/OutStream.h>
+
+namespace ply {
+
+//--------------------------------------
+// ConcurrentBlockList::Footer
+//--------------------------------------
+PLY_NO_INLINE u32 ConcurrentBlockList::Footer::getNumCompletedBytes(bool* isComplete) const {
+    if (isComplete) {
+        *isComplete = false;
+    }
+    // Load the commit counter first. Every committed byte belongs to a reservation that was made
+    // before this load, so if the reservation counter loaded afterwards is equal, no reservations
+    // are outstanding.
+    u32 numCommitted = this->numBytesCommitted.load(Acquire);
+    u32 numSealed = this->numBytesSealed.load(Acquire);
+    if (numSealed != NotSealed) {
+        if (numCommitted != numSealed)
+            return 0;
+        if (isComplete) {
+            *isComplete = true;
+        }
+        return numSealed;
+    }
+    u32 numReserved = this->numBytesReserved.load(Acquire);
+    if (numReserved != numCommitted || numReserved > this->blockSize) {
+        // Either some reservations are outstanding, or the block overflowed and the thread that
+        // seals it hasn't stored numBytesSealed yet.
+        return 0;
+    }
+    return numReserved;
+}
+
+//--------------------------------------
+// ConcurrentBlockList::Reader
+//--------------------------------------
+PLY_NO_INLINE StringView ConcurrentBlockList::Reader::read() {
+    for (;;) {
+        bool isComplete = false;
+        u32 numCompleted = this->block->getNumCompletedBytes(&isComplete);
+        if (numCompleted > this->offset) {
+            StringView view{this->block->bytes + this->offset, numCompleted - this->offset};
+            this->offset = numCompleted;
+            return view;
+        }
+        if (!isComplete)
+            return {};
+        const Footer* nextBlock = this->block->nextBlock.load(Acquire);
+        if (!nextBlock)
+            return {};
+        this->block = nextBlock;
+        this->offset = 0;
+    }
+}
+
+//--------------------------------------
+// ConcurrentBlockList
+//--------------------------------------
+PLY_NO_INLINE ConcurrentBlockList::Footer* ConcurrentBlockList::createBlock(u32 numBytes) {
+    u32 alignedNumBytes = alignPowerOf2(numBytes, (u32) alignof(Footer));
+    char* bytes = (char*) PLY_HEAP.alloc(alignedNumBytes + sizeof(Footer));
+    Footer* block = (Footer*) (bytes + alignedNumBytes);
+    new (block) Footer; // Construct in-place
+    block->bytes = bytes;
+    block->blockSize = numBytes;
+    return block;
+}
+
+PLY_NO_INLINE ConcurrentBlockList::ConcurrentBlockList() {
+    this->head = createBlock(DefaultBlockSize);
+    this->tail.storeNonatomic(this->head);
+}
+
+PLY_NO_INLINE ConcurrentBlockList::~ConcurrentBlockList() {
+    Footer* block = this->head;
+    while (block) {
+        Footer* nextBlock = block->nextBlock.loadNonatomic();
+        // Footer is trivially destructible, and freeing the block data also frees the footer.
+        PLY_HEAP.free(block->bytes);
+        block = nextBlock;
+    }
+}
+
+PLY_NO_INLINE ConcurrentBlockList::Reservation ConcurrentBlockList::beginWrite(u32 numBytes) {
+    // Failed reservations still bump the counter, so keep records well below 4GB to rule out
+    // overflow.
+    PLY_ASSERT(numBytes > 0 && numBytes < (1u << 30));
+    Footer* block = this->tail.load(Acquire);
+    for (;;) {
+        // Skip the atomic increment if the block is already sealed.
+        if (block->numBytesReserved.load(Relaxed) <= block->blockSize) {
+            u32 offset = block->numBytesReserved.fetchAdd(numBytes, Relaxed);
+            if (offset + numBytes <= block->blockSize)
+                return {block, block->bytes + offset, numBytes};
+            if (offset <= block->blockSize) {
+                // This is the first reservation that didn't fit, so the block is now sealed. Every
+                // reservation before this one succeeded.
+                block->numBytesSealed.store(offset, Release);
+            }
+        }
+
+        // Move on to the next block, creating it if necessary.
+        Footer* nextBlock = block->nextBlock.load(Acquire);
+        if (!nextBlock) {
+            // Reserve the new block's first bytes before publishing it.
+            Footer* newBlock = createBlock(max(DefaultBlockSize, numBytes));
+            newBlock->numBytesReserved.storeNonatomic(numBytes);
+            if (block->nextBlock.compareExchangeStrong(nextBlock, newBlock, AcquireRelease)) {
+                Footer* expectedTail = block;
+                this->tail.compareExchangeStrong(expectedTail, newBlock, Release);
+                return {newBlock, newBlock->bytes, numBytes};
+            }
+            // Another thread linked a block first. nextBlock now holds that block.
+            PLY_HEAP.free(newBlock->bytes);
+        }
+        // Help advance the tail in case the thread that linked nextBlock hasn't done it yet.
+        Footer* expectedTail = block;
+        this->tail.compareExchangeStrong(expectedTail, nextBlock, Release);
+        block = nextBlock;
+    }
+}
+
+PLY_NO_INLINE String ConcurrentBlockList::toString() const {
+    MemOutStream mout;
+    Reader reader = this->createReader();
+    for (;;) {
+        StringView view = reader.read();
+        if (view.isEmpty())
+            break;
+        mout.write(view);
+    }
+    return mout.moveToString();
+}
+
+} // namespace ply
@@ -0,0 +1,131 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/string/String.h>
+#include <ply-runtime/thread/Atomic.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+A `ConcurrentBlockList` is an append-only list of memory blocks that multiple threads can write to
+at the same time without taking a lock. It's meant for collecting output such as log lines, trace
+events or result records from many worker threads into a single buffer.
+
+Each writer reserves space in the current tail block by atomically bumping the block's reservation
+counter. When a reservation doesn't fit, the block is sealed and a new block is chained after it
+with a compare-and-swap; threads that lose the race free their block and use the winner's. Once a
+write is finished, the writer adds the number of bytes written to the block's commit counter.
+
+Readers only see completed data. A block is completed once it's sealed and all of its reservations
+have been committed. The tail block can also be read up to its current reservation point at any
+moment when none of its reservations are outstanding.
+
+Blocks are never freed or moved until the `ConcurrentBlockList` is destroyed, so pointers returned
+by `beginWrite()` remain valid for the lifetime of the list.
+*/
+struct ConcurrentBlockList {
+    static const u32 DefaultBlockSize = 2048;
+    static const u32 NotSealed = u32(-1);
+
+    //--------------------------------------
+    // As with BlockList, the block footer is located contiguously in memory immediately following
+    // the block data.
+    //--------------------------------------
+    struct Footer {
+        Atomic<u32> numBytesReserved = 0;  // Can exceed blockSize after the block is sealed
+        Atomic<u32> numBytesCommitted = 0; // Number of reserved bytes that have been written
+        Atomic<u32> numBytesSealed = NotSealed;
+        Atomic<Footer*> nextBlock = nullptr;
+        char* bytes = nullptr;
+        u32 blockSize = 0;
+
+        // Returns the number of bytes at the start of the block that are safe to read. If
+        // isComplete is not null, it's set to true when no more bytes will ever be added to this
+        // block.
+        PLY_DLL_ENTRY u32 getNumCompletedBytes(bool* isComplete = nullptr) const;
+    };
+
+    //--------------------------------------
+    // Reservation
+    //--------------------------------------
+    struct Reservation {
+        Footer* block = nullptr;
+        char* bytes = nullptr;
+        u32 numBytes = 0;
+    };
+
+    //--------------------------------------
+    // Reader
+    //--------------------------------------
+    struct Reader {
+        const Footer* block = nullptr;
+        u32 offset = 0;
+
+        PLY_INLINE Reader(const Footer* block) : block{block} {
+        }
+        // Returns the next contiguous view of completed bytes, or an empty view if no more
+        // completed bytes are available yet. It's legal to call read() again later to pick up data
+        // committed in the meantime.
+        PLY_DLL_ENTRY StringView read();
+    };
+
+    Footer* head = nullptr;
+    Atomic<Footer*> tail = nullptr;
+
+    static PLY_DLL_ENTRY Footer* createBlock(u32 numBytes);
+
+    /*!
+    Constructs an empty `ConcurrentBlockList`.
+    */
+    PLY_DLL_ENTRY ConcurrentBlockList();
+
+    /*!
+    Frees all blocks. There must be no writers or readers still using the list.
+    */
+    PLY_DLL_ENTRY ~ConcurrentBlockList();
+
+    /*!
+    Reserves `numBytes` contiguous bytes. The caller must write to `Reservation::bytes`, then pass
+    the reservation to `endWrite()`. Reservations never span two blocks; when a reservation doesn't
+    fit in the rest of the current block, the remaining bytes in that block are skipped. Safe to
+    call from any number of threads at the same time.
+    */
+    PLY_DLL_ENTRY Reservation beginWrite(u32 numBytes);
+
+    /*!
+    Marks a reservation as written, making it visible to readers once the rest of its block is
+    complete.
+    */
+    static PLY_INLINE void endWrite(const Reservation& res) {
+        res.block->numBytesCommitted.fetchAdd(res.numBytes, Release);
+    }
+
+    /*!
+    Copies `bytes` into the list as a single contiguous record. Safe to call from any number of
+    threads at the same time.
+    */
+    PLY_INLINE void append(StringView bytes) {
+        Reservation res = this->beginWrite(bytes.numBytes);
+        memcpy(res.bytes, bytes.bytes, bytes.numBytes);
+        endWrite(res);
+    }
+
+    /*!
+    Returns a `Reader` positioned at the start of the list. Readers can run concurrently with
+    writers.
+    */
+    PLY_INLINE Reader createReader() const {
+        return {this->head};
+    }
+
+    /*!
+    Returns a copy of all the bytes that are currently completed.
+    */
+    PLY_DLL_ENTRY String toString() const;
+};
+
+} // namespace ply
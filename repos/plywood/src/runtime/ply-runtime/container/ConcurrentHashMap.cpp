@@ -0,0 +1,451 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/container/ConcurrentHashMap.h>
+
+namespace ply {
+namespace details {
+
+enum class InsertResult {
+    InsertedNew,
+    AlreadyFound,
+    Overflow,
+};
+
+//------------------------------------------------------------------
+// Cell-level operations
+//------------------------------------------------------------------
+static PLY_NO_INLINE ConcurrentHashMap::Cell* findCell(ConcurrentHashMap::Table* table, uptr key,
+                                                      u32 hash) {
+    PLY_ASSERT(key != ConcurrentHashMap::NullKey);
+    u32 sizeMask = table->sizeMask;
+    u32 idx = hash & sizeMask;
+
+    // Check hashed cell first, though it may not even belong to the bucket.
+    ConcurrentHashMap::CellGroup* group = table->getCellGroups() + (idx >> 2);
+    ConcurrentHashMap::Cell* cell = group->cells + (idx & 3);
+    uptr probeKey = cell->key.load(Relaxed);
+    if (probeKey == key)
+        return cell;
+    // Keys are never removed from a table, so if the hashed cell is unused, the bucket is empty.
+    if (probeKey == ConcurrentHashMap::NullKey)
+        return nullptr;
+
+    // Follow probe chain for our bucket.
+    u8 delta = group->deltas[idx & 3].load(Relaxed);
+    while (delta) {
+        idx = (idx + delta) & sizeMask;
+        group = table->getCellGroups() + (idx >> 2);
+        cell = group->cells + (idx & 3);
+        // A cell can be linked before its key becomes visible to this thread. In that case, the
+        // key can't match, and the cell's next delta is still zero.
+        probeKey = cell->key.load(Relaxed);
+        if (probeKey == key)
+            return cell;
+        delta = group->deltas[(idx & 3) + 4].load(Relaxed);
+    }
+
+    // End of probe chain, not found
+    return nullptr;
+}
+
+static PLY_NO_INLINE InsertResult insertOrFindCell(const ConcurrentHashMap::Callbacks* cb,
+                                                   ConcurrentHashMap::Table* table, uptr key,
+                                                   u32 hash, ConcurrentHashMap::Cell*& cell,
+                                                   u32& overflowIdx) {
+    PLY_ASSERT(key != ConcurrentHashMap::NullKey);
+    u32 sizeMask = table->sizeMask;
+    u32 idx = hash;
+
+    // Check hashed cell first, though it may not even belong to the bucket.
+    ConcurrentHashMap::CellGroup* group = table->getCellGroups() + ((idx & sizeMask) >> 2);
+    cell = group->cells + (idx & 3);
+    uptr probeKey = cell->key.load(Relaxed);
+    if (probeKey == ConcurrentHashMap::NullKey) {
+        // Try to reserve the first cell.
+        if (cell->key.compareExchangeStrong(probeKey, key, Relaxed))
+            return InsertResult::InsertedNew;
+        // Lost the race. probeKey now holds the key that was written by the other thread.
+    }
+    if (probeKey == key)
+        return InsertResult::AlreadyFound;
+
+    // Follow probe chain for our bucket.
+    u32 maxIdx = idx + sizeMask;
+    u32 linkLevel = 0;
+    Atomic<u8>* prevLink;
+    for (;;) {
+    followLink:
+        prevLink = group->deltas + ((idx & 3) + linkLevel);
+        linkLevel = 4;
+        u8 probeDelta = prevLink->load(Relaxed);
+        if (probeDelta) {
+            idx += probeDelta;
+            group = table->getCellGroups() + ((idx & sizeMask) >> 2);
+            cell = group->cells + (idx & 3);
+            probeKey = cell->key.load(Relaxed);
+            if (probeKey == ConcurrentHashMap::NullKey) {
+                // The cell was linked, but its key isn't visible to this thread yet. Wait for it,
+                // since it might be the key we're looking for.
+                do {
+                    ply_yieldHWThread();
+                    probeKey = cell->key.load(Acquire);
+                } while (probeKey == ConcurrentHashMap::NullKey);
+            }
+            if (probeKey == key)
+                return InsertResult::AlreadyFound;
+        } else {
+            // Reached the end of the link chain for this bucket.
+            // Switch to linear probing until we reserve a new cell or find a late-arriving cell in
+            // the same bucket.
+            u32 prevLinkIdx = idx;
+            PLY_ASSERT(maxIdx - idx <= sizeMask);
+            u32 linearProbesRemaining = min(maxIdx - idx, ConcurrentHashMap::LinearSearchLimit);
+            while (linearProbesRemaining-- > 0) {
+                idx++;
+                group = table->getCellGroups() + ((idx & sizeMask) >> 2);
+                cell = group->cells + (idx & 3);
+                probeKey = cell->key.load(Relaxed);
+                if (probeKey == ConcurrentHashMap::NullKey) {
+                    // It's an empty cell. Try to reserve it.
+                    if (cell->key.compareExchangeStrong(probeKey, key, Relaxed)) {
+                        // Link it to previous cell in the same bucket.
+                        prevLink->store(u8(idx - prevLinkIdx), Relaxed);
+                        return InsertResult::InsertedNew;
+                    }
+                    // Lost the race. Fall through to check if it's the same key...
+                }
+                if (probeKey == key || ((cb->hash(probeKey) ^ hash) & sizeMask) == 0) {
+                    // Found a late-arriving cell in the same bucket. Set the link on its behalf,
+                    // since there's no guarantee that the other thread has done so yet. This
+                    // applies even when the cell holds our own key; otherwise, find() could miss
+                    // a key that insertOrFind() just reported as present.
+                    prevLink->store(u8(idx - prevLinkIdx), Relaxed);
+                    if (probeKey == key)
+                        return InsertResult::AlreadyFound;
+                    // Follow the link chain from there.
+                    goto followLink;
+                }
+                // Continue linear search...
+            }
+
+            // Table is too full to insert.
+            overflowIdx = idx + 1;
+            return InsertResult::Overflow;
+        }
+    }
+}
+
+// Returns false if the destination table overflowed. In that case, the cell that didn't fit, and
+// the rest of the range, are left in the source table.
+static PLY_NO_INLINE bool migrateRange(const ConcurrentHashMap::Callbacks* cb,
+                                       ConcurrentHashMap::Table* srcTable,
+                                       ConcurrentHashMap::Table* dstTable, u32 startIdx,
+                                       u32 endIdx) {
+    for (u32 srcIdx = startIdx; srcIdx < endIdx; srcIdx++) {
+        ConcurrentHashMap::CellGroup* srcGroup = srcTable->getCellGroups() + (srcIdx >> 2);
+        ConcurrentHashMap::Cell* srcCell = srcGroup->cells + (srcIdx & 3);
+        for (;;) {
+            uptr srcKey = srcCell->key.load(Relaxed);
+            uptr srcValue = ConcurrentHashMap::NullValue;
+            if (srcKey == ConcurrentHashMap::NullKey) {
+                // An unused cell. Put a Redirect marker in its value so that nobody can use it.
+                if (srcCell->value.compareExchangeStrong(srcValue, ConcurrentHashMap::Redirect,
+                                                         Relaxed))
+                    break;
+                // Somebody just reserved the cell and stored a value, or an earlier attempt at
+                // this migration already marked it. Read the key again.
+                if (srcValue == ConcurrentHashMap::Redirect)
+                    break;
+                continue;
+            }
+
+            srcValue = srcCell->value.load(Acquire);
+            if (srcValue == ConcurrentHashMap::Redirect) {
+                // An earlier attempt at this migration already moved the cell to its destination,
+                // which is now another source.
+                break;
+            }
+            if (srcValue == ConcurrentHashMap::NullValue) {
+                // The key was reserved or erased, but has no value. Try to put a Redirect marker.
+                if (srcCell->value.compareExchangeStrong(srcValue, ConcurrentHashMap::Redirect,
+                                                         Acquire))
+                    break;
+                // A value arrived late. Migrate it.
+            }
+            PLY_ASSERT(srcValue != ConcurrentHashMap::Redirect); // Each unit has one migrator
+
+            // Reserve a cell in the destination. A key is live in only one source cell and is only
+            // migrated by one thread, so it can't already be there.
+            ConcurrentHashMap::Cell* dstCell = nullptr;
+            u32 overflowIdx = 0;
+            InsertResult result =
+                insertOrFindCell(cb, dstTable, srcKey, cb->hash(srcKey), dstCell, overflowIdx);
+            PLY_ASSERT(result != InsertResult::AlreadyFound);
+            if (result == InsertResult::Overflow) {
+                // There is a range of sequential cells that is too full to insert. This may
+                // happen if the hash function doesn't distribute keys uniformly enough. Leave the
+                // cell live so that the migration can be restarted with a larger destination.
+                return false;
+            }
+
+            for (;;) {
+                dstCell->value.store(srcValue, Relaxed);
+                // Try to place a Redirect marker in the source cell.
+                uptr doubleChecked = srcValue;
+                if (srcCell->value.compareExchangeStrong(doubleChecked, ConcurrentHashMap::Redirect,
+                                                         Acquire))
+                    break;
+                // There was a late-arriving write (or erase) to the source cell. Migrate the new
+                // value and try again.
+                PLY_ASSERT(doubleChecked != ConcurrentHashMap::Redirect);
+                srcValue = doubleChecked;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+// ConcurrentHashMap
+//------------------------------------------------------------------
+PLY_NO_INLINE ConcurrentHashMap::ConcurrentHashMap(u32 initialSize)
+    : m_root{createTable(initialSize)}, m_retired{nullptr} {
+}
+
+PLY_NO_INLINE ConcurrentHashMap::~ConcurrentHashMap() {
+    destroyTable(m_root.loadNonatomic());
+    Table* table = m_retired.loadNonatomic();
+    while (table) {
+        Table* next = table->nextRetired;
+        destroyTable(table);
+        table = next;
+    }
+}
+
+PLY_NO_INLINE ConcurrentHashMap::Table* ConcurrentHashMap::createTable(u32 size) {
+    PLY_ASSERT(size >= 4 && isPowerOf2(size));
+    u32 numGroups = size >> 2;
+    Table* table = (Table*) PLY_HEAP.alloc(sizeof(Table) + sizeof(CellGroup) * numGroups);
+    table->sizeMask = size - 1;
+    table->migration.storeNonatomic(nullptr);
+    table->nextRetired = nullptr;
+    // Zero means no delta, NullKey and NullValue. Atomic<T> has the same representation as T, and
+    // nothing else can access the cells yet, so it's safe to clear them as raw memory:
+    memset((void*) table->getCellGroups(), 0, sizeof(CellGroup) * numGroups);
+    return table;
+}
+
+PLY_NO_INLINE void ConcurrentHashMap::destroyTable(Table* table) {
+    PLY_ASSERT(table);
+    Migration* migration = table->migration.loadNonatomic();
+    while (migration) {
+        Migration* prevAttempt = migration->prevAttempt;
+        PLY_HEAP.free(migration);
+        migration = prevAttempt;
+    }
+    PLY_HEAP.free(table);
+}
+
+PLY_NO_INLINE ConcurrentHashMap::Migration*
+ConcurrentHashMap::createMigration(Table* source, Migration* prevAttempt, u32 dstSize) {
+    u32 numSources = prevAttempt ? prevAttempt->numSources + 1 : 1;
+    Migration* migration =
+        (Migration*) PLY_HEAP.alloc(sizeof(Migration) + sizeof(Table*) * numSources);
+    migration->destination = createTable(dstSize);
+    migration->prevAttempt = prevAttempt;
+    migration->numSources = numSources;
+    Table** sources = migration->getSources();
+    if (prevAttempt) {
+        memcpy(sources, prevAttempt->getSources(), sizeof(Table*) * prevAttempt->numSources);
+        sources[prevAttempt->numSources] = prevAttempt->destination;
+    } else {
+        sources[0] = source;
+    }
+    u32 numUnits = 0;
+    for (u32 s = 0; s < numSources; s++) {
+        numUnits += (sources[s]->sizeMask + MigrationUnitSize) / MigrationUnitSize;
+    }
+    migration->numUnits = numUnits;
+    migration->nextUnit.storeNonatomic(0);
+    migration->unitsRemaining.storeNonatomic(numUnits);
+    migration->overflowed.storeNonatomic(0);
+    migration->isComplete.storeNonatomic(0);
+    return migration;
+}
+
+PLY_NO_INLINE void ConcurrentHashMap::retireTable(Table* table) {
+    Table* head = m_retired.load(Relaxed);
+    do {
+        table->nextRetired = head;
+    } while (!m_retired.compareExchangeWeak(head, table, Release, Relaxed));
+}
+
+PLY_NO_INLINE void ConcurrentHashMap::participateInMigration(const Callbacks* cb, Table* table,
+                                                             u32 overflowIdx) {
+    u32 srcSize = table->sizeMask + 1;
+    Migration* migration = table->migration.load(Acquire);
+    if (!migration) {
+        // This thread overflowed the table, and nobody has started a migration yet.
+        // Estimate the number of cells in use by sampling the cells that were just probed.
+        u32 sampleSize = min(srcSize, LinearSearchLimit);
+        u32 inUseCells = 0;
+        for (u32 idx = overflowIdx - sampleSize; idx != overflowIdx; idx++) {
+            CellGroup* group = table->getCellGroups() + ((idx & table->sizeMask) >> 2);
+            uptr value = group->cells[idx & 3].value.load(Relaxed);
+            if (value != NullValue && value != Redirect) {
+                inUseCells++;
+            }
+        }
+        u32 estimatedPopulation = u32(u64(inUseCells) * srcSize / sampleSize);
+        u32 dstSize = max(srcSize, roundUpPowerOf2(estimatedPopulation * 2));
+
+        Migration* newMigration = createMigration(table, nullptr, dstSize);
+        if (table->migration.compareExchangeStrong(migration, newMigration, AcquireRelease)) {
+            migration = newMigration;
+        } else {
+            // Another thread started the migration first. Join it instead.
+            destroyTable(newMigration->destination);
+            PLY_HEAP.free(newMigration);
+        }
+    }
+
+    for (;;) {
+        // Migrate units of cells until there are none left to claim.
+        for (;;) {
+            u32 unit = migration->nextUnit.fetchAdd(1, Relaxed);
+            if (unit >= migration->numUnits)
+                break;
+            // Find the source table that contains this unit.
+            Table* source = nullptr;
+            for (u32 s = 0;; s++) {
+                source = migration->getSources()[s];
+                u32 numSourceUnits = (source->sizeMask + MigrationUnitSize) / MigrationUnitSize;
+                if (unit < numSourceUnits)
+                    break;
+                unit -= numSourceUnits;
+            }
+            u32 startIdx = unit * MigrationUnitSize;
+            u32 endIdx = min(startIdx + MigrationUnitSize, source->sizeMask + 1);
+            if (!migrateRange(cb, source, migration->destination, startIdx, endIdx)) {
+                migration->overflowed.store(1, Relaxed);
+            }
+            if (migration->unitsRemaining.fetchSub(1, AcquireRelease) == 1) {
+                // This thread finished the last unit.
+                if (migration->overflowed.load(Relaxed)) {
+                    // The destination overflowed. Nobody else can access it now, so restart the
+                    // migration with a destination twice as large, and migrate the overflowed
+                    // destination's cells along with the cells that remain in the sources.
+                    Migration* retry = createMigration(
+                        table, migration, (migration->destination->sizeMask + 1) * 2);
+                    table->migration.store(retry, Release);
+                } else {
+                    // Publish the destination table.
+                    PLY_ASSERT(m_root.load(Relaxed) == table);
+                    m_root.store(migration->destination, Release);
+                    for (u32 s = 0; s < migration->numSources; s++) {
+                        retireTable(migration->getSources()[s]);
+                    }
+                }
+                migration->isComplete.store(1, Release);
+            }
+        }
+
+        // Wait for any units claimed by other threads to finish.
+        while (!migration->isComplete.load(Acquire)) {
+            ply_yieldHWThread();
+        }
+        Migration* retry = table->migration.load(Acquire);
+        if (retry == migration)
+            break;
+        // The migration was restarted. Participate in the new attempt.
+        migration = retry;
+    }
+}
+
+PLY_NO_INLINE uptr ConcurrentHashMap::find(const Callbacks* cb, uptr key) const {
+    u32 hash = cb->hash(key);
+    for (;;) {
+        Table* table = m_root.load(Acquire);
+        Cell* cell = findCell(table, key, hash);
+        if (!cell)
+            return NullValue;
+        uptr value = cell->value.load(Acquire);
+        if (value != Redirect)
+            return value;
+        // The cell was migrated. Help finish the migration and try again in the new table.
+        const_cast<ConcurrentHashMap*>(this)->participateInMigration(cb, table, 0);
+    }
+}
+
+PLY_NO_INLINE uptr ConcurrentHashMap::insertOrFind(const Callbacks* cb, uptr key, uptr desired) {
+    PLY_ASSERT(desired != NullValue && desired != Redirect);
+    u32 hash = cb->hash(key);
+    for (;;) {
+        Table* table = m_root.load(Acquire);
+        Cell* cell = nullptr;
+        u32 overflowIdx = 0;
+        if (insertOrFindCell(cb, table, key, hash, cell, overflowIdx) == InsertResult::Overflow) {
+            participateInMigration(cb, table, overflowIdx);
+            continue;
+        }
+        uptr value = cell->value.load(Acquire);
+        for (;;) {
+            if (value == Redirect)
+                break;
+            if (value != NullValue)
+                return value;
+            if (cell->value.compareExchangeWeak(value, desired, AcquireRelease, Acquire))
+                return desired;
+        }
+        participateInMigration(cb, table, 0);
+    }
+}
+
+PLY_NO_INLINE uptr ConcurrentHashMap::exchange(const Callbacks* cb, uptr key, uptr desired) {
+    PLY_ASSERT(desired != NullValue && desired != Redirect);
+    u32 hash = cb->hash(key);
+    for (;;) {
+        Table* table = m_root.load(Acquire);
+        Cell* cell = nullptr;
+        u32 overflowIdx = 0;
+        if (insertOrFindCell(cb, table, key, hash, cell, overflowIdx) == InsertResult::Overflow) {
+            participateInMigration(cb, table, overflowIdx);
+            continue;
+        }
+        uptr value = cell->value.load(Relaxed);
+        for (;;) {
+            if (value == Redirect)
+                break;
+            if (cell->value.compareExchangeWeak(value, desired, AcquireRelease, Relaxed))
+                return value;
+        }
+        participateInMigration(cb, table, 0);
+    }
+}
+
+PLY_NO_INLINE uptr ConcurrentHashMap::erase(const Callbacks* cb, uptr key) {
+    u32 hash = cb->hash(key);
+    for (;;) {
+        Table* table = m_root.load(Acquire);
+        Cell* cell = findCell(table, key, hash);
+        if (!cell)
+            return NullValue;
+        uptr value = cell->value.load(Relaxed);
+        for (;;) {
+            if (value == Redirect)
+                break;
+            if (value == NullValue)
+                return NullValue;
+            if (cell->value.compareExchangeWeak(value, NullValue, AcquireRelease, Relaxed))
+                return value;
+        }
+        participateInMigration(cb, table, 0);
+    }
+}
+
+} // namespace details
+} // namespace ply
@@ -0,0 +1,224 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/container/HashMap.h>
+#include <ply-runtime/thread/Atomic.h>
+#include <string.h>
+
+namespace ply {
+
+//------------------------------------------------------------------
+// details::ConcurrentHashMap
+//------------------------------------------------------------------
+namespace details {
+struct ConcurrentHashMap {
+    static constexpr u32 InitialSize = 8;
+    static constexpr u32 LinearSearchLimit = 128;
+    static constexpr u32 MigrationUnitSize = 32;
+    // Reserved words. Keys must never be NullKey; values must never be NullValue or Redirect.
+    static constexpr uptr NullKey = 0;
+    static constexpr uptr NullValue = 0;
+    static constexpr uptr Redirect = 1;
+
+    PLY_STATIC_ASSERT(LinearSearchLimit > 0 &&
+                      LinearSearchLimit < 256); // Must fit in CellGroup::deltas
+
+    struct Callbacks {
+        u32 (*hash)(uptr key) = nullptr;
+    };
+
+    template <class Traits>
+    struct CallbackMaker {
+        using Key = typename Traits::Key;
+
+        template <typename U = Traits, std::enable_if_t<HashMap::HasHash<U>, int> = 0>
+        static PLY_NO_INLINE u32 hash(uptr key) {
+            return Traits::hash(fromWord<Key>(key));
+        }
+        template <typename U = Traits, std::enable_if_t<!HashMap::HasHash<U>, int> = 0>
+        static PLY_NO_INLINE u32 hash(uptr key) {
+            return Hasher::hash(fromWord<Key>(key));
+        }
+
+        static PLY_INLINE const Callbacks* instance() {
+            static Callbacks ins = {&hash};
+            return &ins;
+        }
+    };
+
+    // Keys and values are stored as machine words.
+    template <typename T>
+    static PLY_INLINE uptr toWord(const T& value) {
+        PLY_STATIC_ASSERT(sizeof(T) <= sizeof(uptr));
+        PLY_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+        uptr word = 0;
+        memcpy(&word, &value, sizeof(T));
+        return word;
+    }
+    template <typename T>
+    static PLY_INLINE T fromWord(uptr word) {
+        T value;
+        memcpy(&value, &word, sizeof(T));
+        return value;
+    }
+
+    struct Cell {
+        Atomic<uptr> key;
+        Atomic<uptr> value;
+    };
+
+    // Same leapfrog layout as details::HashMap::CellGroup, except that every field is atomic.
+    // deltas[0..3] are the first deltas and deltas[4..7] are the next deltas.
+    struct CellGroup {
+        Atomic<u8> deltas[8];
+        Cell cells[4];
+    };
+
+    struct Table;
+
+    // If the destination overflows, the migration is restarted with a destination twice as large,
+    // and the overflowed destination becomes an additional source. The new Migration replaces the
+    // old one in the first source's migration pointer and keeps it alive through prevAttempt.
+    struct Migration {
+        Table* destination;
+        Migration* prevAttempt;
+        u32 numSources;
+        u32 numUnits;
+        Atomic<u32> nextUnit;
+        Atomic<u32> unitsRemaining;
+        Atomic<u32> overflowed;
+        Atomic<u32> isComplete;
+        // Source tables follow. The first one is the table being replaced.
+
+        PLY_INLINE Table** getSources() {
+            return (Table**) (this + 1);
+        }
+    };
+
+    struct Table {
+        u32 sizeMask;
+        Atomic<Migration*> migration;
+        Table* nextRetired; // Written only once the table is unreachable from m_root
+        // CellGroups follow
+
+        PLY_INLINE CellGroup* getCellGroups() {
+            return (CellGroup*) (this + 1);
+        }
+    };
+
+    Atomic<Table*> m_root;
+    Atomic<Table*> m_retired;
+
+    PLY_DLL_ENTRY ConcurrentHashMap(u32 initialSize);
+    PLY_DLL_ENTRY ~ConcurrentHashMap();
+    static PLY_DLL_ENTRY Table* createTable(u32 size);
+    static PLY_DLL_ENTRY void destroyTable(Table* table);
+    static PLY_DLL_ENTRY Migration* createMigration(Table* source, Migration* prevAttempt,
+                                                    u32 dstSize);
+    PLY_DLL_ENTRY void retireTable(Table* table);
+    PLY_DLL_ENTRY void participateInMigration(const Callbacks* cb, Table* table,
+                                              u32 overflowIdx);
+    PLY_DLL_ENTRY uptr find(const Callbacks* cb, uptr key) const;
+    PLY_DLL_ENTRY uptr insertOrFind(const Callbacks* cb, uptr key, uptr desired);
+    PLY_DLL_ENTRY uptr exchange(const Callbacks* cb, uptr key, uptr desired);
+    PLY_DLL_ENTRY uptr erase(const Callbacks* cb, uptr key);
+};
+} // namespace details
+
+//------------------------------------------------------------------------------------------------
+/*!
+A concurrent map from keys to values that can be shared between threads without any external
+locking.
+
+`ConcurrentHashMap` uses the same [leapfrog probing](https://preshing.com/20160314/leapfrog-probing/)
+layout as `HashMap`, but every cell is manipulated using atomic operations:
+
+* `find()` is wait-free unless it happens to land on a cell that's being migrated to a larger
+  table, in which case it helps finish the migration and retries.
+* `insertOrFind()`, `exchange()` and `erase()` are lock-free.
+* When the table runs out of room, every thread that touches the table cooperatively migrates its
+  contents to a new table, one block of cells at a time.
+
+Keys and values are stored directly in the cells as machine words, so both `Key` and `Value` must
+be trivially copyable and no larger than a pointer. A zero key is reserved, and the zero and one
+values are reserved; in practice, this means that `Key` and `Value` are typically non-null
+pointers, nonzero integers or `Label`s. `erase()` leaves the key in the table and only clears its
+value.
+
+Tables that have been replaced by a migration remain allocated until the `ConcurrentHashMap` is
+destroyed, since other threads might still be reading them. Because tables grow geometrically, this
+at most doubles the memory used by the map.
+
+`Traits` must define `Key` and `Value` types and can optionally define a static `hash` function.
+*/
+template <class Traits>
+class ConcurrentHashMap {
+private:
+    using Key = typename Traits::Key;
+    using Value = typename Traits::Value;
+    using Callbacks = details::ConcurrentHashMap::CallbackMaker<Traits>;
+
+    details::ConcurrentHashMap m_map;
+
+    static PLY_INLINE uptr keyToWord(const Key& key) {
+        uptr word = details::ConcurrentHashMap::toWord(key);
+        PLY_ASSERT(word != details::ConcurrentHashMap::NullKey);
+        return word;
+    }
+    static PLY_INLINE uptr valueToWord(const Value& value) {
+        uptr word = details::ConcurrentHashMap::toWord(value);
+        PLY_ASSERT(word != details::ConcurrentHashMap::NullValue &&
+                   word != details::ConcurrentHashMap::Redirect);
+        return word;
+    }
+    static PLY_INLINE Value toValue(uptr word) {
+        return details::ConcurrentHashMap::fromWord<Value>(word);
+    }
+
+public:
+    /*!
+    Constructs an empty `ConcurrentHashMap`. `initialSize` must be a power of 2.
+    */
+    PLY_INLINE ConcurrentHashMap(u32 initialSize = details::ConcurrentHashMap::InitialSize)
+        : m_map{initialSize} {
+    }
+
+    /*!
+    Returns the `Value` associated with `key`, or a zero-initialized `Value` if there is none.
+    */
+    PLY_INLINE Value find(const Key& key) const {
+        return toValue(m_map.find(Callbacks::instance(), keyToWord(key)));
+    }
+
+    /*!
+    If `key` is already in the map, returns its existing `Value`. Otherwise, associates `key` with
+    `desired` and returns `desired`. When several threads race to insert the same key, exactly one
+    of them succeeds and all of them return the same `Value`.
+    */
+    PLY_INLINE Value insertOrFind(const Key& key, const Value& desired) {
+        return toValue(
+            m_map.insertOrFind(Callbacks::instance(), keyToWord(key), valueToWord(desired)));
+    }
+
+    /*!
+    Associates `key` with `desired` and returns the previous `Value`, or a zero-initialized `Value`
+    if there was none.
+    */
+    PLY_INLINE Value exchange(const Key& key, const Value& desired) {
+        return toValue(
+            m_map.exchange(Callbacks::instance(), keyToWord(key), valueToWord(desired)));
+    }
+
+    /*!
+    Removes the `Value` associated with `key` and returns it, or returns a zero-initialized `Value`
+    if there was none.
+    */
+    PLY_INLINE Value erase(const Key& key) {
+        return toValue(m_map.erase(Callbacks::instance(), keyToWord(key)));
+    }
+};
+
+} // namespace ply
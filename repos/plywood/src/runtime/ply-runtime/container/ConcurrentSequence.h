@@ -0,0 +1,113 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/container/ConcurrentBlockList.h>
+#include <ply-runtime/container/Array.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+A `ConcurrentSequence` is a multi-producer counterpart to `Sequence`. Any number of threads can
+append items at the same time without taking a lock, and the address of an item never changes once
+it's added. Readers created with `createReader()` can run concurrently with writers and see each
+item only once its block is complete; see `ConcurrentBlockList` for details.
+
+Items can't be removed individually. They are destructed when the `ConcurrentSequence` is
+destroyed, at which point no other thread may still be appending.
+*/
+template <typename T>
+class ConcurrentSequence {
+private:
+    ConcurrentBlockList blockList;
+
+public:
+    //--------------------------------------
+    // Reader
+    //--------------------------------------
+    class Reader {
+    private:
+        friend class ConcurrentSequence;
+        ConcurrentBlockList::Reader impl;
+
+        PLY_INLINE Reader(const ConcurrentBlockList::Reader& impl) : impl{impl} {
+        }
+
+    public:
+        /*!
+        Returns the next contiguous run of completed items, or an empty view if there are none yet.
+        */
+        PLY_INLINE ArrayView<const T> read() {
+            // Every reservation has size sizeof(T), so each view contains a whole number of items.
+            return ArrayView<T>::from(this->impl.read());
+        }
+    };
+
+    /*!
+    \category Constructors
+    Constructs an empty `ConcurrentSequence`.
+    */
+    PLY_INLINE ConcurrentSequence() = default;
+
+    /*!
+    Destructor. Destructs all items and frees the memory associated with the `ConcurrentSequence`.
+    */
+    PLY_INLINE ~ConcurrentSequence() {
+        Reader reader = this->createReader();
+        for (;;) {
+            ArrayView<const T> view = reader.read();
+            if (view.isEmpty())
+                break;
+            subst::destructViewAs<T>(view.stringView());
+        }
+    }
+
+    /*!
+    \category Modification
+    Appends a single item to the sequence and returns a reference to it. The arguments are
+    forwarded directly to the item's constructor. Safe to call from any number of threads at the
+    same time.
+    */
+    template <typename... Args>
+    PLY_INLINE T& append(Args&&... args) {
+        ConcurrentBlockList::Reservation res = this->blockList.beginWrite(sizeof(T));
+        T* result = (T*) res.bytes;
+        new (result) T{std::forward<Args>(args)...};
+        ConcurrentBlockList::endWrite(res);
+        return *result;
+    }
+
+    /*!
+    \category Iteration
+    Returns a `Reader` positioned at the first item.
+
+        auto reader = seq.createReader();
+        while (ArrayView<const T> items = reader.read()) {
+            ...
+        }
+    */
+    PLY_INLINE Reader createReader() const {
+        return {this->blockList.createReader()};
+    }
+
+    /*!
+    \category Conversion
+    Copies all completed items to an `Array`.
+    */
+    PLY_INLINE Array<T> copyToArray() const {
+        Array<T> result;
+        Reader reader = this->createReader();
+        for (;;) {
+            ArrayView<const T> view = reader.read();
+            if (view.isEmpty())
+                break;
+            result.extend(view);
+        }
+        return result;
+    }
+};
+
+} // namespace ply
@@ -0,0 +1,296 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/container/FlatHashMap.h>
+#include <string.h>
+#if PLY_CPU_X86 || PLY_CPU_X64
+#define PLY_FLATHASHMAP_SSE2 1
+#include <emmintrin.h>
+#elif PLY_CPU_ARM64
+#define PLY_FLATHASHMAP_NEON 1
+#include <arm_neon.h>
+#endif
+#if PLY_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace ply {
+namespace details {
+
+//------------------------------------------------------------------
+// Group
+//
+// Matches a value against 16 control bytes at once and returns a bitmask with one bit per matching
+// slot. With SSE2, slot i corresponds to bit i. With NEON, there's no movemask instruction, so each
+// slot gets 4 bits of the mask instead; only the highest of those is kept, and SlotShift converts
+// bit indices back to slot indices.
+//------------------------------------------------------------------
+using GroupMask = u64;
+
+struct Group {
+#if PLY_FLATHASHMAP_SSE2
+    static constexpr u32 SlotShift = 0;
+    __m128i ctrl;
+
+    PLY_INLINE Group(const u8* ctrl) : ctrl{_mm_loadu_si128((const __m128i*) ctrl)} {
+    }
+    PLY_INLINE GroupMask match(u8 value) const {
+        return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(this->ctrl, _mm_set1_epi8((char) value)));
+    }
+    PLY_INLINE GroupMask matchEmptyOrDeleted() const {
+        // Empty and Deleted are the only control bytes with the high bit set.
+        return (u32) _mm_movemask_epi8(this->ctrl);
+    }
+#elif PLY_FLATHASHMAP_NEON
+    static constexpr u32 SlotShift = 2;
+    uint8x16_t ctrl;
+
+    static PLY_INLINE GroupMask toMask(uint8x16_t matches) {
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+    }
+    PLY_INLINE Group(const u8* ctrl) : ctrl{vld1q_u8(ctrl)} {
+    }
+    PLY_INLINE GroupMask match(u8 value) const {
+        return toMask(vceqq_u8(this->ctrl, vdupq_n_u8(value)));
+    }
+    PLY_INLINE GroupMask matchEmptyOrDeleted() const {
+        return toMask(vcltq_s8(vreinterpretq_s8_u8(this->ctrl), vdupq_n_s8(0)));
+    }
+#else
+    static constexpr u32 SlotShift = 0;
+    const u8* ctrl;
+
+    PLY_INLINE Group(const u8* ctrl) : ctrl{ctrl} {
+    }
+    PLY_INLINE GroupMask match(u8 value) const {
+        GroupMask mask = 0;
+        for (u32 i = 0; i < FlatHashMap::GroupWidth; i++) {
+            mask |= GroupMask(this->ctrl[i] == value) << i;
+        }
+        return mask;
+    }
+    PLY_INLINE GroupMask matchEmptyOrDeleted() const {
+        GroupMask mask = 0;
+        for (u32 i = 0; i < FlatHashMap::GroupWidth; i++) {
+            mask |= GroupMask(this->ctrl[i] >> 7) << i;
+        }
+        return mask;
+    }
+#endif
+
+    PLY_INLINE GroupMask matchEmpty() const {
+        return this->match(FlatHashMap::EmptySlot);
+    }
+    static PLY_INLINE u32 lowestSlot(GroupMask mask) {
+        return countTrailingZeros(mask) >> SlotShift;
+    }
+    // Number of unmatched slots at the start of the group.
+    static PLY_INLINE u32 leadingSlots(GroupMask mask) {
+        return mask ? lowestSlot(mask) : FlatHashMap::GroupWidth;
+    }
+    // Number of unmatched slots at the end of the group.
+    static PLY_INLINE u32 trailingSlots(GroupMask mask) {
+        static constexpr u32 UnusedBits = 64 - (FlatHashMap::GroupWidth << SlotShift);
+        return mask ? (countLeadingZeros(mask) - UnusedBits) >> SlotShift
+                    : FlatHashMap::GroupWidth;
+    }
+};
+
+//------------------------------------------------------------------
+// Probing
+//------------------------------------------------------------------
+static PLY_INLINE u8 hashToCtrl(u32 hash) {
+    return u8(hash & 0x7f);
+}
+
+static PLY_INLINE u32 sizeToGrowth(u32 size) {
+    // Maximum load factor is 7/8.
+    return size - size / 8;
+}
+
+static PLY_INLINE void setCtrl(FlatHashMap* map, u32 idx, u8 value) {
+    map->m_ctrl[idx] = value;
+    if (idx < FlatHashMap::GroupWidth) {
+        map->m_ctrl[map->m_sizeMask + 1 + idx] = value;
+    }
+}
+
+// Returns the index of the first Empty or Deleted slot in the probe sequence for hash.
+static PLY_NO_INLINE u32 findInsertSlot(const FlatHashMap* map, u32 hash) {
+    u32 pos = (hash >> 7) & map->m_sizeMask;
+    for (u32 step = FlatHashMap::GroupWidth;; step += FlatHashMap::GroupWidth) {
+        GroupMask mask = Group{map->m_ctrl + pos}.matchEmptyOrDeleted();
+        if (mask)
+            return (pos + Group::lowestSlot(mask)) & map->m_sizeMask;
+        PLY_ASSERT(step <= map->m_sizeMask + 1); // Table is full
+        pos = (pos + step) & map->m_sizeMask;
+    }
+}
+
+static PLY_INLINE FlatHashMap::FindResult findWithHash(const FlatHashMap* map,
+                                                       FlatHashMap::FindInfo* info,
+                                                       const FlatHashMap::Callbacks* cb,
+                                                       const void* key, const void* context,
+                                                       u32 hash) {
+    u8 h2 = hashToCtrl(hash);
+    u32 pos = (hash >> 7) & map->m_sizeMask;
+    // Triangular probing over groups visits every group when the table size is a power of 2.
+    for (u32 step = FlatHashMap::GroupWidth;; step += FlatHashMap::GroupWidth) {
+        Group group{map->m_ctrl + pos};
+        for (GroupMask mask = group.match(h2); mask; mask &= mask - 1) {
+            u32 idx = (pos + Group::lowestSlot(mask)) & map->m_sizeMask;
+            if (map->m_hashes[idx] == hash) {
+                void* item = PLY_PTR_OFFSET(map->m_items, cb->itemSize * idx);
+                if (cb->match(item, key, context)) {
+                    info->idx = idx;
+                    info->itemSlot = item;
+                    return FlatHashMap::FindResult::Found;
+                }
+            }
+        }
+        if (group.matchEmpty()) {
+            info->itemSlot = nullptr;
+            return FlatHashMap::FindResult::NotFound;
+        }
+        PLY_ASSERT(step <= map->m_sizeMask + 1); // Table has no Empty slots
+        pos = (pos + step) & map->m_sizeMask;
+    }
+}
+
+//------------------------------------------------------------------
+// FlatHashMap
+//------------------------------------------------------------------
+PLY_NO_INLINE FlatHashMap::FlatHashMap(const Callbacks* cb, u32 initialSize) {
+    m_population = 0;
+    createTable(cb, initialSize);
+}
+
+PLY_NO_INLINE FlatHashMap::FlatHashMap(FlatHashMap&& other) {
+    memcpy(static_cast<void*>(this), &other, sizeof(FlatHashMap));
+    memset(static_cast<void*>(&other), 0, sizeof(FlatHashMap));
+}
+
+PLY_NO_INLINE void FlatHashMap::moveAssign(const Callbacks* cb, FlatHashMap&& other) {
+    if (m_items) {
+        destroyTable(cb);
+    }
+    new (this) FlatHashMap{std::move(other)};
+}
+
+PLY_NO_INLINE void FlatHashMap::clear(const Callbacks* cb) {
+    if (m_items) {
+        destroyTable(cb);
+    }
+    memset(static_cast<void*>(this), 0, sizeof(FlatHashMap));
+}
+
+PLY_NO_INLINE void FlatHashMap::createTable(const Callbacks* cb, u32 size) {
+    size = max(size, InitialSize);
+    PLY_ASSERT(isPowerOf2(size));
+    // size is a multiple of 16, so the hashes are suitably aligned.
+    u32 itemBytes = cb->itemSize * size;
+    m_items = PLY_HEAP.alloc(itemBytes + (sizeof(u32) + 1) * size + GroupWidth);
+    m_hashes = (u32*) PLY_PTR_OFFSET(m_items, itemBytes);
+    m_ctrl = (u8*) (m_hashes + size);
+    memset(m_ctrl, EmptySlot, size + GroupWidth);
+    m_sizeMask = size - 1;
+    m_growthLeft = sizeToGrowth(size) - m_population;
+}
+
+PLY_NO_INLINE void FlatHashMap::destroyTable(const Callbacks* cb) {
+    PLY_ASSERT(m_items);
+    if (!cb->isTriviallyDestructible) {
+        for (u32 idx = 0; idx <= m_sizeMask; idx++) {
+            if (isFull(m_ctrl[idx])) {
+                cb->destruct(PLY_PTR_OFFSET(m_items, cb->itemSize * idx));
+            }
+        }
+    }
+    PLY_HEAP.free(m_items);
+    m_items = nullptr;
+}
+
+PLY_NO_INLINE void FlatHashMap::rebuild(const Callbacks* cb, u32 newSize) {
+    void* srcItems = m_items;
+    const u32* srcHashes = m_hashes;
+    const u8* srcCtrl = m_ctrl;
+    u32 srcSize = m_sizeMask + 1;
+    createTable(cb, newSize);
+    for (u32 srcIdx = 0; srcIdx < srcSize; srcIdx++) {
+        if (isFull(srcCtrl[srcIdx])) {
+            u32 hash = srcHashes[srcIdx];
+            u32 idx = findInsertSlot(this, hash);
+            setCtrl(this, idx, hashToCtrl(hash));
+            m_hashes[idx] = hash;
+            void* srcItem = PLY_PTR_OFFSET(srcItems, cb->itemSize * srcIdx);
+            cb->moveConstruct(PLY_PTR_OFFSET(m_items, cb->itemSize * idx), srcItem);
+            cb->destruct(srcItem);
+        }
+    }
+    PLY_HEAP.free(srcItems);
+}
+
+PLY_NO_INLINE FlatHashMap::FindResult FlatHashMap::find(FindInfo* info, const Callbacks* cb,
+                                                        const void* key,
+                                                        const void* context) const {
+    PLY_ASSERT((context != nullptr) == cb->requiresContext);
+    PLY_ASSERT(m_items);
+    return findWithHash(this, info, cb, key, context, cb->hash(key));
+}
+
+PLY_NO_INLINE FlatHashMap::FindResult FlatHashMap::insertOrFind(FindInfo* info,
+                                                                const Callbacks* cb,
+                                                                const void* key,
+                                                                const void* context) {
+    PLY_ASSERT((context != nullptr) == cb->requiresContext);
+    PLY_ASSERT(m_items);
+    u32 hash = cb->hash(key);
+    FindResult result = findWithHash(this, info, cb, key, context, hash);
+    if (result == FindResult::Found)
+        return result;
+
+    u32 idx = findInsertSlot(this, hash);
+    if (m_growthLeft == 0 && m_ctrl[idx] == EmptySlot) {
+        // Grow the table if it's mostly live items; otherwise, just purge the Deleted slots.
+        u32 size = m_sizeMask + 1;
+        rebuild(cb, (m_population + 1 > sizeToGrowth(size) / 2) ? size * 2 : size);
+        idx = findInsertSlot(this, hash);
+    }
+    if (m_ctrl[idx] == EmptySlot) {
+        m_growthLeft--;
+    }
+    setCtrl(this, idx, hashToCtrl(hash));
+    m_hashes[idx] = hash;
+    m_population++;
+    info->idx = idx;
+    info->itemSlot = PLY_PTR_OFFSET(m_items, cb->itemSize * idx);
+    cb->construct(info->itemSlot, key);
+    return FindResult::InsertedNew;
+}
+
+PLY_NO_INLINE void FlatHashMap::erase(FindInfo* info, const Callbacks* cb) {
+    PLY_ASSERT(info->itemSlot);
+    u32 idx = info->idx;
+    PLY_ASSERT(isFull(m_ctrl[idx]));
+    cb->destruct(info->itemSlot);
+    info->itemSlot = nullptr;
+
+    // If every group that includes this slot also contains an Empty slot, no probe sequence ever
+    // continued past this slot, so it can be marked Empty instead of Deleted.
+    GroupMask emptyAfter = Group{m_ctrl + idx}.matchEmpty();
+    GroupMask emptyBefore = Group{m_ctrl + ((idx - GroupWidth) & m_sizeMask)}.matchEmpty();
+    if (Group::leadingSlots(emptyAfter) + Group::trailingSlots(emptyBefore) < GroupWidth) {
+        setCtrl(this, idx, EmptySlot);
+        m_growthLeft++;
+    } else {
+        setCtrl(this, idx, DeletedSlot);
+    }
+    PLY_ASSERT(m_population > 0);
+    m_population--;
+}
+
+} // namespace details
+} // namespace ply
@@ -0,0 +1,327 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/container/HashMap.h>
+
+namespace ply {
+
+//------------------------------------------------------------------
+// details::FlatHashMap
+//------------------------------------------------------------------
+namespace details {
+struct FlatHashMap {
+    // Control bytes are probed in groups of this many slots at once.
+    static constexpr u32 GroupWidth = 16;
+    static constexpr u32 InitialSize = 16;
+    // Control byte values. Full slots hold the low 7 bits of the hash.
+    static constexpr u8 EmptySlot = 0x80;
+    static constexpr u8 DeletedSlot = 0xfe;
+
+    using Callbacks = HashMap::Callbacks;
+    using FindResult = HashMap::FindResult;
+
+    struct FindInfo {
+        u32 idx;
+        void* itemSlot; // null means not found
+    };
+
+    // A single allocation holds the items, followed by the full 32-bit hash of each item (so that
+    // the table can be rebuilt without access to the keys), followed by the control bytes. The
+    // first GroupWidth control bytes are mirrored past the end so that a group can be loaded at any
+    // index without wrapping.
+    void* m_items;
+    u32* m_hashes;
+    u8* m_ctrl;
+    u32 m_sizeMask;
+    u32 m_population;
+    u32 m_growthLeft; // Number of Empty slots that can be filled before the table is rebuilt
+
+    static PLY_INLINE bool isFull(u8 ctrl) {
+        return (ctrl & 0x80) == 0;
+    }
+
+    PLY_DLL_ENTRY FlatHashMap(const Callbacks* cb, u32 initialSize);
+    PLY_DLL_ENTRY FlatHashMap(FlatHashMap&& other);
+    PLY_DLL_ENTRY void moveAssign(const Callbacks* cb, FlatHashMap&& other);
+    PLY_DLL_ENTRY void clear(const Callbacks* cb);
+    PLY_DLL_ENTRY void createTable(const Callbacks* cb, u32 size);
+    PLY_DLL_ENTRY void destroyTable(const Callbacks* cb);
+    PLY_DLL_ENTRY void rebuild(const Callbacks* cb, u32 newSize);
+    PLY_DLL_ENTRY FindResult find(FindInfo* info, const Callbacks* cb, const void* key,
+                                  const void* context) const;
+    PLY_DLL_ENTRY FindResult insertOrFind(FindInfo* info, const Callbacks* cb, const void* key,
+                                          const void* context);
+    PLY_DLL_ENTRY void erase(FindInfo* info, const Callbacks* cb);
+};
+} // namespace details
+
+//------------------------------------------------------------------------------------------------
+/*!
+An open-addressing hash map that accepts the same [HashMap Traits](HashMapTraits) as `HashMap` and
+exposes the same `Cursor`-based interface, so that most call sites can switch between the two by
+changing a typedef.
+
+Instead of following `HashMap`'s per-bucket delta chains, `FlatHashMap` keeps one control byte per
+slot holding 7 bits of each item's hash, and probes 16 control bytes at once using SSE2 on x86/x64
+and NEON on ARM64 (with a portable fallback elsewhere). Lookups touch the item array only for slots
+whose control byte matches. Erased slots become tombstones, which are reclaimed when the table is
+rebuilt.
+
+Unlike `HashMap`, `FlatHashMap` does not support `insertMulti()` or `Cursor::next()`, and erasing
+an item never moves other items.
+
+`FlatHashMap` is not thread-safe. If you manipulate a map object from multiple threads, you must
+enforce mutual exclusion yourself.
+*/
+template <class Traits>
+class FlatHashMap {
+private:
+    using Key = typename Traits::Key;
+    using Item = typename Traits::Item;
+    using Context = typename details::HashMap::Context<Traits>::Type;
+    using Callbacks = details::HashMap::CallbackMaker<Traits>;
+
+    details::FlatHashMap m_map;
+
+    PLY_INLINE Item* itemAt(u32 idx) const {
+        return (Item*) m_map.m_items + idx;
+    }
+
+public:
+    /*!
+    Constructs an empty `FlatHashMap`. `initialSize` must be a power of 2.
+    */
+    PLY_INLINE FlatHashMap(u32 initialSize = details::FlatHashMap::InitialSize)
+        : m_map{Callbacks::instance(), initialSize} {
+    }
+
+    /*!
+    Move constructor. `other` is set to an invalid state. After this call, it's not legal to insert
+    or find items in `other` unless it is set back to a valid state using move assignment.
+    */
+    PLY_INLINE FlatHashMap(FlatHashMap&& other) : m_map{std::move(other.m_map)} {
+    }
+
+    PLY_INLINE ~FlatHashMap() {
+        if (m_map.m_items) {
+            m_map.destroyTable(Callbacks::instance());
+        }
+    }
+
+    /*!
+    Move assignment operator. `other` is set to an invalid state.
+    */
+    PLY_INLINE void operator=(FlatHashMap&& other) {
+        m_map.moveAssign(Callbacks::instance(), std::move(other.m_map));
+    }
+
+    /*!
+    Destructs all `Item`s in the `FlatHashMap` and sets it to an invalid state, just like
+    `HashMap::clear()`.
+    */
+    PLY_INLINE void clear() {
+        m_map.clear(Callbacks::instance());
+    }
+
+    //------------------------------------------------------------------
+    // Cursor
+    //------------------------------------------------------------------
+    class Cursor : public CursorMixin<Cursor, Item> {
+    private:
+        friend class FlatHashMap;
+        template <class, typename, bool>
+        friend class CursorMixin;
+
+        FlatHashMap* m_map;
+        struct {
+            u32 idx;
+            Item* itemSlot;
+        } m_findInfo;
+        details::HashMap::FindResult m_findResult;
+
+        PLY_INLINE Cursor(FlatHashMap* map, const Key& key, const Context* context, bool insert)
+            : m_map{map} {
+            details::FlatHashMap::FindInfo* info = (details::FlatHashMap::FindInfo*) &m_findInfo;
+            m_findResult = insert ? m_map->m_map.insertOrFind(info, Callbacks::instance(), &key,
+                                                              context)
+                                  : m_map->m_map.find(info, Callbacks::instance(), &key, context);
+        }
+
+    public:
+        PLY_INLINE bool isValid() const {
+            return m_findResult != details::HashMap::FindResult::NotFound;
+        }
+        PLY_INLINE bool wasFound() const {
+            return m_findResult == details::HashMap::FindResult::Found;
+        }
+        PLY_INLINE Item& operator*() {
+            PLY_ASSERT(m_findInfo.itemSlot);
+            return *m_findInfo.itemSlot;
+        }
+        PLY_INLINE const Item& operator*() const {
+            PLY_ASSERT(m_findInfo.itemSlot);
+            return *m_findInfo.itemSlot;
+        }
+        PLY_INLINE void erase() {
+            m_map->m_map.erase((details::FlatHashMap::FindInfo*) &m_findInfo,
+                               Callbacks::instance());
+            m_findResult = details::HashMap::FindResult::NotFound;
+        }
+    };
+
+    //------------------------------------------------------------------
+    // ConstCursor
+    //------------------------------------------------------------------
+    class ConstCursor : public CursorMixin<ConstCursor, Item> {
+    private:
+        friend class FlatHashMap;
+        template <class, typename, bool>
+        friend class CursorMixin;
+
+        const FlatHashMap* m_map;
+        struct {
+            u32 idx;
+            Item* itemSlot;
+        } m_findInfo;
+        details::HashMap::FindResult m_findResult;
+
+        PLY_INLINE ConstCursor(const FlatHashMap* map, const Key& key, const Context* context)
+            : m_map{map} {
+            m_findResult =
+                m_map->m_map.find((details::FlatHashMap::FindInfo*) &m_findInfo,
+                                  Callbacks::instance(), &key, context);
+        }
+
+    public:
+        PLY_INLINE bool isValid() const {
+            return m_findResult != details::HashMap::FindResult::NotFound;
+        }
+        PLY_INLINE bool wasFound() const {
+            return m_findResult == details::HashMap::FindResult::Found;
+        }
+        PLY_INLINE const Item& operator*() const {
+            PLY_ASSERT(m_findInfo.itemSlot);
+            return *m_findInfo.itemSlot;
+        }
+    };
+
+    /*!
+    Returns `true` if the hash map is empty.
+    */
+    PLY_INLINE bool isEmpty() const {
+        return m_map.m_population == 0;
+    }
+
+    /*!
+    Returns the number of items in the hash map.
+    */
+    PLY_INLINE u32 numItems() const {
+        return m_map.m_population;
+    }
+
+    /*!
+    Find `Key` in the hash map. If no matching `Item` exists, a new item is inserted. Call
+    `Cursor::wasFound()` on the return value to determine whether the item was found or inserted.
+    */
+    PLY_INLINE Cursor insertOrFind(const Key& key, const Context* context = nullptr) {
+        return {this, key, context, true};
+    }
+
+    /*!
+    \beginGroup
+    Attempts to find `Key` in the hash map. Call `Cursor::wasFound()` on the return value to
+    determine whether a matching `Item` was found.
+    */
+    PLY_INLINE Cursor find(const Key& key, const Context* context = nullptr) {
+        return {this, key, context, false};
+    }
+    PLY_INLINE ConstCursor find(const Key& key, const Context* context = nullptr) const {
+        return {this, key, context};
+    }
+    /*!
+    \endGroup
+    */
+
+    //------------------------------------------------------------------
+    // Iterator
+    //------------------------------------------------------------------
+    template <typename MapType, typename ItemType>
+    class IteratorBase {
+    private:
+        friend class FlatHashMap;
+        MapType& m_map;
+        u32 m_idx;
+
+    public:
+        IteratorBase(MapType& map, u32 idx) : m_map{map}, m_idx{idx} {
+        }
+
+        bool isValid() const {
+            return m_idx <= m_map.m_map.m_sizeMask;
+        }
+
+        void next() {
+            for (;;) {
+                m_idx++;
+                if (m_idx > m_map.m_map.m_sizeMask)
+                    break;
+                if (details::FlatHashMap::isFull(m_map.m_map.m_ctrl[m_idx]))
+                    break;
+            }
+        }
+
+        bool operator!=(const IteratorBase& other) const {
+            PLY_ASSERT(&m_map == &other.m_map);
+            return m_idx != other.m_idx;
+        }
+
+        void operator++() {
+            next();
+        }
+
+        ItemType& operator*() const {
+            PLY_ASSERT(m_idx <= m_map.m_map.m_sizeMask);
+            PLY_ASSERT(details::FlatHashMap::isFull(m_map.m_map.m_ctrl[m_idx]));
+            return *m_map.itemAt(m_idx);
+        }
+
+        ItemType* operator->() const {
+            return &(**this);
+        }
+    };
+    using Iterator = IteratorBase<FlatHashMap, Item>;
+    using ConstIterator = IteratorBase<const FlatHashMap, const Item>;
+
+    /*!
+    \beginGroup
+    Required functions to support range-for syntax.
+    */
+    Iterator begin() {
+        Iterator iter{*this, (u32) -1};
+        if (m_map.m_items) {
+            iter.next();
+        }
+        return iter;
+    }
+    ConstIterator begin() const {
+        ConstIterator iter{*this, (u32) -1};
+        if (m_map.m_items) {
+            iter.next();
+        }
+        return iter;
+    }
+    Iterator end() {
+        return {*this, m_map.m_items ? m_map.m_sizeMask + 1 : (u32) -1};
+    }
+    ConstIterator end() const {
+        return {*this, m_map.m_items ? m_map.m_sizeMask + 1 : (u32) -1};
+    }
+    /*!
+    \endGroup
+    */
+};
+
+} // namespace ply
@@ -9,6 +9,42 @@
 
 namespace ply {
 
+// Sets the live bits for indices [first, last).
+static PLY_INLINE void setLiveBits(u64* liveBits, u32 first, u32 last) {
+    while (first < last) {
+        u32 bit = first & 63;
+        u32 numBits = min(64 - bit, last - first);
+        u64 mask = (numBits == 64) ? ~u64(0) : ((u64(1) << numBits) - 1);
+        liveBits[first >> 6] |= mask << bit;
+        first += numBits;
+    }
+}
+
+u32 BasePool::baseAllocRange(u32 count, u32 itemSize) {
+    u32 first = m_size;
+    PLY_ASSERT(first + count >= first); // Overflow check
+    if (first + count > m_allocated) {
+        baseReserve(first + count, itemSize);
+    }
+    m_size = first + count;
+    setLiveBits(m_liveBits, first, m_size);
+    return first;
+}
+
+void BasePool::baseFinishCompact(u32 numLiveItems, u32 itemSize) {
+    m_firstFree = u32(-1);
+    m_sortedFreeList = 1;
+    m_freeListSize = 0;
+    m_size = numLiveItems;
+    if (numLiveItems == 0) {
+        baseClear();
+        return;
+    }
+    baseReserve(numLiveItems, itemSize);
+    memset(m_liveBits, 0, sizeof(u64) * ((m_allocated + 63) >> 6));
+    setLiveBits(m_liveBits, 0, numLiveItems);
+}
+
 void BasePool::baseSortFreeList(u32 itemSize) const {
     PLY_ASSERT(itemSize >= sizeof(u32));
     if (m_sortedFreeList)
@@ -25,6 +25,7 @@ class PoolPtr;
 class BasePool {
 public:
     void* m_items = nullptr;
+    u64* m_liveBits = nullptr; // One bit per slot, set if the slot holds a live item
     u32 m_size = 0;
     u32 m_allocated = 0;
     mutable u32 m_firstFree = u32(-1);
@@ -37,8 +38,13 @@ public:
     BasePool();
     void baseReserve(u32 newSize, u32 itemSize);
     u32 baseAlloc(u32 itemSize);
+    PLY_DLL_ENTRY u32 baseAllocRange(u32 count, u32 itemSize);
     void baseFree(u32 index, u32 itemSize);
     PLY_DLL_ENTRY void baseSortFreeList(u32 stride) const;
+    bool baseIsLive(u32 index) const;
+    u32 baseFindNextLive(u32 index) const;
+    u32 baseFindNextFree(u32 index) const;
+    PLY_DLL_ENTRY void baseFinishCompact(u32 numLiveItems, u32 itemSize);
     void baseClear();
 };
 
@@ -56,8 +62,14 @@ public:
     ~Pool();
     template <typename Index, typename... Args>
     PoolIndex<T, Index> newItem(Args&&... args);
+    template <typename Index, typename... Args>
+    Array<PoolIndex<T, Index>> newItems(u32 count, const Args&... args);
     template <typename Index>
     void delItem(PoolIndex<T, Index> index);
+    Array<u32> compact();
+    template <typename Index>
+    static void remapIndex(PoolIndex<T, Index>& index, ArrayView<const u32> remapTable);
+    u32 numItems() const;
 
     template <typename Index>
     PoolPtr<T> get(PoolIndex<T, Index>);
@@ -116,11 +128,10 @@ template <typename T>
 class PoolIterator {
 private:
     const Pool<T>* m_pool;
-    u32 m_nextFree;
     u32 m_index;
 
 public:
-    PoolIterator(const Pool<T>* pool, u32 nextFree, u32 index);
+    PoolIterator(const Pool<T>* pool, u32 index);
     ~PoolIterator();
     PoolIterator(const PoolIterator& other);
     void operator=(const PoolIterator&) = delete;
@@ -300,11 +311,17 @@ inline BasePool::BasePool() {
 }
 
 inline void BasePool::baseReserve(u32 newSize, u32 itemSize) {
+    u32 oldNumWords = (m_allocated + 63) >> 6;
     m_allocated = (u32) roundUpPowerOf2(
         max<u32>(newSize, 8));    // FIXME: Generalize to other resize strategies when needed
     PLY_ASSERT(m_allocated != 0); // Overflow check
     m_items = PLY_HEAP.realloc(
         m_items, itemSize * m_allocated); // FIXME: Generalize to other heaps when needed
+    u32 newNumWords = (m_allocated + 63) >> 6;
+    m_liveBits = (u64*) PLY_HEAP.realloc(m_liveBits, sizeof(u64) * newNumWords);
+    if (newNumWords > oldNumWords) {
+        memset(m_liveBits + oldNumWords, 0, sizeof(u64) * (newNumWords - oldNumWords));
+    }
 }
 
 inline u32 BasePool::baseAlloc(u32 itemSize) {
@@ -314,16 +331,20 @@ inline u32 BasePool::baseAlloc(u32 itemSize) {
         m_firstFree = nextFree;
         m_freeListSize--;
         PLY_ASSERT((m_freeListSize == 0) == (m_firstFree == u32(-1)));
+        m_liveBits[index >> 6] |= u64(1) << (index & 63);
         return index;
     }
     if (m_size >= m_allocated) {
         baseReserve(m_size + 1, itemSize);
     }
+    m_liveBits[m_size >> 6] |= u64(1) << (m_size & 63);
     return m_size++;
 }
 
 inline void BasePool::baseFree(u32 index, u32 itemSize) {
     PLY_ASSERT(index < m_size);
+    PLY_ASSERT(baseIsLive(index));
+    m_liveBits[index >> 6] &= ~(u64(1) << (index & 63));
     *(u32*) PLY_PTR_OFFSET(m_items, index * itemSize) = m_firstFree;
     m_firstFree = index;
     m_sortedFreeList = 0;
@@ -331,9 +352,49 @@ inline void BasePool::baseFree(u32 index, u32 itemSize) {
     m_freeListSize++;
 }
 
+inline bool BasePool::baseIsLive(u32 index) const {
+    PLY_ASSERT(index < m_size);
+    return (m_liveBits[index >> 6] & (u64(1) << (index & 63))) != 0;
+}
+
+// Returns the index of the first live item at or after index, or m_size if there is none. Bits past
+// m_size are always clear.
+inline u32 BasePool::baseFindNextLive(u32 index) const {
+    if (index >= m_size)
+        return m_size;
+    u32 word = index >> 6;
+    u32 numWords = (m_size + 63) >> 6;
+    u64 bits = m_liveBits[word] & (~u64(0) << (index & 63));
+    for (;;) {
+        if (bits)
+            return (word << 6) + countTrailingZeros(bits);
+        if (++word >= numWords)
+            return m_size;
+        bits = m_liveBits[word];
+    }
+}
+
+// Returns the index of the first free slot at or after index, or m_size if there is none.
+inline u32 BasePool::baseFindNextFree(u32 index) const {
+    if (index >= m_size)
+        return m_size;
+    u32 word = index >> 6;
+    u32 numWords = (m_size + 63) >> 6;
+    u64 bits = ~m_liveBits[word] & (~u64(0) << (index & 63));
+    for (;;) {
+        if (bits)
+            return min((word << 6) + countTrailingZeros(bits), m_size);
+        if (++word >= numWords)
+            return m_size;
+        bits = ~m_liveBits[word];
+    }
+}
+
 inline void BasePool::baseClear() {
     PLY_HEAP.free(m_items);
     m_items = nullptr;
+    PLY_HEAP.free(m_liveBits);
+    m_liveBits = nullptr;
     m_size = 0;
     m_allocated = 0;
     m_firstFree = -1;
@@ -351,20 +412,8 @@ Pool<T>::Pool() {
 template <typename T>
 void Pool<T>::clear() {
     if (!std::is_trivially_destructible<T>::value) {
-        baseSortFreeList(sizeof(T));
-        T* item = static_cast<T*>(m_items);
-        T* end = item + m_size;
-        u32 skipIndex = m_firstFree;
-        for (;;) {
-            T* skip = static_cast<T*>(m_items) + (skipIndex == u32(-1) ? m_size : skipIndex);
-            while (item < skip) {
-                item->~T();
-                item++;
-            }
-            if (item == end)
-                break;
-            skipIndex = *reinterpret_cast<u32*>(skip);
-            item++;
+        for (u32 i = baseFindNextLive(0); i < m_size; i = baseFindNextLive(i + 1)) {
+            static_cast<T*>(m_items)[i].~T();
         }
     }
     baseClear();
@@ -387,6 +436,34 @@ PoolIndex<T, Index> Pool<T>::newItem(Args&&... args) {
     return index;
 }
 
+//! Constructs `count` new items using the same constructor arguments and returns their indices.
+//! Free slots are reused first, lowest index first if the free list is sorted; the remaining items
+//! are allocated contiguously at the end of the pool with at most one reallocation.
+template <typename T>
+template <typename Index, typename... Args>
+Array<PoolIndex<T, Index>> Pool<T>::newItems(u32 count, const Args&... args) {
+#if PLY_WITH_POOL_DEBUG_CHECKS
+    // There must not be any Iterators or Ptrs when modifying the pool!
+    PLY_ASSERT(m_numReaders == 0);
+#endif
+    Array<PoolIndex<T, Index>> result;
+    result.reserve(count);
+    while (result.numItems() < count && m_firstFree != u32(-1)) {
+        u32 index = baseAlloc(sizeof(T));
+        new (static_cast<T*>(m_items) + index) T{args...};
+        result.append(index);
+    }
+    u32 numRemaining = count - result.numItems();
+    if (numRemaining > 0) {
+        u32 first = baseAllocRange(numRemaining, sizeof(T));
+        for (u32 index = first; index < first + numRemaining; index++) {
+            new (static_cast<T*>(m_items) + index) T{args...};
+            result.append(index);
+        }
+    }
+    return result;
+}
+
 template <typename T>
 template <typename Index>
 void Pool<T>::delItem(PoolIndex<T, Index> index) {
@@ -412,6 +489,50 @@ PoolPtr<const T> Pool<T>::get(PoolIndex<T, Index> index) const {
     return {(Pool<const T>*) this, static_cast<const T*>(m_items) + index.idx};
 }
 
+//! Moves live items so that they occupy indices 0 to numItems() - 1, then shrinks the pool's
+//! memory. Items that are already in that range keep their index; items past it are moved into the
+//! free slots. Returns a table mapping every old index to its new index, or to u32(-1) for slots
+//! that were free. Pass it to remapIndex() to update any stored PoolIndex values.
+template <typename T>
+Array<u32> Pool<T>::compact() {
+#if PLY_WITH_POOL_DEBUG_CHECKS
+    // There must not be any Iterators or Ptrs when modifying the pool!
+    PLY_ASSERT(m_numReaders == 0);
+#endif
+    Array<u32> remapTable;
+    remapTable.resize(m_size);
+    for (u32 i = 0; i < m_size; i++) {
+        remapTable[i] = baseIsLive(i) ? i : u32(-1);
+    }
+    u32 numLive = m_size - m_freeListSize;
+    u32 dst = baseFindNextFree(0);
+    for (u32 src = baseFindNextLive(numLive); src < m_size; src = baseFindNextLive(src + 1)) {
+        PLY_ASSERT(dst < numLive);
+        T* srcItem = static_cast<T*>(m_items) + src;
+        new (static_cast<T*>(m_items) + dst) T{std::move(*srcItem)};
+        srcItem->~T();
+        remapTable[src] = dst;
+        dst = baseFindNextFree(dst + 1);
+    }
+    baseFinishCompact(numLive, sizeof(T));
+    return remapTable;
+}
+
+template <typename T>
+template <typename Index>
+void Pool<T>::remapIndex(PoolIndex<T, Index>& index, ArrayView<const u32> remapTable) {
+    if (index.isValid()) {
+        u32 newIndex = remapTable[index.idx];
+        index.idx = (newIndex == u32(-1)) ? PoolIndex<T, Index>::InvalidIndex
+                                          : safeDemote<Index>(newIndex);
+    }
+}
+
+template <typename T>
+u32 Pool<T>::numItems() const {
+    return m_size - m_freeListSize;
+}
+
 template <typename T>
 u32 Pool<T>::indexOf(const T* item) const {
     u32 index = safeDemote<u32>(item - static_cast<const T*>(m_items));
@@ -423,42 +544,35 @@ u32 Pool<T>::indexOf(const T* item) const {
 //! The pool must not be modified during iteration.
 template <typename T>
 PoolIterator<T> Pool<T>::begin() {
-    baseSortFreeList(sizeof(T));
-    PoolIterator<T> iter{this, m_firstFree, u32(-1)};
-    ++iter;
-    return iter;
+    return {this, baseFindNextLive(0)};
 }
 
 //! Return iterator suitable for range-for.
 //! The pool must not be modified during iteration.
 template <typename T>
 PoolIterator<T> Pool<T>::end() {
-    return {this, u32(-1), m_size};
+    return {this, m_size};
 }
 
 //! Return iterator suitable for range-for.
 //! The pool must not be modified during iteration.
 template <typename T>
 PoolIterator<const T> Pool<T>::begin() const {
-    baseSortFreeList(sizeof(T));
-    PoolIterator<const T> iter{(Pool<const T>*) this, m_firstFree, u32(-1)};
-    ++iter;
-    return iter;
+    return {(Pool<const T>*) this, baseFindNextLive(0)};
 }
 
 //! Return iterator suitable for range-for.
 //! The pool must not be modified during iteration.
 template <typename T>
 PoolIterator<const T> Pool<T>::end() const {
-    return {this, u32(-1), m_size};
+    return {(Pool<const T>*) this, m_size};
 }
 
 //------------------------------------------------------------------------------------
 // PoolIterator<T> inline functions
 //------------------------------------------------------------------------------------
 template <typename T>
-PoolIterator<T>::PoolIterator(const Pool<T>* pool, u32 nextFree, u32 index)
-    : m_pool(pool), m_nextFree(nextFree), m_index(index) {
+PoolIterator<T>::PoolIterator(const Pool<T>* pool, u32 index) : m_pool(pool), m_index(index) {
 #if PLY_WITH_POOL_DEBUG_CHECKS
     m_pool->m_numReaders++;
 #endif
@@ -477,7 +591,6 @@ PoolIterator<T>::PoolIterator(const PoolIterator& other) : m_pool(other.m_pool)
 #if PLY_WITH_POOL_DEBUG_CHECKS
     m_pool->m_numReaders++;
 #endif
-    m_nextFree = other.m_nextFree;
     m_index = other.m_index;
 }
 
@@ -495,14 +608,8 @@ PoolPtr<T> PoolIterator<T>::operator*() const {
 
 template <typename T>
 PoolIterator<T>& PoolIterator<T>::operator++() {
-    m_index++;
-    while (m_index < m_pool->m_size) {
-        PLY_ASSERT(m_index <= m_nextFree);
-        if (m_index < m_nextFree)
-            break;
-        m_nextFree = *reinterpret_cast<const u32*>(static_cast<T*>(m_pool->m_items) + m_index);
-        m_index++;
-    }
+    // Free slots are skipped by scanning the pool's bitmap of live items, 64 slots at a time.
+    m_index = m_pool->baseFindNextLive(m_index + 1);
     return *this;
 }
 
@@ -13,9 +13,8 @@
 #define PLY_IMPL_DIRECTORYWATCHER_PATH "impl/DirectoryWatcher_Mac.h"
 #define PLY_IMPL_DIRECTORYWATCHER_TYPE DirectoryWatcher_Mac
 #elif PLY_KERNEL_LINUX
-// FIXME: Implement proper Linux support using inotify or similar
-#define PLY_IMPL_DIRECTORYWATCHER_PATH "impl/DirectoryWatcher_Null.h"
-#define PLY_IMPL_DIRECTORYWATCHER_TYPE DirectoryWatcher_Null
+#define PLY_IMPL_DIRECTORYWATCHER_PATH "impl/DirectoryWatcher_Linux.h"
+#define PLY_IMPL_DIRECTORYWATCHER_TYPE DirectoryWatcher_Linux
 #else
 #define PLY_IMPL_DIRECTORYWATCHER_PATH \
     "*** Unable to select a default DirectoryWatcher implementation ***"
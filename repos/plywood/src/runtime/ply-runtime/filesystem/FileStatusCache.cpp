@@ -0,0 +1,142 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/filesystem/FileStatusCache.h>
+#include <ply-runtime/container/Hash128.h>
+
+namespace ply {
+
+// Returns true if path is equal to dir or is located under it. Both paths must be normalized.
+static PLY_NO_INLINE bool isUnder(const PathFormat& pathFmt, StringView path, StringView dir) {
+    if (!path.startsWith(dir))
+        return false;
+    if (path.numBytes == dir.numBytes || dir.isEmpty())
+        return true;
+    return pathFmt.isSepByte(dir.back()) || pathFmt.isSepByte(path[dir.numBytes]);
+}
+
+// Must be called with the mutex held. The returned reference is valid until the next insertion.
+static PLY_NO_INLINE FileStatusCache::Entry& lookupAndRefresh(FileStatusCache* cache,
+                                                             StringView path) {
+    PathFormat pathFmt = cache->fs->pathFormat();
+    auto cursor = cache->entries.insertOrFind(path);
+    FileStatusCache::Entry& entry = *cursor;
+    if (!cursor.wasFound()) {
+        entry.normPath = pathFmt.normalize(path);
+        for (StringView root : cache->watchedRoots) {
+            if (isUnder(pathFmt, entry.normPath, root)) {
+                entry.isWatched = true;
+                break;
+            }
+        }
+    }
+
+    CPUTimer::Point now = CPUTimer::get();
+    if (!entry.isValid || (!entry.isWatched && now >= entry.expiryTime)) {
+        FileStatus status = cache->fs->getFileStatus(path);
+        if (status.result != entry.status.result || status.fileSize != entry.status.fileSize ||
+            status.modificationTime != entry.status.modificationTime ||
+            status.fileID != entry.status.fileID) {
+            entry.hasContentHash = false;
+        }
+        entry.status = status;
+        entry.isValid = true;
+        entry.expiryTime = now + cache->ttl;
+    }
+    return entry;
+}
+
+PLY_NO_INLINE FileStatusCache::FileStatusCache(FileSystem* fs, float ttlSeconds) : fs{fs} {
+    this->ttl = CPUTimer::Converter{}.toDuration(ttlSeconds);
+}
+
+PLY_NO_INLINE FileStatusCache& FileStatusCache::native() {
+    static FileStatusCache cache{FileSystem::native()};
+    return cache;
+}
+
+PLY_NO_INLINE FileStatus FileStatusCache::getFileStatus(StringView path) {
+    LockGuard<Mutex> guard{this->mutex};
+    const FileStatus& status = lookupAndRefresh(this, path).status;
+    FileSystem::setLastResult(status.result);
+    return status;
+}
+
+PLY_NO_INLINE Tuple<FSResult, u128> FileStatusCache::getContentHash(StringView path) {
+    FileStatus status;
+    {
+        LockGuard<Mutex> guard{this->mutex};
+        Entry& entry = lookupAndRefresh(this, path);
+        if (entry.status.result != FSResult::OK)
+            return {entry.status.result, 0};
+        if (entry.hasContentHash)
+            return {FSResult::OK, entry.contentHash};
+        status = entry.status;
+    }
+
+    // Hash the file without holding the lock.
+    Reference<MappedFile> mapped = this->fs->mapFileForRead(path);
+    FSResult result = this->fs->lastResult();
+    if (!mapped)
+        return {result, 0};
+    u128 contentHash = Hash128::compute(mapped->view());
+
+    // Only remember the hash if the status wasn't invalidated or changed in the meantime.
+    LockGuard<Mutex> guard{this->mutex};
+    auto cursor = this->entries.find(path);
+    if (cursor.wasFound() && cursor->isValid && cursor->status.fileSize == status.fileSize &&
+        cursor->status.modificationTime == status.modificationTime &&
+        cursor->status.fileID == status.fileID) {
+        cursor->hasContentHash = true;
+        cursor->contentHash = contentHash;
+    }
+    return {FSResult::OK, contentHash};
+}
+
+PLY_NO_INLINE void FileStatusCache::invalidate(StringView path) {
+    PathFormat pathFmt = this->fs->pathFormat();
+    String normPath = pathFmt.normalize(path);
+    LockGuard<Mutex> guard{this->mutex};
+    for (Entry& entry : this->entries) {
+        if (isUnder(pathFmt, entry.normPath, normPath)) {
+            entry.isValid = false;
+            entry.hasContentHash = false;
+        }
+    }
+}
+
+PLY_NO_INLINE void FileStatusCache::invalidateAll() {
+    LockGuard<Mutex> guard{this->mutex};
+    for (Entry& entry : this->entries) {
+        entry.isValid = false;
+        entry.hasContentHash = false;
+    }
+}
+
+PLY_NO_INLINE void FileStatusCache::watch(StringView root) {
+    // DirectoryWatcher only watches the native filesystem.
+    PLY_ASSERT(this->fs == FileSystem::native());
+    PathFormat pathFmt = this->fs->pathFormat();
+    String normRoot = pathFmt.normalize(root);
+    auto onChange = [this, normRoot](StringView path, bool) {
+        // An empty path means the watcher lost track of changes.
+        this->invalidate(path.isEmpty() ? String{normRoot} : NativePath::join(normRoot, path));
+    };
+    Owned<DirectoryWatcher> watcher = new DirectoryWatcher{normRoot, std::move(onChange)};
+
+    // Entries under the root may already be stale.
+    LockGuard<Mutex> guard{this->mutex};
+    for (Entry& entry : this->entries) {
+        if (isUnder(pathFmt, entry.normPath, normRoot)) {
+            entry.isValid = false;
+            entry.hasContentHash = false;
+            entry.isWatched = true;
+        }
+    }
+    this->watchedRoots.append(std::move(normRoot));
+    this->watchers.append(std::move(watcher));
+}
+
+} // namespace ply
@@ -0,0 +1,104 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-runtime/filesystem/DirectoryWatcher.h>
+#include <ply-runtime/container/HashMap.h>
+#include <ply-runtime/container/Int128.h>
+#include <ply-runtime/thread/Mutex.h>
+#include <ply-runtime/time/CPUTimer.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+`FileStatusCache` remembers the result of `FileSystem::getFileStatus()` for each path it's asked
+about, along with an optional hash of the file's contents that's only computed when requested.
+
+A cached status is reused until it's invalidated. Entries are invalidated explicitly by calling
+`invalidate()`, automatically when a `DirectoryWatcher` started by `watch()` reports a change under
+the entry's path, or after `ttl` seconds for paths that aren't under a watched directory.
+Explicit invalidation discards the content hash. When a status expires, the content hash is only
+discarded if the file's size, modification time or file ID has changed.
+
+All member functions are thread-safe.
+*/
+struct FileStatusCache {
+    struct Entry {
+        String path;
+        String normPath; // Normalized path, compared against invalidated paths
+        FileStatus status;
+        CPUTimer::Point expiryTime;
+        bool isValid = false;
+        bool isWatched = false;
+        bool hasContentHash = false;
+        u128 contentHash = 0;
+
+        PLY_INLINE Entry(StringView path) : path{path} {
+        }
+    };
+
+    struct Traits {
+        using Key = StringView;
+        using Item = Entry;
+        static PLY_INLINE bool match(const Entry& entry, StringView path) {
+            return entry.path == path;
+        }
+    };
+
+    FileSystem* fs = nullptr;
+    CPUTimer::Duration ttl;
+
+    // These members are protected by mutex:
+    Mutex mutex;
+    HashMap<Traits> entries;
+    Array<String> watchedRoots;
+
+    // Declared last so that watcher threads stop before any other member is destroyed.
+    Array<Owned<DirectoryWatcher>> watchers;
+
+    /*!
+    Creates a cache for the specified filesystem. Statuses of paths that aren't under a watched
+    directory are refreshed after `ttlSeconds`.
+    */
+    PLY_DLL_ENTRY FileStatusCache(FileSystem* fs, float ttlSeconds = 1.f);
+
+    /*!
+    Returns a process-wide cache for `FileSystem::native()`.
+    */
+    static PLY_DLL_ENTRY FileStatusCache& native();
+
+    /*!
+    Like `FileSystem::getFileStatus()`, but only queries the filesystem when there's no valid cached
+    status for `path`. Updates the internal result code of the filesystem in either case.
+    */
+    PLY_DLL_ENTRY FileStatus getFileStatus(StringView path);
+
+    /*!
+    Returns a 128-bit hash of the file's contents, computing it only if it isn't already cached.
+    Comparing content hashes detects changes correctly even when modification times are coarse or
+    unreliable. The first member of the result is `OK` if the file could be read.
+    */
+    PLY_DLL_ENTRY Tuple<FSResult, u128> getContentHash(StringView path);
+
+    /*!
+    Invalidates the cached status of `path` and of everything under it.
+    */
+    PLY_DLL_ENTRY void invalidate(StringView path);
+
+    /*!
+    Invalidates every cached status.
+    */
+    PLY_DLL_ENTRY void invalidateAll();
+
+    /*!
+    Starts a `DirectoryWatcher` on `root`. From then on, cached statuses of paths under `root`
+    don't expire, and are invalidated only when the watcher reports a change.
+    */
+    PLY_DLL_ENTRY void watch(StringView root);
+};
+
+} // namespace ply
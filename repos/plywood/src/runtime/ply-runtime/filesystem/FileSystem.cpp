@@ -5,6 +5,11 @@
 #include <ply-runtime/Precomp.h>
 #include <ply-runtime/filesystem/FileSystem.h>
 #include <ply-runtime/io/Pipe.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-runtime/thread/Mutex.h>
+#include <ply-runtime/thread/ConditionVariable.h>
+#include <ply-runtime/thread/Atomic.h>
+#include <ply-runtime/thread/TID.h>
 
 namespace ply {
 
@@ -24,20 +29,7 @@ struct WalkImpl : FileSystem::Walk::Impl {
 
     PLY_NO_INLINE void visit(StringView dirPath) {
         this->triple.dirPath = dirPath;
-        this->triple.dirNames.clear();
-        this->triple.files.clear();
-        for (DirectoryEntry& entry : this->fs->listDir(dirPath, this->flags)) {
-            if (entry.isDir) {
-                this->triple.dirNames.append(std::move(entry.name));
-            } else {
-                WalkTriple::FileInfo& file = this->triple.files.append();
-                file.name = std::move(entry.name);
-                file.fileSize = entry.fileSize;
-                file.creationTime = entry.creationTime;
-                file.accessTime = entry.accessTime;
-                file.modificationTime = entry.modificationTime;
-            }
-        }
+        this->fs->listDirForWalk(this->triple, this->flags);
     }
 
     static PLY_NO_INLINE void destructImpl(FileSystem::Walk::Impl* impl_) {
@@ -82,6 +74,115 @@ PLY_NO_INLINE FileSystem::Walk FileSystem::walk(StringView top, u32 flags) {
     return walk;
 }
 
+PLY_NO_INLINE FSResult FileSystem::listDirForWalk(WalkTriple& triple, u32 flags) {
+    triple.dirNames.clear();
+    triple.files.clear();
+    if (this->funcs->listDirForWalk)
+        return this->funcs->listDirForWalk(this, triple, flags);
+
+    Directory dir = this->listDir(triple.dirPath, flags);
+    FSResult result = this->lastResult();
+    for (DirectoryEntry& entry : dir) {
+        if (entry.isDir) {
+            triple.dirNames.append(std::move(entry.name));
+        } else {
+            WalkTriple::FileInfo& file = triple.files.append();
+            file.name = std::move(entry.name);
+            file.fileSize = entry.fileSize;
+            file.creationTime = entry.creationTime;
+            file.accessTime = entry.accessTime;
+            file.modificationTime = entry.modificationTime;
+        }
+    }
+    return FileSystem::setLastResult(result);
+}
+
+PLY_NO_INLINE void FileSystem::walkParallel(StringView top, u32 flags,
+                                            const WalkCallback& onDir) {
+    // Listing directories is mostly waiting on the disk, so use a fixed number of threads
+    // regardless of the number of CPU cores.
+    static constexpr u32 MaxThreads = 8;
+
+    struct Shared {
+        Mutex mutex;
+        ConditionVariable workCondVar;
+        ConditionVariable doneCondVar;
+        Array<String> pending;       // Protected by mutex
+        Array<WalkTriple> completed; // Protected by mutex
+        bool finished = false;       // Protected by mutex
+    };
+    Shared shared;
+
+    auto listDirs = [this, flags, &shared] {
+        WalkTriple triple;
+        bool haveTriple = false;
+        for (;;) {
+            {
+                LockGuard<Mutex> guard{shared.mutex};
+                if (haveTriple) {
+                    shared.completed.append(std::move(triple));
+                    shared.doneCondVar.wakeOne();
+                }
+                while (shared.pending.isEmpty() && !shared.finished) {
+                    shared.workCondVar.wait(guard);
+                }
+                if (shared.finished)
+                    break;
+                triple.dirPath = std::move(shared.pending.back());
+                shared.pending.pop();
+            }
+            this->listDirForWalk(triple, flags);
+            haveTriple = true;
+        }
+    };
+
+    Array<Thread> threads;
+    threads.resize(MaxThreads);
+    for (Thread& thread : threads) {
+        thread.run(listDirs);
+    }
+
+    // Invoke callbacks on the calling thread, then queue the remaining subdirectories.
+    {
+        LockGuard<Mutex> guard{shared.mutex};
+        shared.pending.append(top);
+        shared.workCondVar.wakeOne();
+    }
+    Array<WalkTriple> batch;
+    Array<String> subdirs;
+    for (u32 numOutstanding = 1; numOutstanding > 0;) {
+        {
+            LockGuard<Mutex> guard{shared.mutex};
+            shared.pending.extend(std::move(subdirs));
+            if (!shared.pending.isEmpty()) {
+                shared.workCondVar.wakeAll();
+            }
+            while (shared.completed.isEmpty()) {
+                shared.doneCondVar.wait(guard);
+            }
+            batch = std::move(shared.completed);
+        }
+        subdirs.clear();
+        for (WalkTriple& triple : batch) {
+            onDir(triple);
+            for (StringView dirName : triple.dirNames) {
+                subdirs.append(this->pathFormat().join(triple.dirPath, dirName));
+            }
+        }
+        numOutstanding += subdirs.numItems() - batch.numItems();
+        batch.clear();
+    }
+
+    {
+        LockGuard<Mutex> guard{shared.mutex};
+        shared.finished = true;
+        shared.workCondVar.wakeAll();
+    }
+    for (Thread& thread : threads) {
+        thread.join();
+    }
+}
+
 PLY_NO_INLINE FSResult FileSystem::makeDirs(StringView path) {
     if (path == this->pathFormat().getDriveLetter(path)) {
         return FileSystem::setLastResult(FSResult::OK);
@@ -145,6 +246,72 @@ PLY_NO_INLINE String FileSystem::loadBinary(StringView path) {
     return result;
 }
 
+PLY_NO_INLINE void FileSystem::loadManyAsync(ArrayView<const StringView> paths,
+                                             const LoadCallback& onComplete) {
+    if (this->funcs->loadManyAsync) {
+        this->funcs->loadManyAsync(this, paths, onComplete);
+    } else {
+        loadManyUsingThreads(this, paths, onComplete);
+    }
+}
+
+PLY_NO_INLINE void FileSystem::loadManyUsingThreads(FileSystem* fs,
+                                                    ArrayView<const StringView> paths,
+                                                    const LoadCallback& onComplete) {
+    // Loading files is mostly waiting on the disk, so use a fixed number of threads regardless of
+    // the number of CPU cores.
+    static constexpr u32 MaxThreads = 8;
+
+    struct Shared {
+        Atomic<u32> nextIndex{0};
+        Mutex mutex;
+        ConditionVariable condVar;
+        Array<Tuple<u32, FSResult, String>> completed; // Protected by mutex
+    };
+    Shared shared;
+
+    auto loadFiles = [fs, paths, &shared] {
+        for (;;) {
+            u32 index = shared.nextIndex.fetchAdd(1, Relaxed);
+            if (index >= paths.numItems)
+                break;
+            String contents = fs->loadBinary(paths[index]);
+            FSResult result = fs->lastResult();
+            LockGuard<Mutex> guard{shared.mutex};
+            shared.completed.append(index, result, std::move(contents));
+            shared.condVar.wakeOne();
+        }
+    };
+
+    u32 numThreads = min(paths.numItems, MaxThreads);
+    Array<Thread> threads;
+    threads.resize(numThreads);
+    for (Thread& thread : threads) {
+        thread.run(loadFiles);
+    }
+
+    // Invoke callbacks on the calling thread as files complete.
+    Array<Tuple<u32, FSResult, String>> batch;
+    for (u32 numCompleted = 0; numCompleted < paths.numItems;) {
+        {
+            LockGuard<Mutex> guard{shared.mutex};
+            while (shared.completed.isEmpty()) {
+                shared.condVar.wait(guard);
+            }
+            batch = std::move(shared.completed);
+        }
+        for (Tuple<u32, FSResult, String>& item : batch) {
+            onComplete(item.first, item.second, std::move(item.third));
+        }
+        numCompleted += batch.numItems();
+        batch.clear();
+    }
+
+    for (Thread& thread : threads) {
+        thread.join();
+    }
+}
+
 PLY_NO_INLINE String FileSystem::loadText(StringView path, const TextFormat& textFormat) {
     Owned<InStream> ins = this->openTextForRead(path, textFormat);
     String contents;
@@ -171,37 +338,71 @@ PLY_NO_INLINE Owned<OutStream> FileSystem::openTextForWrite(StringView path,
     return textFormat.createExporter(std::move(outs));
 }
 
+// Compares the contents of an existing file to view without loading the whole file. Returns
+// Unchanged if they match, OK if they differ, or the result of opening the file.
+static PLY_NO_INLINE FSResult compareFileContents(FileSystem* fs, StringView path, StringView view) {
+    Owned<InPipe> inPipe = fs->openPipeForRead(path);
+    FSResult result = fs->lastResult();
+    if (!inPipe)
+        return result;
+    if (inPipe->funcs->getFileSize != InPipe::getFileSize_Unsupported &&
+        inPipe->getFileSize() != view.numBytes)
+        return FSResult::OK;
+
+    char buf[8192];
+    for (;;) {
+        u32 numBytes = inPipe->readSome({buf, min<u32>(sizeof(buf), view.numBytes + 1)});
+        if (numBytes == 0)
+            return view.isEmpty() ? FSResult::Unchanged : FSResult::OK;
+        if (numBytes > view.numBytes || memcmp(buf, view.bytes, numBytes) != 0)
+            return FSResult::OK;
+        view.offsetHead(numBytes);
+    }
+}
+
 PLY_NO_INLINE FSResult FileSystem::makeDirsAndSaveBinaryIfDifferent(StringView path,
                                                                     StringView view) {
-    // FIXME: This could be optimized
-    // We don't really need to load the existing file as a binary. We could read and compare it to
-    // view incrementally.
-
-    // Load existing contents
-    String existingContents = this->loadBinary(path);
-    FSResult existingResult = this->lastResult();
-    if (existingResult == FSResult::OK && existingContents == view) {
+    // Compare to existing contents
+    FSResult result = compareFileContents(this, path, view);
+    if (result == FSResult::Unchanged) {
         return FileSystem::setLastResult(FSResult::Unchanged);
     }
-    if (existingResult != FSResult::OK && existingResult != FSResult::NotFound) {
-        return existingResult;
+    if (result != FSResult::OK && result != FSResult::NotFound) {
+        return FileSystem::setLastResult(result);
     }
-    existingContents.clear();
 
     // Create intermediate directories
-    FSResult result = this->makeDirs(this->pathFormat().split(path).first);
+    auto splitPath = this->pathFormat().split(path);
+    result = this->makeDirs(splitPath.first);
     if (result != FSResult::OK && result != FSResult::AlreadyExists) {
         return result;
     }
 
-    // Save file
-    // FIXME: Use temporary file
-    Owned<OutPipe> outPipe = this->openPipeForWrite(path);
-    result = this->lastResult();
+    // Save to a temporary file in the same directory, then rename it over the original so that
+    // readers never observe a partially written file. The process ID and a counter keep temporary
+    // names unique across concurrent processes and threads.
+    static Atomic<u32> tempCounter{0};
+    String tempPath = this->pathFormat().join(
+        splitPath.first, String::format(".{}.{}.{}.tmp", splitPath.second,
+                                        TID::getCurrentProcessID(),
+                                        tempCounter.fetchAdd(1, Relaxed)));
+    {
+        Owned<OutPipe> outPipe = this->openPipeForWrite(tempPath);
+        result = this->lastResult();
+        if (result != FSResult::OK) {
+            return result;
+        }
+        if (!outPipe->write(view)) {
+            outPipe.clear();
+            this->deleteFile(tempPath);
+            return FileSystem::setLastResult(FSResult::Unknown);
+        }
+    }
+    result = this->moveFile(tempPath, path);
     if (result != FSResult::OK) {
-        return result;
+        this->deleteFile(tempPath);
+        return FileSystem::setLastResult(result);
     }
-    outPipe->write(view);
     return result;
 }
 
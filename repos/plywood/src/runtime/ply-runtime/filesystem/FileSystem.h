@@ -10,9 +10,11 @@
 #include <ply-runtime/container/Array.h>
 #include <ply-runtime/container/Tuple.h>
 #include <ply-runtime/container/Owned.h>
+#include <ply-runtime/container/LambdaView.h>
 #include <ply-runtime/io/Pipe.h>
 #include <ply-runtime/io/InStream.h>
 #include <ply-runtime/io/OutStream.h>
+#include <ply-runtime/io/MappedFile.h>
 #include <ply-runtime/io/text/TextFormat.h>
 
 // clang-format off
@@ -45,6 +47,7 @@ struct FileStatus {
     double creationTime = 0;             // The file's POSIX creation time
     double accessTime = 0;               // The file's POSIX access time
     double modificationTime = 0;         // The file's POSIX modification time
+    u64 fileID = 0;                      // Inode number on POSIX, file index on Windows
 };
 
 struct DirectoryEntry {
@@ -187,6 +190,11 @@ struct FileSystem {
         }
     };
 
+    // Receives the index of a path passed to loadManyAsync(), its result code and its contents.
+    using LoadCallback = LambdaView<void(u32 index, FSResult result, String&& contents)>;
+    // Receives one directory visited by walkParallel(). Can modify triple.dirNames to prune the walk.
+    using WalkCallback = LambdaView<void(WalkTriple& triple)>;
+
     struct Funcs {
         PathFormat pathFmt;
         Directory (*listDir)(FileSystem* fs, StringView path, u32 flags) = nullptr;
@@ -200,6 +208,10 @@ struct FileSystem {
         FSResult (*deleteFile)(FileSystem* fs, StringView path) = nullptr;
         FSResult (*removeDirTree)(FileSystem* fs, StringView dirPath) = nullptr;
         FileStatus (*getFileStatus)(FileSystem* fs, StringView path) = nullptr;
+        Reference<MappedFile> (*mapFileForRead)(FileSystem* fs, StringView path) = nullptr;
+        void (*loadManyAsync)(FileSystem* fs, ArrayView<const StringView> paths,
+                              const LoadCallback& onComplete) = nullptr;
+        FSResult (*listDirForWalk)(FileSystem* fs, WalkTriple& triple, u32 flags) = nullptr;
     };
 
     static ThreadLocal<FSResult> lastResult_;
@@ -396,6 +408,38 @@ struct FileSystem {
     */
     PLY_DLL_ENTRY Walk walk(StringView top, u32 flags = WithSizes | WithTimes);
 
+    /*!
+    Like `walk()`, but lists directories on several worker threads and passes each `WalkTriple` to
+    `onDir` instead of returning an iterator. `onDir` is always invoked on the calling thread, one
+    directory at a time, and can prune the walk by modifying `triple.dirNames` in-place. A
+    subdirectory is only listed after its parent has been passed to `onDir`. Apart from that,
+    directories are visited in an arbitrary order. This function returns after the entire tree has
+    been visited.
+
+    On the native POSIX filesystem, entries are enumerated relative to an open directory file
+    descriptor, and individual entries are only `stat`ed when `WithSizes` or `WithTimes` is
+    specified.
+
+        Array<String> sources;
+        fs->walkParallel(".", 0, [&](WalkTriple& triple) {
+            for (const WalkTriple::FileInfo& file : triple.files) {
+                if (file.name.endsWith(".cpp")) {
+                    sources.append(NativePath::join(triple.dirPath, file.name));
+                }
+            }
+        });
+    */
+    PLY_DLL_ENTRY void walkParallel(StringView top, u32 flags, const WalkCallback& onDir);
+
+    /*!
+    Fills `triple.files` and `triple.dirNames` with the contents of the directory at
+    `triple.dirPath`. Used by `walk()` and `walkParallel()`. File systems without a faster
+    mechanism use `listDir()`.
+
+    This function updates the internal result code. The result code is also returned directly.
+    */
+    PLY_DLL_ENTRY FSResult listDirForWalk(WalkTriple& triple, u32 flags);
+
     /*!
     Creates a new directory. The parent directory must already exist.
 
@@ -483,6 +527,28 @@ struct FileSystem {
         return this->funcs->openPipeForRead(this, path);
     }
 
+    /*!
+    Maps the specified file into memory for reading and returns a reference to the mapping, or
+    `nullptr` if the file could not be opened.
+
+    This function updates the internal result code. Expected result codes are `OK`, `NotFound`,
+    `AccessDenied` or `Locked`.
+
+    The file's contents are accessed directly from the page cache instead of being copied, which
+    makes this the preferred way to read large files. Call `MappedFile::createInStream()` to parse
+    the contents, or wrap the mapping in an `InPipe_Mapped` where an `InPipe` is expected.
+    */
+    PLY_INLINE Reference<MappedFile> mapFileForRead(StringView path) {
+        if (!this->funcs->mapFileForRead) {
+            // This file system can't map files, so load the contents instead.
+            String contents = this->loadBinary(path);
+            if (this->lastResult() != FSResult::OK)
+                return nullptr;
+            return MappedFile::adoptString(std::move(contents));
+        }
+        return this->funcs->mapFileForRead(this, path);
+    }
+
     /*!
     Returns an `OutPipe` that writes raw data to the specified file, or `nullptr` if the file could
     not be opened.
@@ -564,6 +630,33 @@ struct FileSystem {
     */
     PLY_DLL_ENTRY String loadBinary(StringView path);
 
+    /*!
+    Loads the raw contents of many files at once. On Linux, the files are opened and read using a
+    single `io_uring` instead of several system calls per file; elsewhere, or if `io_uring` is
+    unavailable, they're loaded by a small pool of worker threads.
+
+    `onComplete` is called once for each path, on the calling thread, in the order that the files
+    finish loading. Its arguments are the index of the path, the result code and the contents of
+    the file, which are empty if the file couldn't be loaded. Expected result codes are `OK`,
+    `NotFound`, `AccessDenied` or `Locked`. This function returns after every callback has
+    returned.
+
+        fs->loadManyAsync(paths, [&](u32 index, FSResult result, String&& contents) {
+            if (result == FSResult::OK) {
+                sources[index] = std::move(contents);
+            }
+        });
+    */
+    PLY_DLL_ENTRY void loadManyAsync(ArrayView<const StringView> paths,
+                                     const LoadCallback& onComplete);
+
+    /*!
+    Implements `loadManyAsync()` by calling `loadBinary()` from several worker threads. File
+    systems without a faster mechanism use this.
+    */
+    static PLY_DLL_ENTRY void loadManyUsingThreads(FileSystem* fs, ArrayView<const StringView> paths,
+                                                   const LoadCallback& onComplete);
+
     /*!
     Returns a `String` containing the contents of the specified text file converted to UTF-8 with
     Unix-style newlines, or an empty `String` if the file could not be opened. The text file is
@@ -607,8 +700,9 @@ struct FileSystem {
     Owned<OutStream> openTextForWrite(StringView path, const TextFormat& textFormat);
 
     /*!
-    First, this function tries to load the raw contents of the specified file. If the load succeeds
-    and its raw contents match `contents` exactly, the function returns `Unchanged`. Otherwise, if
+    First, this function compares the raw contents of the specified file to `contents`. The file is
+    read incrementally and the comparison stops at the first difference, or before reading anything
+    if the file sizes differ. If they match exactly, the function returns `Unchanged`. Otherwise, if
     the parent directories of `path` don't exist, it attempts to create them. If that succeeds, it
     saves `contents` to a temporary file in the same folder as `path`. If that succeeds, it renames
     the temporary file to `path`, replacing any original contents.
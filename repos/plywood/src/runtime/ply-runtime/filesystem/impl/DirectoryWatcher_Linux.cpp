@@ -0,0 +1,178 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+
+#if PLY_KERNEL_LINUX
+
+#include <ply-runtime/filesystem/impl/DirectoryWatcher_Linux.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace ply {
+
+static constexpr u32 WatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO |
+                                 IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+static PLY_NO_INLINE u64 getMonotonicMillis() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return u64(ts.tv_sec) * 1000 + u64(ts.tv_nsec) / 1000000;
+}
+
+PLY_NO_INLINE void DirectoryWatcher_Linux::addWatches(StringView relDir) {
+    // inotify isn't recursive, so every subdirectory needs its own watch.
+    Array<String> stack;
+    stack.append(relDir);
+    WalkTriple triple;
+    while (!stack.isEmpty()) {
+        String relPath = std::move(stack.back());
+        stack.pop();
+        triple.dirPath = PosixPath::join(m_root, relPath);
+        int wd = inotify_add_watch(m_inotifyFD, triple.dirPath.withNullTerminator().bytes,
+                                   WatchMask);
+        if (wd < 0) {
+            // The directory was removed already, or the user's watch limit was reached
+            // (/proc/sys/fs/inotify/max_user_watches).
+            PLY_ASSERT(errno == ENOENT || errno == ENOTDIR || errno == ENOSPC || errno == EACCES);
+            continue;
+        }
+        // A directory that's already watched gets the same descriptor back.
+        m_watches.insertOrFind(wd)->relPath = relPath;
+        FileSystem::native()->listDirForWalk(triple, 0);
+        for (StringView dirName : triple.dirNames) {
+            stack.append(PosixPath::join(relPath, dirName));
+        }
+    }
+}
+
+PLY_NO_INLINE void DirectoryWatcher_Linux::addPending(StringView relPath, bool mustRecurse) {
+    auto cursor = m_pending.insertOrFind(relPath);
+    cursor->mustRecurse = cursor->mustRecurse || mustRecurse;
+}
+
+PLY_NO_INLINE void DirectoryWatcher_Linux::handleEvents(const char* buf, uptr numBytes) {
+    for (uptr pos = 0; pos < numBytes;) {
+        const inotify_event* event = (const inotify_event*) (buf + pos);
+        pos += sizeof(inotify_event) + event->len;
+
+        if ((event->mask & IN_Q_OVERFLOW) != 0) {
+            // Events were dropped. Everything under the root must be rescanned.
+            addPending({}, true);
+            continue;
+        }
+        auto cursor = m_watches.find(event->wd);
+        if (!cursor.wasFound())
+            continue;
+        if ((event->mask & IN_IGNORED) != 0) {
+            // The watched directory was removed, or it was moved out of the tree.
+            cursor.erase();
+            continue;
+        }
+        if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+            // The parent directory reports removals, except for the root itself.
+            if (cursor->relPath.isEmpty()) {
+                addPending({}, true);
+            }
+            continue;
+        }
+
+        // event->name is null-terminated and padded with null bytes.
+        String relPath = PosixPath::join(cursor->relPath, StringView{event->name});
+        if ((event->mask & IN_ISDIR) != 0) {
+            if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                // Files may have been added before the new watches were registered, so the caller
+                // has to rescan the directory.
+                addWatches(relPath);
+                addPending(relPath, true);
+            } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                addPending(relPath, true);
+            }
+        } else {
+            addPending(relPath, false);
+        }
+    }
+}
+
+PLY_NO_INLINE void DirectoryWatcher_Linux::runWatcher() {
+    alignas(inotify_event) char buf[16384];
+    u64 deadline = 0;
+    for (;;) {
+        int timeout = -1;
+        if (!m_pending.isEmpty()) {
+            u64 now = getMonotonicMillis();
+            timeout = now < deadline ? int(deadline - now) : 0;
+        }
+        struct pollfd fds[2] = {{m_endFD, POLLIN, 0}, {m_inotifyFD, POLLIN, 0}};
+        int rc = poll(fds, 2, timeout);
+        if (rc < 0) {
+            PLY_ASSERT(errno == EINTR);
+            continue;
+        }
+        if ((fds[0].revents & POLLIN) != 0)
+            break;
+
+        if ((fds[1].revents & POLLIN) != 0) {
+            ssize_t numBytes = read(m_inotifyFD, buf, sizeof(buf));
+            if (numBytes > 0) {
+                bool wasEmpty = m_pending.isEmpty();
+                handleEvents(buf, (uptr) numBytes);
+                if (wasEmpty) {
+                    deadline = getMonotonicMillis() + CoalesceMillis;
+                }
+            }
+        }
+        if (!m_pending.isEmpty() && getMonotonicMillis() >= deadline) {
+            // End of burst
+            for (const PendingTraits::Item& item : m_pending) {
+                m_callback(item.path, item.mustRecurse);
+            }
+            m_pending = HashMap<PendingTraits>{};
+        }
+    }
+}
+
+PLY_NO_INLINE DirectoryWatcher_Linux::DirectoryWatcher_Linux() {
+}
+
+PLY_NO_INLINE void DirectoryWatcher_Linux::start(StringView root, Functor<Callback>&& callback) {
+    PLY_ASSERT(m_root.isEmpty());
+    PLY_ASSERT(!m_callback.isValid());
+    PLY_ASSERT(m_inotifyFD < 0);
+    PLY_ASSERT(!m_watcherThread.isValid());
+    m_root = root;
+    m_callback = std::move(callback);
+    m_inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    PLY_ASSERT(m_inotifyFD >= 0);
+    m_endFD = eventfd(0, EFD_CLOEXEC);
+    PLY_ASSERT(m_endFD >= 0);
+    // Register the watches before returning, so that no change made after start() is missed.
+    addWatches({});
+    m_watcherThread.run([this]() { runWatcher(); });
+}
+
+PLY_NO_INLINE DirectoryWatcher_Linux::~DirectoryWatcher_Linux() {
+    if (m_watcherThread.isValid()) {
+        u64 value = 1;
+        ssize_t rc = write(m_endFD, &value, sizeof(value));
+        PLY_ASSERT(rc == sizeof(value));
+        PLY_UNUSED(rc);
+        m_watcherThread.join();
+    }
+    if (m_endFD >= 0) {
+        close(m_endFD);
+    }
+    if (m_inotifyFD >= 0) {
+        close(m_inotifyFD);
+    }
+}
+
+} // namespace ply
+
+#endif // PLY_KERNEL_LINUX
@@ -0,0 +1,74 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/string/String.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-runtime/container/Functor.h>
+#include <ply-runtime/container/HashMap.h>
+
+namespace ply {
+
+class DirectoryWatcher_Linux {
+public:
+    using Callback = void(StringView path, bool mustRecurse);
+
+    // Events that arrive within this many milliseconds of the first event in a burst are merged,
+    // and each changed path is passed to the callback once.
+    static constexpr u32 CoalesceMillis = 100;
+
+private:
+    // Maps inotify watch descriptors to directory paths relative to m_root.
+    struct WatchTraits {
+        using Key = s32;
+        struct Item {
+            s32 wd;
+            String relPath;
+            PLY_INLINE Item(s32 wd) : wd{wd} {
+            }
+        };
+        static PLY_INLINE bool match(const Item& item, s32 wd) {
+            return item.wd == wd;
+        }
+    };
+
+    // Changed paths waiting to be passed to the callback.
+    struct PendingTraits {
+        using Key = StringView;
+        struct Item {
+            String path;
+            bool mustRecurse = false;
+            PLY_INLINE Item(StringView path) : path{path} {
+            }
+        };
+        static PLY_INLINE bool match(const Item& item, StringView path) {
+            return item.path == path;
+        }
+    };
+
+    Thread m_watcherThread;
+    String m_root;
+    Functor<Callback> m_callback;
+    int m_inotifyFD = -1;
+    int m_endFD = -1; // eventfd that wakes the watcher thread when it's time to stop
+    HashMap<WatchTraits> m_watches;
+    HashMap<PendingTraits> m_pending;
+
+    void addWatches(StringView relDir);
+    void addPending(StringView relPath, bool mustRecurse);
+    void handleEvents(const char* buf, uptr numBytes);
+    void runWatcher();
+
+public:
+    PLY_DLL_ENTRY DirectoryWatcher_Linux();
+    PLY_DLL_ENTRY void start(StringView root, Functor<Callback>&& callback);
+    PLY_INLINE DirectoryWatcher_Linux(StringView root, Functor<Callback>&& callback)
+        : DirectoryWatcher_Linux{} {
+        start(root, std::move(callback));
+    }
+    PLY_DLL_ENTRY ~DirectoryWatcher_Linux();
+};
+
+} // namespace ply
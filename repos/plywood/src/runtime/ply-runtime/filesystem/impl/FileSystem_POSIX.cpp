@@ -8,7 +8,12 @@
 
 #include <ply-runtime/filesystem/impl/FileSystem_POSIX.h>
 #include <ply-runtime/io/impl/Pipe_FD.h>
+#if PLY_KERNEL_LINUX
+#include <ply-runtime/filesystem/impl/IOUring_Linux.h>
+#include <sys/syscall.h>
+#endif
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
@@ -24,6 +29,8 @@ PLY_NO_INLINE void FileSystem_POSIX::DirImpl::destructImpl(ply::Directory::Impl*
         PLY_ASSERT(rc == 0);
         PLY_UNUSED(rc);
     }
+    // DirImpl is deleted through the parent class, so destruct its members here.
+    ply::destruct(dirImpl->dirPath);
 }
 
 PLY_NO_INLINE FSResult FileSystem_POSIX::DirImpl::begin(StringView path) {
@@ -113,6 +120,120 @@ PLY_NO_INLINE Directory FileSystem_POSIX::listDir(FileSystem*, StringView path,
     return {dirImpl};
 }
 
+// Adds a single entry of the directory opened as dirFD to triple. type is a DT_* value from
+// struct dirent. Entries are stat'ed relative to dirFD, and only when necessary.
+static PLY_NO_INLINE void addWalkEntry(int dirFD, WalkTriple& triple, u32 flags, const char* name,
+                                       unsigned char type) {
+    if (name[0] == '.') {
+        if (name[1] == 0 || (name[1] == '.' && name[2] == 0))
+            return;
+    }
+
+    bool isDir = (type == DT_DIR);
+    struct stat buf;
+    bool haveStat = false;
+    if (type == DT_UNKNOWN || (!isDir && flags != 0)) {
+        if (fstatat(dirFD, name, &buf, 0) == 0) {
+            haveStat = true;
+            if (type == DT_UNKNOWN) {
+                isDir = S_ISDIR(buf.st_mode);
+            }
+        } else if (errno == ENOENT) {
+            // The entry was removed after it was enumerated.
+            return;
+        } else {
+            PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+            FileSystem::setLastResult(FSResult::Unknown);
+        }
+    }
+
+    if (isDir) {
+        triple.dirNames.append(name);
+    } else {
+        WalkTriple::FileInfo& file = triple.files.append();
+        file.name = name;
+        if (haveStat) {
+            if ((flags & FileSystem::WithSizes) != 0) {
+                file.fileSize = buf.st_size;
+            }
+            if ((flags & FileSystem::WithTimes) != 0) {
+                file.creationTime = buf.st_ctime;
+                file.accessTime = buf.st_atime;
+                file.modificationTime = buf.st_mtime;
+            }
+        }
+    }
+}
+
+PLY_NO_INLINE FSResult FileSystem_POSIX::listDirForWalk(FileSystem*, WalkTriple& triple,
+                                                        u32 flags) {
+    int dirFD = open(triple.dirPath.withNullTerminator().bytes,
+                     O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFD < 0) {
+        switch (errno) {
+            case ENOENT:
+            case ENOTDIR:
+                return FileSystem::setLastResult(FSResult::NotFound);
+            case EACCES:
+                return FileSystem::setLastResult(FSResult::AccessDenied);
+            default: {
+                PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+                return FileSystem::setLastResult(FSResult::Unknown);
+            }
+        }
+    }
+    FileSystem::setLastResult(FSResult::OK);
+
+#if PLY_KERNEL_LINUX
+    // Read many entries per system call directly into a local buffer.
+    struct linux_dirent64 {
+        u64 d_ino;
+        s64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+    alignas(linux_dirent64) char buf[8192];
+    for (;;) {
+        long numBytes = syscall(SYS_getdents64, dirFD, buf, sizeof(buf));
+        if (numBytes <= 0) {
+            if (numBytes < 0) {
+                PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+                FileSystem::setLastResult(FSResult::Unknown);
+            }
+            break;
+        }
+        for (long pos = 0; pos < numBytes;) {
+            linux_dirent64* de = (linux_dirent64*) (buf + pos);
+            addWalkEntry(dirFD, triple, flags, de->d_name, de->d_type);
+            pos += de->d_reclen;
+        }
+    }
+    close(dirFD);
+#else
+    DIR* dir = fdopendir(dirFD);
+    if (!dir) {
+        close(dirFD);
+        PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+        return FileSystem::setLastResult(FSResult::Unknown);
+    }
+    for (;;) {
+        errno = 0;
+        struct dirent* rde = readdir(dir);
+        if (!rde) {
+            if (errno != 0) {
+                PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+                FileSystem::setLastResult(FSResult::Unknown);
+            }
+            break;
+        }
+        addWalkEntry(dirFD, triple, flags, rde->d_name, rde->d_type);
+    }
+    closedir(dir);
+#endif
+    return FileSystem::lastResult_.load();
+}
+
 PLY_NO_INLINE FSResult FileSystem_POSIX::makeDir(FileSystem*, StringView path) {
     int rc = mkdir(path.withNullTerminator().bytes, mode_t(0755));
     if (rc == 0) {
@@ -312,10 +433,61 @@ PLY_NO_INLINE FileStatus FileSystem_POSIX::getFileStatus(FileSystem*, StringView
         status.creationTime = buf.st_ctime;
         status.accessTime = buf.st_atime;
         status.modificationTime = buf.st_mtime;
+        status.fileID = buf.st_ino;
     }
     return status;
 }
 
+PLY_NO_INLINE Reference<MappedFile> FileSystem_POSIX::mapFileForRead(FileSystem*,
+                                                                     StringView path) {
+    int fd = openFDForRead(path);
+    if (fd == -1)
+        return nullptr;
+    struct stat buf;
+    int rc = fstat(fd, &buf);
+    PLY_ASSERT(rc == 0);
+    PLY_UNUSED(rc);
+    Reference<MappedFile> result;
+    if (buf.st_size == 0) {
+        // mmap() fails on empty files.
+        result = new MappedFile;
+    } else {
+        void* addr = mmap(nullptr, (size_t) buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            PLY_ASSERT(PLY_FSPOSIX_ALLOW_UNKNOWN_ERRORS);
+            FileSystem::setLastResult(FSResult::Unknown);
+        } else {
+            result = MappedFile::adoptMapping((const char*) addr, (u64) buf.st_size);
+        }
+    }
+    // The mapping remains valid after the file descriptor is closed.
+    close(fd);
+    return result;
+}
+
+PLY_NO_INLINE void FileSystem_POSIX::loadManyAsync(FileSystem* fs,
+                                                  ArrayView<const StringView> paths,
+                                                  const LoadCallback& onComplete) {
+#if PLY_KERNEL_LINUX
+    Array<u32> unfinished;
+    if (loadManyUsingIOUring(paths, onComplete, &unfinished)) {
+        if (unfinished.isEmpty())
+            return;
+        // The ring failed partway through. Load the remaining files using threads.
+        Array<StringView> remainingPaths;
+        for (u32 index : unfinished) {
+            remainingPaths.append(paths[index]);
+        }
+        FileSystem::loadManyUsingThreads(
+            fs, remainingPaths, [&](u32 i, FSResult result, String&& contents) {
+                onComplete(unfinished[i], result, std::move(contents));
+            });
+        return;
+    }
+#endif
+    FileSystem::loadManyUsingThreads(fs, paths, onComplete);
+}
+
 FileSystem::Funcs FileSystemFuncs_POSIX = {
     {false},
     FileSystem_POSIX::listDir,
@@ -329,6 +501,9 @@ FileSystem::Funcs FileSystemFuncs_POSIX = {
     FileSystem_POSIX::deleteFile,
     FileSystem_POSIX::removeDirTree,
     FileSystem_POSIX::getFileStatus,
+    FileSystem_POSIX::mapFileForRead,
+    FileSystem_POSIX::loadManyAsync,
+    FileSystem_POSIX::listDirForWalk,
 };
 
 PLY_INLINE FileSystem_POSIX::FileSystem_POSIX() : FileSystem{&FileSystemFuncs_POSIX} {
@@ -41,6 +41,10 @@ struct FileSystem_POSIX : FileSystem {
     static FSResult deleteFile(FileSystem*, StringView path);
     static FSResult removeDirTree(FileSystem*, StringView dirPath);
     static FileStatus getFileStatus(FileSystem*, StringView path);
+    static Reference<MappedFile> mapFileForRead(FileSystem*, StringView path);
+    static void loadManyAsync(FileSystem* fs, ArrayView<const StringView> paths,
+                              const LoadCallback& onComplete);
+    static FSResult listDirForWalk(FileSystem*, WalkTriple& triple, u32 flags);
 
     FileSystem_POSIX();
 };
@@ -77,6 +77,23 @@ struct FileSystem_Virtual : FileSystem {
         FileSystem_Virtual* fs = static_cast<FileSystem_Virtual*>(fs_);
         return fs->targetFS->getFileStatus(fs->convertToTargetPath(path));
     }
+
+    static PLY_NO_INLINE Reference<MappedFile> mapFileForRead(FileSystem* fs_, StringView path) {
+        FileSystem_Virtual* fs = static_cast<FileSystem_Virtual*>(fs_);
+        return fs->targetFS->mapFileForRead(fs->convertToTargetPath(path));
+    }
+
+    static PLY_NO_INLINE void loadManyAsync(FileSystem* fs_, ArrayView<const StringView> paths,
+                                            const LoadCallback& onComplete) {
+        FileSystem_Virtual* fs = static_cast<FileSystem_Virtual*>(fs_);
+        Array<String> targetPaths;
+        Array<StringView> targetPathViews;
+        for (StringView path : paths) {
+            StringView targetPath = targetPaths.append(fs->convertToTargetPath(path));
+            targetPathViews.append(targetPath);
+        }
+        fs->targetFS->loadManyAsync(targetPathViews, onComplete);
+    }
 };
 
 FileSystem::Funcs FileSystemFuncs_Virtual = {
@@ -92,6 +109,8 @@ FileSystem::Funcs FileSystemFuncs_Virtual = {
     FileSystem_Virtual::deleteFile,
     FileSystem_Virtual::removeDirTree,
     FileSystem_Virtual::getFileStatus,
+    FileSystem_Virtual::mapFileForRead,
+    FileSystem_Virtual::loadManyAsync,
 };
 
 PLY_INLINE FileSystem_Virtual::FileSystem_Virtual() : FileSystem{&FileSystemFuncs_Virtual} {
@@ -360,6 +360,11 @@ PLY_NO_INLINE void FileSystem_Win32::getFileStatus(HANDLE handle, FileStatus& st
         status.result = FSResult::Unknown;
     }
 
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(handle, &info)) {
+        status.fileID = (u64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    }
+
     FileSystem::setLastResult(status.result);
 }
 
@@ -376,6 +381,40 @@ PLY_NO_INLINE FileStatus FileSystem_Win32::getFileStatus(FileSystem*, StringView
     return status;
 }
 
+PLY_NO_INLINE Reference<MappedFile> FileSystem_Win32::mapFileForRead(FileSystem*,
+                                                                     StringView path) {
+    HANDLE handle = openHandleForRead(path);
+    if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+    LARGE_INTEGER fileSize;
+    BOOL rc = GetFileSizeEx(handle, &fileSize);
+    PLY_ASSERT(rc != 0);
+    Reference<MappedFile> result;
+    if (fileSize.QuadPart == 0) {
+        // CreateFileMapping() fails on empty files.
+        result = new MappedFile;
+    } else {
+        HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        const char* bytes = nullptr;
+        if (mapping) {
+            bytes = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            // The view keeps the mapping object alive.
+            rc = CloseHandle(mapping);
+            PLY_ASSERT(rc != 0);
+        }
+        if (bytes) {
+            result = MappedFile::adoptMapping(bytes, (u64) fileSize.QuadPart);
+        } else {
+            PLY_ASSERT(PLY_FSWIN32_ALLOW_UKNOWN_ERRORS);
+            FileSystem::setLastResult(FSResult::Unknown);
+        }
+    }
+    rc = CloseHandle(handle);
+    PLY_ASSERT(rc != 0);
+    PLY_UNUSED(rc);
+    return result;
+}
+
 FileSystem::Funcs FileSystemFuncs_Win32 = {
     {true},
     FileSystem_Win32::listDir,
@@ -389,6 +428,8 @@ FileSystem::Funcs FileSystemFuncs_Win32 = {
     FileSystem_Win32::deleteFile,
     FileSystem_Win32::removeDirTree,
     FileSystem_Win32::getFileStatus,
+    FileSystem_Win32::mapFileForRead,
+    FileSystem::loadManyUsingThreads,
 };
 
 PLY_INLINE FileSystem_Win32::FileSystem_Win32() : FileSystem{&FileSystemFuncs_Win32} {
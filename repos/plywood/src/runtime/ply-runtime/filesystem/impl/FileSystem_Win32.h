@@ -46,6 +46,7 @@ struct FileSystem_Win32 : FileSystem {
     static FSResult deleteFile(FileSystem*, StringView path);
     static FSResult removeDirTree(FileSystem*, StringView dirPath);
     static FileStatus getFileStatus(FileSystem*, StringView path);
+    static Reference<MappedFile> mapFileForRead(FileSystem*, StringView path);
 
     FileSystem_Win32();
 };
@@ -0,0 +1,393 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+
+#if PLY_KERNEL_LINUX
+
+#include <ply-runtime/filesystem/impl/IOUring_Linux.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace ply {
+
+#if defined(__NR_io_uring_setup)
+
+//------------------------------------------------------------------
+// IOUring
+//------------------------------------------------------------------
+PLY_NO_INLINE bool IOUring::init(u32 numEntries) {
+    PLY_ASSERT(this->ringFD < 0);
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int) syscall(__NR_io_uring_setup, numEntries, &params);
+    if (fd < 0)
+        return false;
+    this->ringFD = fd;
+    this->numEntries = params.sq_entries;
+
+    this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+    this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        this->sqRingSize = max(this->sqRingSize, this->cqRingSize);
+    }
+    void* sqRing = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+        return false;
+    this->sqRing = sqRing;
+    if (singleMmap) {
+        this->cqRing = sqRing;
+    } else {
+        void* cqRing = mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+            return false;
+        this->cqRing = cqRing;
+    }
+    void* sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    this->sqes = (io_uring_sqe*) sqes;
+
+    char* sq = (char*) this->sqRing;
+    this->sqHead = (u32*) (sq + params.sq_off.head);
+    this->sqTail = (u32*) (sq + params.sq_off.tail);
+    this->sqMask = *(u32*) (sq + params.sq_off.ring_mask);
+    this->sqArray = (u32*) (sq + params.sq_off.array);
+    char* cq = (char*) this->cqRing;
+    this->cqHead = (u32*) (cq + params.cq_off.head);
+    this->cqTail = (u32*) (cq + params.cq_off.tail);
+    this->cqMask = *(u32*) (cq + params.cq_off.ring_mask);
+    this->cqes = (io_uring_cqe*) (cq + params.cq_off.cqes);
+    return true;
+}
+
+PLY_NO_INLINE IOUring::~IOUring() {
+    if (this->sqes) {
+        munmap(this->sqes, this->numEntries * sizeof(io_uring_sqe));
+    }
+    if (this->cqRing && this->cqRing != this->sqRing) {
+        munmap(this->cqRing, this->cqRingSize);
+    }
+    if (this->sqRing) {
+        munmap(this->sqRing, this->sqRingSize);
+    }
+    if (this->ringFD >= 0) {
+        close(this->ringFD);
+    }
+}
+
+PLY_NO_INLINE io_uring_sqe* IOUring::getSQE() {
+    // The kernel only advances sqHead, so the tail can be read without synchronization.
+    u32 tail = *this->sqTail + this->numUnsubmitted;
+    PLY_ASSERT(tail - __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE) < this->numEntries);
+    u32 index = tail & this->sqMask;
+    io_uring_sqe* sqe = &this->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    this->sqArray[index] = index;
+    this->numUnsubmitted++;
+    return sqe;
+}
+
+PLY_NO_INLINE int IOUring::submitAndWait(u32 minComplete) {
+    // Publish the new entries to the kernel. Also resubmit any entries that the kernel didn't
+    // consume last time.
+    u32 tail = *this->sqTail + this->numUnsubmitted;
+    __atomic_store_n(this->sqTail, tail, __ATOMIC_RELEASE);
+    this->numUnsubmitted = 0;
+    for (;;) {
+        u32 numToSubmit = tail - __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+        long rc = syscall(__NR_io_uring_enter, this->ringFD, numToSubmit, minComplete,
+                          IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (rc >= 0)
+            return 0;
+        if (errno != EINTR)
+            return errno;
+        // Interrupted by a signal. Try again.
+    }
+}
+
+PLY_NO_INLINE io_uring_sqe* IOUring::withdrawSQE() {
+    // The kernel only consumes entries inside io_uring_enter, which isn't running, so the tail can
+    // safely move backwards.
+    PLY_ASSERT(this->numUnsubmitted == 0);
+    u32 tail = *this->sqTail;
+    if (tail == __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE))
+        return nullptr;
+    tail--;
+    __atomic_store_n(this->sqTail, tail, __ATOMIC_RELEASE);
+    return &this->sqes[this->sqArray[tail & this->sqMask]];
+}
+
+PLY_NO_INLINE io_uring_cqe* IOUring::peekCQE() {
+    u32 head = *this->cqHead;
+    if (head == __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE))
+        return nullptr;
+    return &this->cqes[head & this->cqMask];
+}
+
+PLY_NO_INLINE void IOUring::popCQE() {
+    __atomic_store_n(this->cqHead, *this->cqHead + 1, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------
+// loadManyUsingIOUring
+//------------------------------------------------------------------
+namespace {
+
+struct LoadOp {
+    enum Stage {
+        Open,
+        Stat,
+        Read,
+        Close,
+    };
+
+    u32 index = 0;
+    bool isActive = false;
+    Stage stage = Open;
+    int fd = -1;
+    HybridString path;
+    struct statx stx;
+    String contents;
+    u32 numBytesRead = 0;
+    FSResult result = FSResult::OK;
+};
+
+FSResult resultFromErrno(int err) {
+    switch (err) {
+        case ENOENT:
+        case ENOTDIR:
+            return FSResult::NotFound;
+        case EACCES:
+        case EPERM:
+            return FSResult::AccessDenied;
+        default:
+            return FSResult::Unknown;
+    }
+}
+
+void queueOp(IOUring& ring, LoadOp* op) {
+    io_uring_sqe* sqe = ring.getSQE();
+    sqe->user_data = (u64) op;
+    switch (op->stage) {
+        case LoadOp::Open: {
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (u64) op->path.bytes;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            break;
+        }
+        case LoadOp::Stat: {
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = op->fd;
+            sqe->addr = (u64) "";
+            sqe->len = STATX_SIZE;
+            sqe->statx_flags = AT_EMPTY_PATH;
+            sqe->off = (u64) &op->stx;
+            break;
+        }
+        case LoadOp::Read: {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = op->fd;
+            sqe->addr = (u64) (op->contents.bytes + op->numBytesRead);
+            sqe->len = op->contents.numBytes - op->numBytesRead;
+            sqe->off = op->numBytesRead;
+            break;
+        }
+        case LoadOp::Close: {
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = op->fd;
+            break;
+        }
+    }
+}
+
+void failOp(IOUring& ring, LoadOp* op, FSResult result) {
+    op->result = result;
+    op->contents.clear();
+    op->stage = LoadOp::Close;
+    queueOp(ring, op);
+}
+
+// Advances an operation to its next stage. Returns true when the operation is finished and its
+// callback can be invoked.
+bool handleCompletion(IOUring& ring, LoadOp* op, s32 res) {
+    switch (op->stage) {
+        case LoadOp::Open: {
+            if (res == -EINVAL) {
+                // This kernel supports io_uring but not IORING_OP_OPENAT (added in Linux 5.6).
+                // Load the file synchronously instead.
+                op->contents = FileSystem::native()->loadBinary(op->path);
+                op->result = FileSystem::native()->lastResult();
+                return true;
+            }
+            if (res < 0) {
+                op->result = resultFromErrno(-res);
+                return true;
+            }
+            op->fd = res;
+            op->stage = LoadOp::Stat;
+            queueOp(ring, op);
+            return false;
+        }
+        case LoadOp::Stat: {
+            if (res < 0) {
+                failOp(ring, op, resultFromErrno(-res));
+                return false;
+            }
+            // Files >= 4GB cannot be loaded this way:
+            op->contents.resize(safeDemote<u32>(op->stx.stx_size));
+            op->stage = op->contents.numBytes > 0 ? LoadOp::Read : LoadOp::Close;
+            queueOp(ring, op);
+            return false;
+        }
+        case LoadOp::Read: {
+            if (res < 0) {
+                failOp(ring, op, resultFromErrno(-res));
+                return false;
+            }
+            op->numBytesRead += (u32) res;
+            if (res == 0) {
+                // The file was truncated since it was stat'ed.
+                op->contents.resize(op->numBytesRead);
+            } else if (op->numBytesRead < op->contents.numBytes) {
+                // Short read
+                queueOp(ring, op);
+                return false;
+            }
+            op->stage = LoadOp::Close;
+            queueOp(ring, op);
+            return false;
+        }
+        case LoadOp::Close: {
+            op->fd = -1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Called after the ring fails. Makes sure that the kernel will no longer access any LoadOp, so
+// that they can be destroyed, and closes any files that are still open. Returns false if the
+// operations that the kernel already accepted can't be waited for.
+bool abandonOps(IOUring& ring, ArrayView<LoadOp> slots) {
+    while (io_uring_sqe* sqe = ring.withdrawSQE()) {
+        ((LoadOp*) sqe->user_data)->isActive = false;
+    }
+    u32 numInFlight = 0;
+    for (const LoadOp& op : slots) {
+        numInFlight += op.isActive;
+    }
+    for (;;) {
+        while (io_uring_cqe* cqe = ring.peekCQE()) {
+            LoadOp* op = (LoadOp*) cqe->user_data;
+            if (op->stage == LoadOp::Open && cqe->res >= 0) {
+                op->fd = cqe->res;
+            } else if (op->stage == LoadOp::Close) {
+                op->fd = -1;
+            }
+            op->isActive = false;
+            numInFlight--;
+            ring.popCQE();
+        }
+        if (numInFlight == 0)
+            break;
+        if (ring.submitAndWait(1) != 0)
+            return false;
+    }
+    for (const LoadOp& op : slots) {
+        if (op.fd >= 0) {
+            close(op.fd);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+PLY_NO_INLINE bool loadManyUsingIOUring(ArrayView<const StringView> paths,
+                                        const FileSystem::LoadCallback& onComplete,
+                                        Array<u32>* unfinished) {
+    // Each file has at most one operation in flight, so this is also the maximum number of files
+    // being loaded at once.
+    static constexpr u32 MaxInFlight = 64;
+
+    IOUring ring;
+    if (!ring.init(MaxInFlight))
+        return false;
+
+    u32 numSlots = min(paths.numItems, ring.numEntries);
+    Array<LoadOp> slots;
+    slots.resize(numSlots);
+    Array<LoadOp*> freeSlots;
+    for (LoadOp& op : slots) {
+        freeSlots.append(&op);
+    }
+
+    u32 nextPath = 0;
+    u32 numCompleted = 0;
+    while (numCompleted < paths.numItems) {
+        while (nextPath < paths.numItems && !freeSlots.isEmpty()) {
+            LoadOp* op = freeSlots.back();
+            freeSlots.pop();
+            op->index = nextPath;
+            op->isActive = true;
+            op->stage = LoadOp::Open;
+            op->fd = -1;
+            op->path = paths[nextPath].withNullTerminator();
+            op->numBytesRead = 0;
+            op->result = FSResult::OK;
+            queueOp(ring, op);
+            nextPath++;
+        }
+        if (ring.submitAndWait(1) != 0) {
+            for (const LoadOp& op : slots) {
+                if (op.isActive) {
+                    unfinished->append(op.index);
+                }
+            }
+            for (; nextPath < paths.numItems; nextPath++) {
+                unfinished->append(nextPath);
+            }
+            if (!abandonOps(ring, slots)) {
+                // The kernel may still write to the LoadOps, so leak them.
+                slots.release();
+            }
+            return true;
+        }
+        while (io_uring_cqe* cqe = ring.peekCQE()) {
+            LoadOp* op = (LoadOp*) cqe->user_data;
+            s32 res = cqe->res;
+            ring.popCQE();
+            if (handleCompletion(ring, op, res)) {
+                onComplete(op->index, op->result, std::move(op->contents));
+                op->contents.clear();
+                op->isActive = false;
+                freeSlots.append(op);
+                numCompleted++;
+            }
+        }
+    }
+    return true;
+}
+
+#else // No io_uring system calls in these kernel headers
+
+PLY_NO_INLINE bool loadManyUsingIOUring(ArrayView<const StringView>,
+                                        const FileSystem::LoadCallback&, Array<u32>*) {
+    return false;
+}
+
+#endif
+
+} // namespace ply
+
+#endif // PLY_KERNEL_LINUX
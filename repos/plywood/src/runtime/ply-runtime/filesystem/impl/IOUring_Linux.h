@@ -0,0 +1,73 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#endif
+
+namespace ply {
+
+#if defined(__NR_io_uring_setup)
+
+//------------------------------------------------------------------
+// IOUring
+//
+// A minimal wrapper around the io_uring system calls, so that liburing isn't required. Submission
+// and completion queues are only accessed from the thread that owns the ring.
+//------------------------------------------------------------------
+struct IOUring {
+    int ringFD = -1;
+    u32 numEntries = 0;
+
+    // Submission queue
+    void* sqRing = nullptr;
+    uptr sqRingSize = 0;
+    u32* sqHead = nullptr;
+    u32* sqTail = nullptr;
+    u32 sqMask = 0;
+    u32* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    u32 numUnsubmitted = 0;
+
+    // Completion queue
+    void* cqRing = nullptr;
+    uptr cqRingSize = 0;
+    u32* cqHead = nullptr;
+    u32* cqTail = nullptr;
+    u32 cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Returns false if io_uring isn't supported by the kernel or is blocked by a seccomp filter.
+    bool init(u32 numEntries);
+    ~IOUring();
+
+    // Returns a zeroed submission queue entry. The caller must not queue more than numEntries
+    // operations between calls to submitAndWait().
+    io_uring_sqe* getSQE();
+    // Submits all queued entries and waits until at least minComplete operations have completed.
+    // Returns 0 on success, or an errno value if io_uring_enter failed for any reason other than a
+    // signal. After a failure, entries that the kernel didn't consume remain in the queue.
+    int submitAndWait(u32 minComplete);
+    // Takes back the most recently submitted entry that the kernel hasn't consumed yet, so that it
+    // will never be executed. Returns nullptr if there's no such entry.
+    io_uring_sqe* withdrawSQE();
+    // Returns the next completion, or nullptr. Call popCQE() after handling it.
+    io_uring_cqe* peekCQE();
+    void popCQE();
+};
+
+#endif
+
+// Implements FileSystem::loadManyAsync() by submitting openat, statx, read and close operations
+// for many files to a single IOUring. Returns false, without invoking any callbacks, if io_uring
+// is unavailable. If the ring fails partway through, the indices of the files whose callbacks
+// weren't invoked are appended to unfinished, so that the caller can load them another way.
+bool loadManyUsingIOUring(ArrayView<const StringView> paths,
+                          const FileSystem::LoadCallback& onComplete, Array<u32>* unfinished);
+
+} // namespace ply
@@ -385,6 +385,9 @@ struct ViewInStream : InStream {
         this->reserved = nullptr;
     }
 
+    PLY_INLINE ViewInStream(ViewInStream&& other) : InStream{std::move(other)} {
+    }
+
     PLY_INLINE ~ViewInStream() {
         PLY_ASSERT(this->isView());
         // This lets the compiler optimize away the call to destructInternal():
@@ -0,0 +1,89 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/io/MappedFile.h>
+#if PLY_TARGET_POSIX
+#include <sys/mman.h>
+#endif
+
+namespace ply {
+
+//------------------------------------------------------------------
+// MappedFile
+//------------------------------------------------------------------
+PLY_NO_INLINE void MappedFile::onRefCountZero() {
+    if (this->bytes && !this->heapBytes) {
+#if PLY_TARGET_POSIX
+        int rc = munmap((void*) this->bytes, (size_t) this->numBytes);
+        PLY_ASSERT(rc == 0);
+        PLY_UNUSED(rc);
+#elif PLY_TARGET_WIN32
+        BOOL rc = UnmapViewOfFile(this->bytes);
+        PLY_ASSERT(rc);
+        PLY_UNUSED(rc);
+#else
+        PLY_ASSERT(0); // No file mapping API on this platform
+#endif
+    }
+    delete this;
+}
+
+PLY_NO_INLINE Reference<MappedFile> MappedFile::adoptMapping(const char* bytes, u64 numBytes) {
+    MappedFile* file = new MappedFile;
+    file->bytes = bytes;
+    file->numBytes = numBytes;
+    return file;
+}
+
+PLY_NO_INLINE Reference<MappedFile> MappedFile::adoptString(String&& str) {
+    MappedFile* file = new MappedFile;
+    file->heapBytes = std::move(str);
+    file->bytes = file->heapBytes.bytes;
+    file->numBytes = file->heapBytes.numBytes;
+    return file;
+}
+
+PLY_NO_INLINE ViewInStream MappedFile::createInStream() const {
+    // Set the pointers directly, since a StringView can't describe a file larger than 4 GB.
+    ViewInStream vins;
+    vins.startByte = this->bytes;
+    vins.curByte = this->bytes;
+    vins.endByte = this->bytes + this->numBytes;
+    return vins;
+}
+
+//------------------------------------------------------------------
+// InPipe_Mapped
+//------------------------------------------------------------------
+PLY_NO_INLINE void InPipe_Mapped_destroy(InPipe* inPipe_) {
+    InPipe_Mapped* inPipe = static_cast<InPipe_Mapped*>(inPipe_);
+    destruct(inPipe->file);
+}
+
+PLY_NO_INLINE u32 InPipe_Mapped_readSome(InPipe* inPipe_, MutableStringView buf) {
+    InPipe_Mapped* inPipe = static_cast<InPipe_Mapped*>(inPipe_);
+    PLY_ASSERT(inPipe->offset <= inPipe->file->numBytes);
+    u32 numBytes = (u32) min<u64>(buf.numBytes, inPipe->file->numBytes - inPipe->offset);
+    memcpy(buf.bytes, inPipe->file->bytes + inPipe->offset, numBytes);
+    inPipe->offset += numBytes;
+    return numBytes;
+}
+
+PLY_NO_INLINE u64 InPipe_Mapped_getFileSize(const InPipe* inPipe_) {
+    const InPipe_Mapped* inPipe = static_cast<const InPipe_Mapped*>(inPipe_);
+    return inPipe->file->numBytes;
+}
+
+InPipe::Funcs InPipe_Mapped::Funcs_ = {
+    InPipe_Mapped_destroy,
+    InPipe_Mapped_readSome,
+    InPipe_Mapped_getFileSize,
+};
+
+PLY_NO_INLINE InPipe_Mapped::InPipe_Mapped(Reference<MappedFile>&& file)
+    : InPipe{&Funcs_}, file{std::move(file)} {
+}
+
+} // namespace ply
@@ -0,0 +1,73 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/container/Reference.h>
+#include <ply-runtime/io/Pipe.h>
+#include <ply-runtime/io/InStream.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+A `MappedFile` holds the read-only contents of a file that was mapped into memory by
+`FileSystem::mapFileForRead()`. The mapping is reference-counted: it stays valid, along with any
+`StringView` or `ViewInStream` pointing into it, for as long as a `Reference<MappedFile>` exists.
+
+Unlike `FileSystem::loadBinary()`, mapping a file doesn't copy its contents to the heap, and files
+larger than 4 GB are supported. Pages are loaded on demand by the operating system.
+
+When the file system can't map files, `mapFileForRead()` falls back to loading the file into a
+`String` owned by the `MappedFile`, so callers don't need to handle both cases.
+*/
+struct MappedFile : RefCounted<MappedFile> {
+    const char* bytes = nullptr;
+    u64 numBytes = 0;
+    String heapBytes; // Owns the bytes when the file was loaded instead of mapped
+
+    PLY_DLL_ENTRY void onRefCountZero();
+
+    /*!
+    Takes ownership of a region returned by the platform's file mapping API, such as `mmap()` or
+    `MapViewOfFile()`. The region is unmapped when the last reference goes away.
+    */
+    static PLY_DLL_ENTRY Reference<MappedFile> adoptMapping(const char* bytes, u64 numBytes);
+
+    /*!
+    Wraps the contents of a `String` that was loaded into memory.
+    */
+    static PLY_DLL_ENTRY Reference<MappedFile> adoptString(String&& str);
+
+    /*!
+    Returns a `StringView` of the entire file. The file must be smaller than 4 GB; for larger files,
+    use `createInStream()` or access `bytes` directly.
+    */
+    PLY_INLINE StringView view() const {
+        return {this->bytes, safeDemote<u32>(this->numBytes)};
+    }
+
+    /*!
+    Returns a `ViewInStream` that reads directly from the mapping without copying. The caller must
+    keep a reference to the `MappedFile` for as long as the `ViewInStream`, and anything parsed
+    from it, is in use.
+    */
+    PLY_DLL_ENTRY ViewInStream createInStream() const;
+};
+
+//------------------------------------------------------------------
+// InPipe_Mapped
+//
+// An InPipe that reads from a MappedFile, for code that expects an InPipe. Each readSome() is a
+// memcpy from the mapping, with no system call.
+//------------------------------------------------------------------
+struct InPipe_Mapped : InPipe {
+    static Funcs Funcs_;
+    Reference<MappedFile> file;
+    u64 offset = 0;
+
+    PLY_DLL_ENTRY InPipe_Mapped(Reference<MappedFile>&& file);
+};
+
+} // namespace ply
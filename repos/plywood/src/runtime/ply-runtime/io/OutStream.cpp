@@ -55,23 +55,53 @@ PLY_NO_INLINE void OutStream::destructInternal() {
     }
 }
 
+// When the OutPipe supports writeMany(), up to this many full blocks are kept in memory so that
+// they can be written to the OutPipe using a single call.
+static constexpr u32 MaxGatheredBlocks = 16;
+
 PLY_NO_INLINE bool OutStream::flushInternal() {
     if (this->status.type == (u32) Type::View)
         return true;
 
-    // this->block->numBytesUsed is the last flushed offset
     PLY_ASSERT(this->endByte == this->block->bytes + this->block->blockSize);
     u32 newWritePos = safeDemote<u32>(this->curByte - this->block->bytes);
     PLY_ASSERT(newWritePos >= this->block->numBytesUsed);
     PLY_ASSERT(newWritePos <= this->block->blockSize);
-    if (newWritePos > this->block->numBytesUsed) {
-        if (this->status.type == (u32) Type::Pipe && this->status.eof == 0) {
-            if (!this->outPipe->write({this->block->bytes + this->block->numBytesUsed,
-                                       newWritePos - this->block->numBytesUsed})) {
+    this->block->numBytesUsed = newWritePos;
+    if (this->status.type != (u32) Type::Pipe)
+        return true;
+
+    // In a pipe stream, the unflushed bytes of each block are viewUsedBytes(). If blocks were
+    // gathered by tryMakeBytesAvailableInternal(), the first unflushed block is found by
+    // following prevBlock.
+    BlockList::Footer* headBlock = this->block;
+    while (headBlock->prevBlock) {
+        headBlock = headBlock->prevBlock;
+    }
+    if (this->status.eof == 0) {
+        if (headBlock == this->block) {
+            StringView view = this->block->viewUsedBytes();
+            if (view.numBytes > 0 && !this->outPipe->write(view)) {
+                this->status.eof = 1;
+            }
+        } else {
+            StringView views[MaxGatheredBlocks + 1];
+            u32 numViews = 0;
+            for (BlockList::Footer* b = headBlock; b; b = b->nextBlock) {
+                PLY_ASSERT(numViews < PLY_STATIC_ARRAY_SIZE(views));
+                views[numViews++] = b->viewUsedBytes();
+            }
+            if (!this->outPipe->writeMany({views, numViews})) {
                 this->status.eof = 1;
             }
         }
-        this->block->numBytesUsed = newWritePos;
+    }
+    this->block->startOffset = this->block->numBytesUsed;
+    if (headBlock != this->block) {
+        // Free every block before the current one. headBlock's only reference was added in
+        // tryMakeBytesAvailableInternal().
+        headBlock->decRef();
+        PLY_ASSERT(!this->block->prevBlock);
     }
 
     return this->status.eof == 0;
@@ -118,6 +148,28 @@ PLY_NO_INLINE u32 OutStream::tryMakeBytesAvailableInternal(s32 numBytes) {
         return 0;
     }
 
+    if (this->status.type == (u32) Type::Pipe && this->status.eof == 0 &&
+        this->outPipe->canWriteMany()) {
+        // Keep the full block in memory and write it later, along with the blocks that follow it.
+        u32 numPendingBlocks = 1;
+        for (BlockList::Footer* b = this->block->prevBlock; b; b = b->prevBlock) {
+            numPendingBlocks++;
+        }
+        if (numPendingBlocks < MaxGatheredBlocks) {
+            this->block->numBytesUsed = safeDemote<u32>(this->curByte - this->block->bytes);
+            if (!this->block->prevBlock) {
+                // This is the first pending block. The reference added here keeps the pending
+                // blocks alive until flushInternal() releases it.
+                this->block->incRef();
+            }
+            this->block = BlockList::appendBlock(this->block,
+                                                 max(this->getBlockSize(), (u32) abs(numBytes)));
+            this->curByte = this->block->bytes;
+            this->endByte = this->block->bytes + this->block->blockSize;
+            return this->block->blockSize;
+        }
+    }
+
     if (!this->flushInternal() && numBytes > 0) {
         this->endByte = this->curByte;
         return 0;
@@ -146,6 +198,33 @@ PLY_NO_INLINE bool OutStream::writeSlowPath(StringView src) {
     return true;
 }
 
+PLY_NO_INLINE bool OutStream::transferFrom(InPipe* src, u64 numBytes) {
+    if (this->status.type == (u32) Type::Pipe && this->outPipe->funcs->transferFrom) {
+        if (!this->flushInternal())
+            return false;
+        if (!this->outPipe->transferFrom(src, numBytes)) {
+            this->status.eof = 1;
+            return false;
+        }
+        // The transferred bytes bypassed the internal buffer, so advance the seek position to
+        // account for them.
+        this->block->fileOffset += numBytes;
+        return true;
+    }
+
+    while (numBytes > 0) {
+        if (!this->tryMakeBytesAvailable())
+            return false;
+        u32 numBytesRead =
+            src->readSome({this->curByte, (u32) min<u64>(numBytes, this->numBytesAvailable())});
+        if (numBytesRead == 0)
+            return false;
+        this->curByte += numBytesRead;
+        numBytes -= numBytesRead;
+    }
+    return true;
+}
+
 //------------------------------------------------------------------
 // MemOutStream
 //------------------------------------------------------------------
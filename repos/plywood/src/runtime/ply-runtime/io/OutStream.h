@@ -241,6 +241,16 @@ public:
         return this->status.eof == 0;
     }
 
+    /*!
+    Reads `numBytes` bytes from `src` and writes them to the output stream. Returns `true` if
+    successful, or `false` if `src` reached EOF early or the write failed.
+
+    If the `OutStream` writes to an `OutPipe`, any buffered data is flushed, then the transfer is
+    delegated to `OutPipe::transferFrom()`, which lets the kernel send files to sockets without
+    copying them to user space. Otherwise, the data is read directly into the internal buffer.
+    */
+    PLY_DLL_ENTRY bool transferFrom(InPipe* src, u64 numBytes);
+
 private:
     struct Arg {
         void (*formatter)(OutStream*, const void*) = nullptr;
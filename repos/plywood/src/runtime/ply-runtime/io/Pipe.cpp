@@ -30,4 +30,25 @@ PLY_NO_INLINE u64 OutPipe::seek_Empty(OutPipe*, s64, SeekDir) {
     return 0;
 }
 
+PLY_NO_INLINE bool OutPipe::writeMany_Fallback(OutPipe* outPipe, ArrayView<const StringView> bufs) {
+    for (StringView buf : bufs) {
+        if (!outPipe->write(buf))
+            return false;
+    }
+    return true;
+}
+
+PLY_NO_INLINE bool OutPipe::transferFrom_Fallback(OutPipe* outPipe, InPipe* src, u64 numBytes) {
+    char buf[8192];
+    while (numBytes > 0) {
+        u32 numBytesRead = src->readSome({buf, (u32) min<u64>(numBytes, sizeof(buf))});
+        if (numBytesRead == 0)
+            return false;
+        if (!outPipe->write({buf, numBytesRead}))
+            return false;
+        numBytes -= numBytesRead;
+    }
+    return true;
+}
+
 } // namespace ply
@@ -5,6 +5,7 @@
 #pragma once
 #include <ply-runtime/Core.h>
 #include <ply-runtime/string/StringView.h>
+#include <ply-runtime/container/ArrayView.h>
 
 namespace ply {
 
@@ -101,6 +102,10 @@ struct OutPipe {
         bool (*write)(OutPipe*, StringView) = nullptr;
         bool (*flush)(OutPipe*, bool) = nullptr;
         u64 (*seek)(OutPipe*, s64, SeekDir) = nullptr;
+        // Optional. If nullptr, writeMany() calls write() once for each view.
+        bool (*writeMany)(OutPipe*, ArrayView<const StringView>) = nullptr;
+        // Optional. If nullptr, transferFrom() copies through a buffer on the stack.
+        bool (*transferFrom)(OutPipe*, InPipe*, u64) = nullptr;
     };
 
     Funcs* funcs = nullptr;
@@ -133,6 +138,41 @@ struct OutPipe {
         return this->funcs->write(this, buf);
     }
 
+    /*!
+    Writes the contents of several buffers, in order, as if `write()` was called for each one. When
+    the `OutPipe` writes to a POSIX file descriptor, all the buffers are passed to a single
+    `writev()` system call. Returns `true` if successful.
+
+    `OutStream` uses this function to write several blocks of buffered data at once.
+    */
+    PLY_INLINE bool writeMany(ArrayView<const StringView> bufs) {
+        if (this->funcs->writeMany)
+            return this->funcs->writeMany(this, bufs);
+        return writeMany_Fallback(this, bufs);
+    }
+
+    /*!
+    Returns `true` if the `OutPipe` implements `writeMany()` more efficiently than by calling
+    `write()` for each buffer.
+    */
+    PLY_INLINE bool canWriteMany() const {
+        return this->funcs->writeMany != nullptr;
+    }
+
+    /*!
+    Reads `numBytes` bytes from `src` and writes them to this `OutPipe`. Returns `true` if
+    successful, or `false` if `src` reached EOF early or the write failed.
+
+    When `src` is an `InPipe_FD` reading from a file and this `OutPipe` is an `OutPipe_FD`, such as
+    a TCP socket, the data is transferred by the kernel using `sendfile()` on Linux, without being
+    copied to user space. Otherwise, the data is copied through a small buffer on the stack.
+    */
+    PLY_INLINE bool transferFrom(InPipe* src, u64 numBytes) {
+        if (this->funcs->transferFrom)
+            return this->funcs->transferFrom(this, src, numBytes);
+        return transferFrom_Fallback(this, src, numBytes);
+    }
+
     /*!
     Flushes any application-level memory buffers in the same manner as `flushMem()`, then performs
     an implementation-specific device flush if `toDevice` is `true`. For example, if `toDevice` is
@@ -164,6 +204,8 @@ struct OutPipe {
 
     static void flush_Empty(OutPipe*);
     static u64 seek_Empty(OutPipe*, s64, SeekDir);
+    static PLY_DLL_ENTRY bool writeMany_Fallback(OutPipe* outPipe, ArrayView<const StringView> bufs);
+    static PLY_DLL_ENTRY bool transferFrom_Fallback(OutPipe* outPipe, InPipe* src, u64 numBytes);
 };
 
 } // namespace ply
@@ -7,6 +7,11 @@
 #if PLY_TARGET_POSIX
 
 #include <ply-runtime/io/impl/Pipe_FD.h>
+#include <sys/uio.h>
+#include <limits.h>
+#if PLY_KERNEL_LINUX
+#include <sys/sendfile.h>
+#endif
 
 namespace ply {
 
@@ -75,6 +80,80 @@ PLY_NO_INLINE bool OutPipe_FD_write(OutPipe* outPipe_, StringView buf) {
     return true;
 }
 
+PLY_NO_INLINE bool OutPipe_FD_writeMany(OutPipe* outPipe_, ArrayView<const StringView> bufs) {
+    OutPipe_FD* outPipe = static_cast<OutPipe_FD*>(outPipe_);
+    PLY_ASSERT(outPipe->fd >= 0);
+    static constexpr u32 MaxIOVecs = 64;
+    struct iovec iov[MaxIOVecs];
+    u32 bufIndex = 0;
+    u32 offsetInBuf = 0;
+    while (bufIndex < bufs.numItems) {
+        // Fill the iovec array starting from the first unwritten byte.
+        u32 numIOVecs = 0;
+        for (u32 i = bufIndex; i < bufs.numItems && numIOVecs < min<u32>(MaxIOVecs, IOV_MAX);
+             i++) {
+            u32 skip = (i == bufIndex) ? offsetInBuf : 0;
+            iov[numIOVecs].iov_base = (void*) (bufs[i].bytes + skip);
+            iov[numIOVecs].iov_len = bufs[i].numBytes - skip;
+            numIOVecs++;
+        }
+        ssize_t sent;
+        do {
+            sent = ::writev(outPipe->fd, iov, (int) numIOVecs);
+        } while (sent == -1 && errno == EINTR);
+        if (sent < 0)
+            return false;
+
+        // Advance past the bytes that were written, which may end partway through a buffer.
+        uptr remaining = (uptr) sent;
+        while (bufIndex < bufs.numItems) {
+            u32 left = bufs[bufIndex].numBytes - offsetInBuf;
+            if (remaining < left) {
+                offsetInBuf += (u32) remaining;
+                break;
+            }
+            remaining -= left;
+            bufIndex++;
+            offsetInBuf = 0;
+        }
+        if (sent == 0 && bufIndex < bufs.numItems)
+            return false;
+    }
+    return true;
+}
+
+PLY_NO_INLINE bool OutPipe_FD_transferFrom(OutPipe* outPipe_, InPipe* src, u64 numBytes) {
+#if PLY_KERNEL_LINUX
+    OutPipe_FD* outPipe = static_cast<OutPipe_FD*>(outPipe_);
+    PLY_ASSERT(outPipe->fd >= 0);
+    if (src->funcs == &InPipe_FD::Funcs_) {
+        // Let the kernel copy directly from the page cache. sendfile() reads from the source's
+        // current file offset and advances it, just like read().
+        int srcFD = src->cast<InPipe_FD>()->fd;
+        bool anySent = false;
+        while (numBytes > 0) {
+            // Linux transfers at most 0x7ffff000 bytes per call.
+            size_t count = (size_t) min<u64>(numBytes, 0x7ffff000);
+            ssize_t sent = ::sendfile(outPipe->fd, srcFD, nullptr, count);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (!anySent && (errno == EINVAL || errno == ENOSYS))
+                    break; // This pair of file descriptors isn't supported; copy instead
+                return false;
+            }
+            if (sent == 0)
+                return false; // Source reached EOF early
+            anySent = true;
+            numBytes -= sent;
+        }
+        if (numBytes == 0)
+            return true;
+    }
+#endif
+    return OutPipe::transferFrom_Fallback(outPipe_, src, numBytes);
+}
+
 PLY_NO_INLINE bool OutPipe_FD_flush(OutPipe* outPipe_, bool toDevice) {
     // FIXME: Implement as per
     // https://github.com/libuv/libuv/issues/1579#issue-262113760
@@ -110,6 +189,8 @@ OutPipe::Funcs OutPipe_FD::Funcs_ = {
     OutPipe_FD_write,
     OutPipe_FD_flush,
     OutPipe_FD_seek,
+    OutPipe_FD_writeMany,
+    OutPipe_FD_transferFrom,
 };
 
 PLY_NO_INLINE OutPipe_FD::OutPipe_FD(int fd) : OutPipe{&Funcs_}, fd{fd} {
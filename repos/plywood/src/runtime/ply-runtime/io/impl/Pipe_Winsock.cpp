@@ -59,6 +59,44 @@ PLY_NO_INLINE bool OutPipe_Winsock_write(OutPipe* outPipe_, StringView buf) {
     return true;
 }
 
+PLY_NO_INLINE bool OutPipe_Winsock_writeMany(OutPipe* outPipe_, ArrayView<const StringView> bufs) {
+    OutPipe_Winsock* outPipe = static_cast<OutPipe_Winsock*>(outPipe_);
+    static constexpr u32 MaxWSABufs = 64;
+    WSABUF wsaBufs[MaxWSABufs];
+    u32 bufIndex = 0;
+    u32 offsetInBuf = 0;
+    while (bufIndex < bufs.numItems) {
+        // Fill the WSABUF array starting from the first unsent byte.
+        DWORD numWSABufs = 0;
+        for (u32 i = bufIndex; i < bufs.numItems && numWSABufs < MaxWSABufs; i++) {
+            u32 skip = (i == bufIndex) ? offsetInBuf : 0;
+            wsaBufs[numWSABufs].buf = (CHAR*) (bufs[i].bytes + skip);
+            wsaBufs[numWSABufs].len = bufs[i].numBytes - skip;
+            numWSABufs++;
+        }
+        DWORD sent = 0;
+        int rc = WSASend(outPipe->socket, wsaBufs, numWSABufs, &sent, 0, NULL, NULL);
+        if (rc == SOCKET_ERROR)
+            return false;
+
+        // Advance past the bytes that were sent, which may end partway through a buffer.
+        DWORD remaining = sent;
+        while (bufIndex < bufs.numItems) {
+            u32 left = bufs[bufIndex].numBytes - offsetInBuf;
+            if (remaining < left) {
+                offsetInBuf += remaining;
+                break;
+            }
+            remaining -= left;
+            bufIndex++;
+            offsetInBuf = 0;
+        }
+        if (sent == 0 && bufIndex < bufs.numItems)
+            return false;
+    }
+    return true;
+}
+
 PLY_NO_INLINE bool OutPipe_Winsock_flush(OutPipe* outPipe_, bool toDevice) {
     bool result = true;
     if (toDevice) {
@@ -73,6 +111,7 @@ OutPipe::Funcs OutPipe_Winsock::Funcs_ = {
     OutPipe_Winsock_write,
     OutPipe_Winsock_flush,
     OutPipe::seek_Empty,
+    OutPipe_Winsock_writeMany,
 };
 
 PLY_NO_INLINE OutPipe_Winsock::OutPipe_Winsock(SOCKET socket) : OutPipe{&Funcs_}, socket{socket} {
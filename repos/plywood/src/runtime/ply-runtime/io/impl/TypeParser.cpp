@@ -31,6 +31,7 @@ const u8 fmt::DigitTable[256] = {
 // clang-format on
 
 const u32 fmt::WhitespaceMask[8] = {0x2600, 0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0};
+constexpr ByteClass fmt::WhitespaceClass{fmt::WhitespaceMask};
 
 PLY_INLINE bool match(u8 c, const u32* mask) {
     u32 bitValue = mask[c >> 5] & (1 << (c & 31));
@@ -38,13 +39,27 @@ PLY_INLINE bool match(u8 c, const u32* mask) {
 }
 
 PLY_NO_INLINE void fmt::scanUsingMask(InStream* ins, const u32* mask, bool invert) {
-    for (;;) {
+    // Most runs are short, so test the first few bytes one at a time before paying the cost of
+    // building a ByteClass.
+    for (u32 i = 0; i < 16; i++) {
         if (!ins->tryMakeBytesAvailable())
-            break;
+            return;
         if (match(ins->peekByte(), mask) == invert)
-            break;
+            return;
         ins->advanceByte();
     }
+    scanUsingMask(ins, ByteClass{mask}, invert);
+}
+
+PLY_NO_INLINE void fmt::scanUsingMask(InStream* ins, const ByteClass& cls, bool invert) {
+    // Scan each contiguous buffer using the SIMD kernels.
+    while (ins->tryMakeBytesAvailable()) {
+        const char* stop = invert ? cls.findFirstIn(ins->curByte, ins->endByte)
+                                  : cls.findFirstNotIn(ins->curByte, ins->endByte);
+        ins->curByte = stop;
+        if (stop < ins->endByte)
+            break;
+    }
 }
 
 PLY_NO_INLINE void fmt::scanUsingCallback(InStream* ins, const LambdaView<bool(char)>& callback) {
@@ -64,6 +79,12 @@ PLY_NO_INLINE bool fmt::scanUpToAndIncludingSpecial(InStream* ins, StringView sp
     for (;;) {
         if (!ins->tryMakeBytesAvailable())
             break;
+        if (matchedUnits == 0) {
+            // Skip ahead to the next occurrence of the first letter.
+            ins->curByte = findByteInRange(ins->curByte, ins->endByte, special[0]);
+            if (ins->curByte == ins->endByte)
+                continue;
+        }
         u8 c = ins->peekByte();
         ins->advanceByte();
         if (c == (u8) special.bytes[matchedUnits]) {
@@ -373,6 +394,21 @@ endOfString:
     return outs.moveToString();
 }
 
+// Units accepted after the first unit of an identifier, indexed by the WithDollarSign and WithDash
+// flags.
+static constexpr u32 IdentifierTailMasks[4][8] = {
+    {0, 0x3ff0000, 0x87fffffe, 0x7fffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+    {0, 0x3ff0010, 0x87fffffe, 0x7fffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+    {0, 0x3ff2000, 0x87fffffe, 0x7fffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+    {0, 0x3ff2010, 0x87fffffe, 0x7fffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+};
+static constexpr ByteClass IdentifierTailClasses[4] = {
+    ByteClass{IdentifierTailMasks[0]},
+    ByteClass{IdentifierTailMasks[1]},
+    ByteClass{IdentifierTailMasks[2]},
+    ByteClass{IdentifierTailMasks[3]},
+};
+
 bool fmt::FormatParser<fmt::Identifier>::parse(InStream* ins, const fmt::Identifier& format) {
     u32 mask[8] = {0, 0, 0x87fffffe, 0x7fffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
     if ((format.flags & WithDollarSign) != 0) {
@@ -382,17 +418,11 @@ bool fmt::FormatParser<fmt::Identifier>::parse(InStream* ins, const fmt::Identif
         mask[1] |= 0x2000; // '-'
     }
 
-    bool first = true;
-    for (;;) {
-        if (!ins->tryMakeBytesAvailable())
-            break;
-        if (!match(ins->peekByte(), mask))
-            break;
-        if (first) {
-            mask[1] |= 0x3ff0000; // accept digits after first unit
-            first = false;
-        };
+    if (ins->tryMakeBytesAvailable() && match(ins->peekByte(), mask)) {
+        mask[1] |= 0x3ff0000; // accept digits after first unit
         ins->advanceByte();
+        scanUsingMask(ins, IdentifierTailClasses[format.flags & (WithDollarSign | WithDash)],
+                      false);
     }
 
     if (mask[1] == 0) {
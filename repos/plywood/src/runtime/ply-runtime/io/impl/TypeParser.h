@@ -5,13 +5,16 @@
 #pragma once
 #include <ply-runtime/Core.h>
 #include <ply-runtime/container/HiddenArgFunctor.h>
+#include <ply-runtime/string/ByteClass.h>
 
 namespace ply {
 namespace fmt {
 
 extern const u8 DigitTable[256];
 extern const u32 WhitespaceMask[8];
+extern const ByteClass WhitespaceClass;
 PLY_DLL_ENTRY void scanUsingMask(InStream* ins, const u32* mask, bool invert);
+PLY_DLL_ENTRY void scanUsingMask(InStream* ins, const ByteClass& cls, bool invert);
 PLY_DLL_ENTRY void scanUsingCallback(InStream* ins, const LambdaView<bool(char)>& callback);
 PLY_DLL_ENTRY bool scanUpToAndIncludingSpecial(InStream* ins, StringView special);
 
@@ -133,7 +136,7 @@ struct Whitespace {};
 template <>
 struct FormatParser<Whitespace> {
     static PLY_NO_INLINE void parse(InStream* ins, const Whitespace&) {
-        fmt::scanUsingMask(ins, fmt::WhitespaceMask, false);
+        fmt::scanUsingMask(ins, fmt::WhitespaceClass, false);
     }
 };
 
@@ -153,7 +156,7 @@ struct NonWhitespace {};
 template <>
 struct FormatParser<NonWhitespace> {
     static PLY_NO_INLINE void parse(InStream* ins, const NonWhitespace&) {
-        fmt::scanUsingMask(ins, fmt::WhitespaceMask, true);
+        fmt::scanUsingMask(ins, fmt::WhitespaceClass, true);
     }
 };
 
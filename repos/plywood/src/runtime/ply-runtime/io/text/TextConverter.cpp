@@ -11,9 +11,46 @@ namespace ply {
 //-----------------------------------------------------------------------
 // TextConverter
 //-----------------------------------------------------------------------
+static TextKernels::ConvertResult convertUTF16LEToUTF8(MutableStringView dst, StringView src) {
+    return TextKernels::convertUTF16ToUTF8(dst, src, false);
+}
+static TextKernels::ConvertResult convertUTF16BEToUTF8(MutableStringView dst, StringView src) {
+    return TextKernels::convertUTF16ToUTF8(dst, src, true);
+}
+static TextKernels::ConvertResult convertUTF8ToUTF16LE(MutableStringView dst, StringView src) {
+    return TextKernels::convertUTF8ToUTF16(dst, src, false);
+}
+static TextKernels::ConvertResult convertUTF8ToUTF16BE(MutableStringView dst, StringView src) {
+    return TextKernels::convertUTF8ToUTF16(dst, src, true);
+}
+
+static PLY_NO_INLINE TextConverter::BulkConvertFunc*
+findBulkConvertFunc(const TextEncoding* dstEncoding, const TextEncoding* srcEncoding) {
+    const TextEncoding* utf8 = TextEncoding::get<UTF8>();
+    if (dstEncoding == utf8) {
+        if (srcEncoding == utf8)
+            return TextKernels::convertUTF8ToUTF8;
+        if (srcEncoding == TextEncoding::get<UTF16_LE>())
+            return convertUTF16LEToUTF8;
+        if (srcEncoding == TextEncoding::get<UTF16_BE>())
+            return convertUTF16BEToUTF8;
+        if (srcEncoding == TextEncoding::get<Enc_Bytes>())
+            return TextKernels::convertASCII;
+    } else if (srcEncoding == utf8) {
+        if (dstEncoding == TextEncoding::get<UTF16_LE>())
+            return convertUTF8ToUTF16LE;
+        if (dstEncoding == TextEncoding::get<UTF16_BE>())
+            return convertUTF8ToUTF16BE;
+        if (dstEncoding == TextEncoding::get<Enc_Bytes>())
+            return TextKernels::convertASCII;
+    }
+    return nullptr;
+}
+
 PLY_NO_INLINE TextConverter::TextConverter(const TextEncoding* dstEncoding,
                                            const TextEncoding* srcEncoding)
-    : dstEncoding{dstEncoding}, srcEncoding{srcEncoding} {
+    : dstEncoding{dstEncoding}, srcEncoding{srcEncoding},
+      bulkConvert{findBulkConvertFunc(dstEncoding, srcEncoding)} {
 }
 
 PLY_NO_INLINE bool TextConverter::convert(MutableStringView* dstBuf, StringView* srcBuf,
@@ -96,6 +133,21 @@ PLY_NO_INLINE bool TextConverter::convert(MutableStringView* dstBuf, StringView*
     PLY_ASSERT(this->srcSmallBuf.numBytes == 0);
 
     while (srcBuf->numBytes > 0) {
+        if (this->bulkConvert) {
+            // Convert as much input as possible in bulk. Whatever the kernel stops at is converted
+            // one point at a time below.
+            TextKernels::ConvertResult converted = this->bulkConvert(*dstBuf, *srcBuf);
+            if (converted.numSrcBytes > 0) {
+                srcBuf->offsetHead(converted.numSrcBytes);
+                dstBuf->offsetHead(converted.numDstBytes);
+                wroteAnything = true;
+                if (srcBuf->numBytes == 0)
+                    break;
+                if (dstBuf->numBytes == 0)
+                    return wroteAnything; // dstBuf is full
+            }
+        }
+
         // Decode one point from the input.
         DecodeResult decoded = this->srcEncoding->decodePoint(*srcBuf);
         if (decoded.status == DecodeResult::Status::Truncated) {
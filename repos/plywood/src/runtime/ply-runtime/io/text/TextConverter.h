@@ -8,6 +8,7 @@
 #include <ply-runtime/io/InStream.h>
 #include <ply-runtime/io/OutStream.h>
 #include <ply-runtime/string/TextEncoding.h>
+#include <ply-runtime/string/TextKernels.h>
 #include <ply-runtime/string/String.h>
 #include <ply-runtime/string/WString.h>
 
@@ -31,8 +32,12 @@ struct TextConverter {
         }
     };
 
+    using BulkConvertFunc = TextKernels::ConvertResult(MutableStringView dst, StringView src);
+
     const TextEncoding* dstEncoding = nullptr;
     const TextEncoding* srcEncoding = nullptr;
+    // Converts runs of valid input in bulk. Null if there's no kernel for this pair of encodings.
+    BulkConvertFunc* bulkConvert = nullptr;
     SmallBuffer srcSmallBuf;
     SmallBuffer dstSmallBuf;
 
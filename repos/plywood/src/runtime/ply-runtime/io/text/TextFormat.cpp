@@ -5,6 +5,7 @@
 #include <ply-runtime/Precomp.h>
 #include <ply-runtime/io/text/TextFormat.h>
 #include <ply-runtime/io/text/TextConverter.h>
+#include <ply-runtime/string/TextKernels.h>
 #include <ply-runtime/io/text/NewLineFilter.h>
 #include <ply-runtime/io/InStream.h>
 #include <ply-runtime/io/OutStream.h>
@@ -68,12 +69,57 @@ const TextEncoding* encodingFromEnum(TextFormat::Encoding enc) {
     }
 };
 
+// Counts a run of ASCII characters at the start of the input buffer using TextKernels, and
+// returns the number of bytes consumed.
+static PLY_NO_INLINE u32 scanASCIIRun(TextFileStats* stats, bool* prevWasCR, InStream* ins,
+                                      const TextEncoding* encoding, u32 maxBytes) {
+    TextKernels::ASCIICounts counts;
+    counts.prevWasCR = *prevWasCR;
+    StringView src = ins->viewAvailable();
+    src.numBytes = min(src.numBytes, maxBytes);
+    u32 numBytes = 0;
+    if (encoding->unitSize == 1) {
+        numBytes = TextKernels::countASCII(&counts, src);
+    } else {
+        bool bigEndian = (encoding == TextEncoding::get<UTF16_BE>());
+        char narrowed[256];
+        for (;;) {
+            u32 numUnits = TextKernels::narrowASCII16({narrowed, PLY_STATIC_ARRAY_SIZE(narrowed)},
+                                                      src.subStr(numBytes), bigEndian);
+            TextKernels::countASCII(&counts, {narrowed, numUnits});
+            numBytes += numUnits * 2;
+            if (numUnits < PLY_STATIC_ARRAY_SIZE(narrowed))
+                break;
+        }
+    }
+    ins->curByte += numBytes;
+    stats->numPoints += counts.numPoints;
+    stats->numValidPoints += counts.numPoints;
+    stats->totalPointValue += counts.totalPointValue;
+    stats->numLines += counts.numLines;
+    stats->numCRLF += counts.numCRLF;
+    stats->numControl += counts.numControl;
+    stats->numNull += counts.numNull;
+    stats->numPlainAscii += counts.numPlainAscii;
+    stats->numWhitespace += counts.numWhitespace;
+    *prevWasCR = counts.prevWasCR;
+    return numBytes;
+}
+
 PLY_NO_INLINE u32 scanTextFile(TextFileStats* stats, InStream* ins, const TextEncoding* encoding,
                                u32 maxBytes) {
     bool prevWasCR = false;
     u32 numBytes = 0;
     while (numBytes < maxBytes) {
         ins->tryMakeBytesAvailable(4); // returns < 4 on EOF/error *ONLY*
+        // Most text is ASCII, so count runs of ASCII characters in bulk first.
+        u32 numASCIIBytes = scanASCIIRun(stats, &prevWasCR, ins, encoding,
+                                         alignPowerOf2(maxBytes - numBytes, encoding->unitSize));
+        numBytes += numASCIIBytes;
+        if (numBytes >= maxBytes)
+            break;
+        if (numASCIIBytes > 0)
+            continue; // The input buffer may need to be refilled
         DecodeResult decoded = encoding->decodePoint(ins->viewAvailable());
         if (decoded.status == DecodeResult::Status::Truncated)
             break; // EOF/error
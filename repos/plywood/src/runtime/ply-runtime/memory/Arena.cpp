@@ -0,0 +1,158 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/memory/Arena.h>
+#include <ply-runtime/memory/MemPage.h>
+#include <ply-runtime/thread/Atomic.h>
+#include <string.h>
+
+namespace ply {
+
+//------------------------------------------------------------------
+// Registry of live Arenas
+//
+// PLY_HEAP.free() needs to recognize Arena memory no matter which thread frees it, so every Arena
+// registers its reserved range here. Ranges are stored in the slots themselves so that lookups
+// never dereference an Arena that's being destroyed on another thread.
+//------------------------------------------------------------------
+struct ArenaSlot {
+    Atomic<uptr> begin; // Nonzero while the slot is claimed
+    Atomic<uptr> numBytes;
+    Atomic<Arena*> arena;
+};
+
+static constexpr u32 MaxLiveArenas = 256;
+// These are zero-initialized at global scope, so they're usable during static initialization.
+static ArenaSlot gArenaSlots[MaxLiveArenas];
+static Atomic<u32> gNumArenaSlotsUsed;
+static PLY_THREAD_LOCAL Arena* tlsCurrentArena = nullptr;
+Atomic<u32> Arena::numLiveArenas;
+
+//------------------------------------------------------------------
+// Arena
+//------------------------------------------------------------------
+PLY_NO_INLINE Arena::Arena(uptr numReservedBytes) {
+    uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
+    this->numReservedBytes = alignPowerOf2(numReservedBytes, allocationGranularity);
+    bool rc = MemPage::reserve(this->base, this->numReservedBytes);
+    PLY_ASSERT(rc);
+    PLY_UNUSED(rc);
+
+    // Register the reserved range.
+    for (u32 i = 0; i < MaxLiveArenas; i++) {
+        ArenaSlot& slot = gArenaSlots[i];
+        uptr expected = 0;
+        if (slot.begin.compareExchangeStrong(expected, uptr(this->base), Acquire)) {
+            slot.arena.store(this, Relaxed);
+            slot.numBytes.store(this->numReservedBytes, Release);
+            u32 numSlotsUsed = gNumArenaSlotsUsed.load(Relaxed);
+            while (numSlotsUsed < i + 1 &&
+                   !gNumArenaSlotsUsed.compareExchangeWeak(numSlotsUsed, i + 1, Release,
+                                                           Relaxed)) {
+            }
+            numLiveArenas.fetchAdd(1, Release);
+            this->registryIndex = i;
+            return;
+        }
+    }
+    // Too many live Arenas. This Arena's memory couldn't be recognized by PLY_HEAP, which would
+    // corrupt the heap as soon as any of it was freed.
+    PLY_FORCE_CRASH();
+}
+
+PLY_NO_INLINE Arena::~Arena() {
+    PLY_ASSERT(tlsCurrentArena != this); // Arena destroyed while a Scope is still active
+    ArenaSlot& slot = gArenaSlots[this->registryIndex];
+    numLiveArenas.fetchSub(1, Relaxed);
+    slot.numBytes.store(0, Relaxed);
+    slot.arena.store(nullptr, Relaxed);
+    slot.begin.store(0, Release);
+    MemPage::free(this->base, this->numReservedBytes);
+}
+
+PLY_NO_INLINE void* Arena::alloc(uptr numBytes, u32 alignment) {
+    PLY_ASSERT(isPowerOf2(alignment));
+    alignment = max<u32>(alignment, sizeof(uptr));
+    // Each block is preceded by its size, so that realloc() and getSize() work.
+    uptr start = alignPowerOf2(this->numUsedBytes + sizeof(uptr), (uptr) alignment);
+    uptr end = start + numBytes;
+    if (end > this->numCommittedBytes) {
+        if (end > this->numReservedBytes) {
+            // Out of reserved address space. PLY_HEAP callers don't check for null, so don't
+            // return it.
+            PLY_FORCE_CRASH();
+        }
+        uptr allocationGranularity = MemPage::getInfo().allocationGranularity;
+        uptr newPageBoundary = alignPowerOf2(end, allocationGranularity);
+        MemPage::commit(this->base + this->numCommittedBytes,
+                        newPageBoundary - this->numCommittedBytes);
+        this->numCommittedBytes = newPageBoundary;
+    }
+    ((uptr*) (this->base + start))[-1] = numBytes;
+    this->numUsedBytes = end;
+    return this->base + start;
+}
+
+PLY_NO_INLINE void* Arena::realloc(void* ptr, uptr newNumBytes) {
+    if (!ptr)
+        return this->alloc(newNumBytes);
+    PLY_ASSERT(this->contains(ptr));
+    uptr oldNumBytes = getSize(ptr);
+    uptr start = uptr((char*) ptr - this->base);
+    if (start + oldNumBytes == this->numUsedBytes &&
+        start + newNumBytes <= this->numCommittedBytes) {
+        // It's the last block and there's room. Resize it in place.
+        ((uptr*) ptr)[-1] = newNumBytes;
+        this->numUsedBytes = start + newNumBytes;
+        return ptr;
+    }
+    if (newNumBytes <= oldNumBytes) {
+        ((uptr*) ptr)[-1] = newNumBytes;
+        return ptr;
+    }
+    void* result = this->alloc(newNumBytes);
+    memcpy(result, ptr, oldNumBytes);
+    return result;
+}
+
+PLY_NO_INLINE void Arena::reset() {
+    this->numUsedBytes = 0;
+}
+
+PLY_NO_INLINE void Arena::trim() {
+    this->numUsedBytes = 0;
+    if (this->numCommittedBytes > 0) {
+        MemPage::decommit(this->base, this->numCommittedBytes);
+        this->numCommittedBytes = 0;
+    }
+}
+
+PLY_NO_INLINE Arena* Arena::current() {
+    return tlsCurrentArena;
+}
+
+PLY_NO_INLINE Arena* Arena::findOwnerInRegistry(const void* ptr) {
+    u32 numSlotsUsed = gNumArenaSlotsUsed.load(Acquire);
+    for (u32 i = 0; i < numSlotsUsed; i++) {
+        ArenaSlot& slot = gArenaSlots[i];
+        uptr numBytes = slot.numBytes.load(Acquire);
+        if (numBytes && uptr((uptr) ptr - slot.begin.load(Relaxed)) < numBytes)
+            return slot.arena.load(Relaxed);
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------
+// Arena::Scope
+//------------------------------------------------------------------
+PLY_NO_INLINE Arena::Scope::Scope(Arena* arena) : prevArena{tlsCurrentArena} {
+    tlsCurrentArena = arena;
+}
+
+PLY_NO_INLINE Arena::Scope::~Scope() {
+    tlsCurrentArena = this->prevArena;
+}
+
+} // namespace ply
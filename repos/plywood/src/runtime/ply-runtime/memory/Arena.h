@@ -0,0 +1,102 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/thread/Atomic.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+A linear allocator that reserves a contiguous range of virtual memory up front and commits pages as
+needed, like `BigPool`. Allocation is a pointer bump, and all memory in the `Arena` is released at
+once by calling `reset()` or by destroying the `Arena`.
+
+Create an `Arena::Scope` to redirect `PLY_HEAP` to an `Arena` on the current thread. When
+`PLY_REPLACE_OPERATOR_NEW` is enabled, this redirects `operator new` as well. While an `Arena`
+exists, freeing its memory through `PLY_HEAP` is a no-op, so objects such as `Owned<Node>` trees can
+be built inside a scope and either destroyed normally or discarded wholesale:
+
+    Arena arena;
+    {
+        Arena::Scope scope{&arena};
+        Owned<Node> root = parse(src);
+        ...
+    }
+    arena.reset(); // Releases every node in O(1)
+
+Destructors are not called by `reset()`, so objects that own resources outside the `Arena` must
+still be destroyed before resetting it.
+
+While a `Scope` is active, every `PLY_HEAP` allocation on that thread comes from the `Arena`, even
+when it's made on behalf of a longer-lived object. For example, appending to an `Array` or
+inserting into a `HashMap` that was created before the `Scope` moves its contents into the
+`Arena`, and they dangle once the `Arena` is reset or destroyed. Create a nested
+`Arena::Scope{nullptr}` around such operations to allocate from the regular heap instead.
+`LabelMap` already does this for its own tables.
+
+An `Arena` is not thread-safe. Its memory can be freed from any thread, since that does nothing,
+but only one thread at a time may allocate from it, reallocate its memory (including through
+`PLY_HEAP.realloc()`) or reset it. At most 256 `Arena`s can exist at once.
+*/
+class Arena {
+private:
+    char* base = nullptr;
+    uptr numReservedBytes = 0;
+    uptr numCommittedBytes = 0;
+    uptr numUsedBytes = 0;
+    u32 registryIndex = 0;
+
+    static PLY_DLL_ENTRY Atomic<u32> numLiveArenas;
+    static PLY_DLL_ENTRY Arena* findOwnerInRegistry(const void* ptr);
+
+public:
+    static constexpr uptr DefaultNumReservedBytes =
+        (PLY_PTR_SIZE == 8) ? 1024 * 1024 * 1024 : 64 * 1024 * 1024;
+    static constexpr u32 DefaultAlignment = 16;
+
+    // Redirects PLY_HEAP to an Arena on the current thread for the lifetime of the Scope.
+    // Scopes can be nested. Pass nullptr to use the regular heap until the Scope ends.
+    struct Scope {
+        Arena* prevArena;
+        PLY_DLL_ENTRY Scope(Arena* arena);
+        PLY_DLL_ENTRY ~Scope();
+    };
+
+    PLY_DLL_ENTRY Arena(uptr numReservedBytes = DefaultNumReservedBytes);
+    PLY_DLL_ENTRY ~Arena();
+    Arena(const Arena&) = delete;
+
+    // Crashes if the Arena's reserved address space is exhausted.
+    PLY_DLL_ENTRY void* alloc(uptr numBytes, u32 alignment = DefaultAlignment);
+    // Grows or shrinks a block. The last block allocated is resized in place.
+    PLY_DLL_ENTRY void* realloc(void* ptr, uptr newNumBytes);
+    // Releases all memory allocated from the Arena, but keeps committed pages for reuse.
+    PLY_DLL_ENTRY void reset();
+    // Releases all memory allocated from the Arena and decommits its pages.
+    PLY_DLL_ENTRY void trim();
+
+    PLY_INLINE bool contains(const void* ptr) const {
+        return uptr((const char*) ptr - this->base) < this->numReservedBytes;
+    }
+    PLY_INLINE uptr numBytesUsed() const {
+        return this->numUsedBytes;
+    }
+    static PLY_INLINE uptr getSize(const void* ptr) {
+        return ((const uptr*) ptr)[-1];
+    }
+
+    // Returns the Arena that PLY_HEAP is currently redirected to on this thread, if any.
+    static PLY_DLL_ENTRY Arena* current();
+    // Returns the live Arena that owns ptr, if any. PLY_HEAP calls this on every free(),
+    // realloc() and getSize(), so it returns immediately when no Arenas exist.
+    static PLY_INLINE Arena* findOwner(const void* ptr) {
+        if (numLiveArenas.load(Relaxed) == 0)
+            return nullptr;
+        return findOwnerInRegistry(ptr);
+    }
+};
+
+} // namespace ply
@@ -0,0 +1,328 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/memory/HeapProfiler.h>
+#include <ply-runtime/container/Array.h>
+#include <ply-runtime/thread/impl/Mutex_LazyInit.h>
+#include <ply-runtime/algorithm/Sort.h>
+#include <ply-runtime/io/OutStream.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ply {
+
+//------------------------------------------------------------------
+// Bookkeeping
+//
+// Everything here lives in memory obtained from ::malloc so that recording an allocation never
+// recurses into PLY_HEAP. The global state has no constructor, so allocations made during static
+// initialization can be recorded too.
+//------------------------------------------------------------------
+struct HeapProfilerBlock {
+    uptr ptr; // 0 means empty slot
+    uptr numBytes;
+    u32 siteIndex;
+};
+
+struct HeapProfilerState {
+    Mutex_LazyInit mutex;
+    // Sites are never removed. siteLookup is an open-addressed table of (index + 1) into sites.
+    HeapProfiler::SiteStats* sites;
+    u32 numSites;
+    u32 siteCapacity;
+    u32* siteLookup;
+    u32 siteLookupMask;
+    // Live blocks, in an open-addressed table with linear probing.
+    HeapProfilerBlock* blocks;
+    uptr blockMask;
+    uptr numBlocks;
+    u64 numLiveBytes;
+    u64 peakLiveBytes;
+    u64 numLiveAllocs;
+    u64 numAllocs;
+};
+
+static HeapProfilerState gHeapProfiler;
+
+static PLY_INLINE uptr hashPtr(uptr ptr) {
+    return (uptr) avalanche((u64) ptr);
+}
+
+static PLY_NO_INLINE void growSiteLookup(HeapProfilerState& state) {
+    u32 newSize = state.siteLookup ? (state.siteLookupMask + 1) * 2 : 256;
+    u32* newLookup = (u32*) ::calloc(newSize, sizeof(u32));
+    for (u32 i = 0; i < state.numSites; i++) {
+        for (uptr j = hashPtr(uptr(state.sites[i].site));; j++) {
+            u32& slot = newLookup[j & (newSize - 1)];
+            if (slot == 0) {
+                slot = i + 1;
+                break;
+            }
+        }
+    }
+    ::free(state.siteLookup);
+    state.siteLookup = newLookup;
+    state.siteLookupMask = newSize - 1;
+}
+
+static PLY_NO_INLINE u32 findOrAddSite(HeapProfilerState& state, const char* site) {
+    if ((state.numSites + 1) * 2 > state.siteLookupMask) {
+        growSiteLookup(state);
+    }
+    for (uptr j = hashPtr(uptr(site));; j++) {
+        u32& slot = state.siteLookup[j & state.siteLookupMask];
+        if (slot == 0) {
+            if (state.numSites >= state.siteCapacity) {
+                state.siteCapacity = max<u32>(state.siteCapacity * 2, 64);
+                state.sites = (HeapProfiler::SiteStats*) ::realloc(
+                    state.sites, sizeof(HeapProfiler::SiteStats) * state.siteCapacity);
+            }
+            // The array is grown with ::realloc, so construct the new entry in place.
+            HeapProfiler::SiteStats* stats =
+                new (state.sites + state.numSites) HeapProfiler::SiteStats;
+            stats->site = site;
+            slot = ++state.numSites;
+            return state.numSites - 1;
+        }
+        if (state.sites[slot - 1].site == site)
+            return slot - 1;
+    }
+}
+
+static PLY_NO_INLINE void growBlocks(HeapProfilerState& state) {
+    uptr oldSize = state.blocks ? state.blockMask + 1 : 0;
+    uptr newSize = oldSize ? oldSize * 2 : 1024;
+    HeapProfilerBlock* newBlocks =
+        (HeapProfilerBlock*) ::calloc(newSize, sizeof(HeapProfilerBlock));
+    for (uptr i = 0; i < oldSize; i++) {
+        const HeapProfilerBlock& block = state.blocks[i];
+        if (block.ptr) {
+            for (uptr j = hashPtr(block.ptr);; j++) {
+                HeapProfilerBlock& dst = newBlocks[j & (newSize - 1)];
+                if (dst.ptr == 0) {
+                    dst = block;
+                    break;
+                }
+            }
+        }
+    }
+    ::free(state.blocks);
+    state.blocks = newBlocks;
+    state.blockMask = newSize - 1;
+}
+
+// Returns the slot holding ptr, or the empty slot where it would be inserted.
+static PLY_INLINE HeapProfilerBlock* findBlock(HeapProfilerState& state, uptr ptr) {
+    for (uptr j = hashPtr(ptr);; j++) {
+        HeapProfilerBlock* block = &state.blocks[j & state.blockMask];
+        if (block->ptr == ptr || block->ptr == 0)
+            return block;
+    }
+}
+
+static PLY_NO_INLINE void removeBlock(HeapProfilerState& state, HeapProfilerBlock* block) {
+    HeapProfiler::SiteStats& stats = state.sites[block->siteIndex];
+    stats.numLiveBytes -= block->numBytes;
+    stats.numLiveAllocs--;
+    state.numLiveBytes -= block->numBytes;
+    state.numLiveAllocs--;
+    state.numBlocks--;
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones.
+    uptr hole = uptr(block - state.blocks);
+    uptr j = hole;
+    for (;;) {
+        j = (j + 1) & state.blockMask;
+        HeapProfilerBlock& next = state.blocks[j];
+        if (next.ptr == 0)
+            break;
+        uptr ideal = hashPtr(next.ptr) & state.blockMask;
+        // Leave the entry alone if its ideal slot lies cyclically within (hole, j].
+        bool stays = (hole <= j) ? (hole < ideal && ideal <= j) : (hole < ideal || ideal <= j);
+        if (!stays) {
+            state.blocks[hole] = next;
+            hole = j;
+        }
+    }
+    state.blocks[hole].ptr = 0;
+}
+
+// The caller must hold state.mutex.
+static PLY_NO_INLINE void recordAlloc(HeapProfilerState& state, const char* site, const void* ptr,
+                                      uptr numBytes) {
+    if (!ptr)
+        return;
+    if ((state.numBlocks + 1) * 4 > (state.blocks ? state.blockMask + 1 : 0) * 3) {
+        growBlocks(state);
+    }
+    HeapProfilerBlock* block = findBlock(state, uptr(ptr));
+    if (block->ptr) {
+        // A free went unrecorded. Forget the stale block.
+        removeBlock(state, block);
+        block = findBlock(state, uptr(ptr));
+    }
+    u32 siteIndex = findOrAddSite(state, site ? site : "(unknown)");
+    block->ptr = uptr(ptr);
+    block->numBytes = numBytes;
+    block->siteIndex = siteIndex;
+    state.numBlocks++;
+
+    HeapProfiler::SiteStats& stats = state.sites[siteIndex];
+    stats.numLiveBytes += numBytes;
+    stats.peakLiveBytes = max(stats.peakLiveBytes, stats.numLiveBytes);
+    stats.numLiveAllocs++;
+    stats.numAllocs++;
+    stats.numBytesAllocated += numBytes;
+    state.numLiveBytes += numBytes;
+    state.peakLiveBytes = max(state.peakLiveBytes, state.numLiveBytes);
+    state.numLiveAllocs++;
+    state.numAllocs++;
+}
+
+// The caller must hold state.mutex.
+static PLY_NO_INLINE void recordFree(HeapProfilerState& state, const void* ptr) {
+    if (!ptr || state.numBlocks == 0)
+        return;
+    HeapProfilerBlock* block = findBlock(state, uptr(ptr));
+    if (block->ptr) {
+        removeBlock(state, block);
+    }
+}
+
+//------------------------------------------------------------------
+// HeapProfiler
+//------------------------------------------------------------------
+PLY_NO_INLINE void HeapProfiler::onAlloc(const char* site, const void* ptr, uptr numBytes) {
+    if (!ptr)
+        return;
+    HeapProfilerState& state = gHeapProfiler;
+    LockGuard<Mutex_LazyInit> guard{state.mutex};
+    recordAlloc(state, site, ptr, numBytes);
+}
+
+PLY_NO_INLINE void HeapProfiler::onFree(const void* ptr) {
+    if (!ptr)
+        return;
+    HeapProfilerState& state = gHeapProfiler;
+    LockGuard<Mutex_LazyInit> guard{state.mutex};
+    recordFree(state, ptr);
+}
+
+PLY_NO_INLINE void* HeapProfiler::reallocAndRecord(const char* site, void* ptr, uptr newSize,
+                                                   void* (*reallocFunc)(void*, size_t)) {
+    HeapProfilerState& state = gHeapProfiler;
+    LockGuard<Mutex_LazyInit> guard{state.mutex};
+    void* result = reallocFunc(ptr, (size_t) newSize);
+    if (result || newSize == 0) {
+        recordFree(state, ptr);
+        recordAlloc(state, site, result, newSize);
+    }
+    return result;
+}
+
+PLY_NO_INLINE Array<HeapProfiler::SiteStats> HeapProfiler::getSiteStats() {
+    // Copy the sites while holding the lock, then build the result without it, since building the
+    // result allocates from PLY_HEAP.
+    HeapProfilerState& state = gHeapProfiler;
+    u32 numSites;
+    SiteStats* sites;
+    {
+        LockGuard<Mutex_LazyInit> guard{state.mutex};
+        numSites = state.numSites;
+        sites = (SiteStats*) ::malloc(sizeof(SiteStats) * max<u32>(numSites, 1));
+        memcpy(sites, state.sites, sizeof(SiteStats) * numSites);
+    }
+
+    // Merge sites whose strings are identical but were stored at different addresses.
+    sort(ArrayView<SiteStats>{sites, numSites}, [](const SiteStats& a, const SiteStats& b) {
+        return strcmp(a.site, b.site) < 0;
+    });
+    Array<SiteStats> result;
+    for (u32 i = 0; i < numSites; i++) {
+        if (!result.isEmpty() && strcmp(result.back().site, sites[i].site) == 0) {
+            SiteStats& merged = result.back();
+            merged.numLiveBytes += sites[i].numLiveBytes;
+            // The sites' peaks may have occurred at different times, so the combined peak isn't
+            // known. Report the largest one instead.
+            merged.peakLiveBytes = max(merged.peakLiveBytes, sites[i].peakLiveBytes);
+            merged.numLiveAllocs += sites[i].numLiveAllocs;
+            merged.numAllocs += sites[i].numAllocs;
+            merged.numBytesAllocated += sites[i].numBytesAllocated;
+        } else {
+            result.append(sites[i]);
+        }
+    }
+    ::free(sites);
+
+    sort(result.view(), [](const SiteStats& a, const SiteStats& b) {
+        if (a.numLiveBytes != b.numLiveBytes)
+            return a.numLiveBytes > b.numLiveBytes;
+        return a.peakLiveBytes > b.peakLiveBytes;
+    });
+    return result;
+}
+
+PLY_NO_INLINE HeapProfiler::Totals HeapProfiler::getTotals() {
+    HeapProfilerState& state = gHeapProfiler;
+    LockGuard<Mutex_LazyInit> guard{state.mutex};
+    Totals totals;
+    totals.numLiveBytes = state.numLiveBytes;
+    totals.peakLiveBytes = state.peakLiveBytes;
+    totals.numLiveAllocs = state.numLiveAllocs;
+    totals.numAllocs = state.numAllocs;
+    return totals;
+}
+
+static void writeRightAligned(OutStream* outs, u64 value, u32 width) {
+    String str = String::from(value);
+    for (u32 i = str.numBytes; i < width; i++) {
+        *outs << ' ';
+    }
+    *outs << str;
+}
+
+PLY_NO_INLINE void HeapProfiler::writeText(OutStream* outs) {
+    Array<SiteStats> sites = getSiteStats();
+    Totals totals = getTotals();
+    outs->format("Heap profile: {} live bytes in {} blocks, peak {} bytes, {} allocations total\n",
+                 totals.numLiveBytes, totals.numLiveAllocs, totals.peakLiveBytes,
+                 totals.numAllocs);
+    *outs << "  Live bytes  Peak bytes Live blocks Allocations  Site\n";
+    for (const SiteStats& stats : sites) {
+        writeRightAligned(outs, stats.numLiveBytes, 12);
+        writeRightAligned(outs, stats.peakLiveBytes, 12);
+        writeRightAligned(outs, stats.numLiveAllocs, 12);
+        writeRightAligned(outs, stats.numAllocs, 12);
+        outs->format("  {}\n", stats.site);
+    }
+}
+
+PLY_NO_INLINE void HeapProfiler::writePylon(OutStream* outs) {
+    // Follows the same layout as pylon::write(), which the runtime can't depend on.
+    Array<SiteStats> sites = getSiteStats();
+    Totals totals = getTotals();
+    outs->format("{{\n  \"numLiveBytes\": \"{}\",\n  \"peakLiveBytes\": \"{}\",\n"
+                 "  \"numLiveAllocs\": \"{}\",\n  \"numAllocs\": \"{}\",\n  \"sites\": [\n",
+                 totals.numLiveBytes, totals.peakLiveBytes, totals.numLiveAllocs,
+                 totals.numAllocs);
+    for (u32 i = 0; i < sites.numItems(); i++) {
+        const SiteStats& stats = sites[i];
+        outs->format("    {{\n      \"site\": \"{}\",\n      \"numLiveBytes\": \"{}\",\n"
+                     "      \"peakLiveBytes\": \"{}\",\n      \"numLiveAllocs\": \"{}\",\n"
+                     "      \"numAllocs\": \"{}\",\n      \"numBytesAllocated\": \"{}\"\n    }}",
+                     fmt::EscapedString{stats.site}, stats.numLiveBytes, stats.peakLiveBytes,
+                     stats.numLiveAllocs, stats.numAllocs, stats.numBytesAllocated);
+        *outs << ((i + 1 < sites.numItems()) ? ",\n" : "\n");
+    }
+    *outs << "  ]\n}\n";
+}
+
+PLY_NO_INLINE String HeapProfiler::toPylon() {
+    MemOutStream mout;
+    writePylon(&mout);
+    return mout.moveToString();
+}
+
+} // namespace ply
@@ -0,0 +1,72 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+
+namespace ply {
+
+// This header is included by the heap implementation, so it only forward-declares these:
+template <typename>
+class Array;
+struct String;
+struct OutStream;
+
+//------------------------------------------------------------------------------------------------
+/*!
+Aggregates heap usage per allocation site.
+
+When `PLY_HEAP_PROFILING` is enabled, every allocation made through `PLY_HEAP` (and `operator new`,
+when it's replaced) is recorded together with the `__FILE__(__LINE__)` string that `PLY_HEAP`
+passes to `operate()`. The profiler keeps its own bookkeeping in memory obtained directly from the
+C runtime, so it doesn't show up in its own reports or in `PLY_HEAP` statistics.
+
+    OutStream outs = StdOut::text();
+    HeapProfiler::writeText(&outs);
+    FileSystem::native()->makeDirsAndSaveTextIfDifferent(
+        "heap-profile.pylon", HeapProfiler::toPylon(), TextFormat::platformPreference());
+
+Since the site is where `PLY_HEAP` is invoked, blocks are attributed to the container or module
+that allocated them (for example, `BaseArray.cpp` or `HashMap.cpp`) and `operator new` is
+attributed to `Heap.cpp`. Allocations from an `Arena` are not tracked.
+*/
+struct HeapProfiler {
+    struct SiteStats {
+        const char* site = nullptr; // "file(line)" passed to PLY_HEAP
+        u64 numLiveBytes = 0;
+        u64 peakLiveBytes = 0; // For merged sites, the largest peak of any of them
+        u64 numLiveAllocs = 0;
+        u64 numAllocs = 0; // Total since the site was first seen
+        u64 numBytesAllocated = 0;
+    };
+
+    struct Totals {
+        u64 numLiveBytes = 0;
+        u64 peakLiveBytes = 0;
+        u64 numLiveAllocs = 0;
+        u64 numAllocs = 0;
+    };
+
+    // Called by the heap implementation. Can also be called directly to track custom allocators.
+    static PLY_DLL_ENTRY void onAlloc(const char* site, const void* ptr, uptr numBytes);
+    static PLY_DLL_ENTRY void onFree(const void* ptr);
+    // Calls reallocFunc and records the result while holding the profiler's lock. Heaps that have
+    // no lock of their own use this. Otherwise, once the block has moved, another thread could
+    // allocate and record the old address before the old block's record is removed.
+    static PLY_DLL_ENTRY void* reallocAndRecord(const char* site, void* ptr, uptr newSize,
+                                                void* (*reallocFunc)(void*, size_t));
+
+    // Returns one entry per allocation site, ordered by numLiveBytes, largest first. Sites with
+    // identical strings are merged; their peakLiveBytes is the maximum of their individual peaks.
+    static PLY_DLL_ENTRY Array<SiteStats> getSiteStats();
+    static PLY_DLL_ENTRY Totals getTotals();
+
+    // Writes a human-readable table of allocation sites.
+    static PLY_DLL_ENTRY void writeText(OutStream* outs);
+    // Writes the same information in pylon format.
+    static PLY_DLL_ENTRY void writePylon(OutStream* outs);
+    static PLY_DLL_ENTRY String toPylon();
+};
+
+} // namespace ply
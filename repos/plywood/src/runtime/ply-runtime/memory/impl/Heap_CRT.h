@@ -5,6 +5,8 @@
 #pragma once
 #include <ply-runtime/Core.h>
 #include <ply-platform/Util.h>
+#include <ply-runtime/memory/Arena.h>
+#include <ply-runtime/memory/HeapProfiler.h>
 #if PLY_TARGET_WIN32
 #include <malloc.h>
 #else
@@ -16,33 +18,69 @@ namespace ply {
 class Heap_CRT {
 public:
     class Operator {
+#if PLY_HEAP_PROFILING
+    private:
+        const char* m_site;
+
+    public:
+        Operator(const char* site) : m_site(site) {
+        }
+#else
     public:
+#endif
         void* alloc(ureg size) {
-            return ::malloc((size_t) size);
+            if (Arena* arena = Arena::current())
+                return arena->alloc(size);
+            void* ptr = ::malloc((size_t) size);
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onAlloc(m_site, ptr, size);
+#endif
+            return ptr;
         }
 
         void* realloc(void* ptr, ureg newSize) {
+            if (Arena* arena = (ptr ? Arena::findOwner(ptr) : Arena::current()))
+                return arena->realloc(ptr, newSize);
+#if PLY_HEAP_PROFILING
+            return HeapProfiler::reallocAndRecord(m_site, ptr, newSize, ::realloc);
+#else
             return ::realloc(ptr, newSize);
+#endif
         }
 
         void free(void* ptr) {
+            if (Arena::findOwner(ptr))
+                return;
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onFree(ptr);
+#endif
             ::free(ptr);
         }
 
         void* allocAligned(ureg size, ureg alignment) {
             PLY_ASSERT(isPowerOf2(alignment));
+            if (Arena* arena = Arena::current())
+                return arena->alloc(size, (u32) alignment);
+            void* ptr;
 #if PLY_TARGET_WIN32
-            return ::_aligned_malloc((size_t) size, (size_t) alignment);
+            ptr = ::_aligned_malloc((size_t) size, (size_t) alignment);
 #else
-            void* ptr;
             int rc = posix_memalign(&ptr, max<size_t>(alignment, PLY_PTR_SIZE), (size_t) size);
             PLY_ASSERT(rc == 0);
             PLY_UNUSED(rc);
-            return ptr;
 #endif // PLY_TARGET_WIN32
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onAlloc(m_site, ptr, size);
+#endif
+            return ptr;
         }
 
         void freeAligned(void* ptr) {
+            if (Arena::findOwner(ptr))
+                return;
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onFree(ptr);
+#endif
 #if PLY_TARGET_WIN32
             ::_aligned_free(ptr);
 #else
@@ -51,9 +89,15 @@ public:
         }
     };
 
+#if PLY_HEAP_PROFILING
+    Operator operate(const char* site) {
+        return Operator(site);
+    }
+#else
     Operator operate(const char*) {
         return Operator();
     }
+#endif
 };
 
 } // namespace ply
@@ -13,6 +13,9 @@
 #include <ply-runtime/memory/impl/Heap_DL.h>
 #include <ply-runtime/memory/MemPage.h>
 #include <ply-runtime/thread/impl/Mutex_LazyInit.h>
+#if PLY_DLMALLOC_THREAD_CACHE && !PLY_TARGET_WIN32
+#include <pthread.h>
+#endif
 #include <stdlib.h>
 #include <memory.h>
 // FIXME: Define a configurable strategy for failed platform calls in Plywood, and
@@ -3389,7 +3392,260 @@ size_t dlmalloc_usable_size(void* mem) {
   return 0;
 }
 
+size_t dlmalloc_chunk_size(void* mem) {
+  return (mem != 0) ? chunksize(mem2chunk(mem)) : 0;
+}
+
+// clang-format on
+
+#if PLY_DLMALLOC_THREAD_CACHE
+
+//-----------------------------------------------------
+// ThreadCache
+//
+// Each thread keeps free blocks of up to MaxCachedSize bytes in per-size-class free lists. Blocks
+// remain allocated chunks as far as the malloc_state is concerned, so a block freed by one thread
+// can be cached by another thread and later reused there. Bins are refilled and flushed in batches
+// so that the heap's mutex is only taken once per batch.
+//
+// A thread gets a separate cache for every heap it uses. Each cache is linked into two lists: the
+// thread's list, which is flushed when the thread exits, and the heap's list, which is detached
+// when the heap is destroyed.
+//-----------------------------------------------------
+struct ThreadCache {
+    static constexpr u32 Granularity = 16;
+    static constexpr u32 NumClasses = 16;
+    static constexpr u32 MaxCachedSize = Granularity * NumClasses;
+    static constexpr u32 RefillCount = 16;
+    static constexpr u32 MaxBlocksPerClass = 64;
+
+    struct Bin {
+        void* head = nullptr; // Singly linked through the first word of each block
+        u32 numBlocks = 0;
+    };
+
+    // Set to null, with the global lock held, when the heap is destroyed.
+    Atomic<Heap_DL*> heap = nullptr;
+    ThreadCache* nextInHeap = nullptr;   // Guarded by heap->m_mutex
+    ThreadCache* nextInThread = nullptr; // Accessed only by the owning thread
+    Atomic<ureg> cachedBytes = 0; // Sum of chunk sizes; written only by the owning thread
+    Bin bins[NumClasses];
+
+    static ThreadCache* const Disabled;
+
+    PLY_INLINE void push(Bin& bin, void* block) {
+        *(void**) block = bin.head;
+        bin.head = block;
+        bin.numBlocks++;
+        this->cachedBytes.store(this->cachedBytes.loadNonatomic() + dlmalloc_chunk_size(block),
+                                Relaxed);
+    }
+
+    PLY_INLINE void* pop(Bin& bin) {
+        void* block = bin.head;
+        PLY_ASSERT(block);
+        bin.head = *(void**) block;
+        bin.numBlocks--;
+        this->cachedBytes.store(this->cachedBytes.loadNonatomic() - dlmalloc_chunk_size(block),
+                                Relaxed);
+        return block;
+    }
+
+    // Must be called with heap->m_mutex locked.
+    PLY_INLINE void flush(Heap_DL* heap, Bin& bin, u32 numBlocks) {
+        while (numBlocks-- > 0 && bin.head) {
+            dlfree(pop(bin), &heap->m_mstate);
+        }
+    }
+
+    static ThreadCache* get(Heap_DL* heap);
+    static PLY_NO_INLINE ThreadCache* create(Heap_DL* heap);
+    static void onThreadExit(ThreadCache* tc);
+    static PLY_NO_INLINE void detachAll(Heap_DL* heap);
+};
+
+// Once a thread exits (or fails to register an exit callback), it stops using caches for good.
+ThreadCache* const ThreadCache::Disabled = (ThreadCache*) 1;
+static PLY_THREAD_LOCAL ThreadCache* tlsThreadCaches = nullptr; // Head of the thread's list
+
+#if PLY_TARGET_WIN32
+static DWORD threadCacheExitKey = FLS_OUT_OF_INDEXES;
+static void WINAPI threadCacheExitCallback(void* param) {
+    if (param) {
+        ThreadCache::onThreadExit((ThreadCache*) param);
+    }
+}
+#else
+static pthread_key_t threadCacheExitKey;
+static bool threadCacheExitKeyCreated = false;
+static void threadCacheExitCallback(void* param) {
+    ThreadCache::onThreadExit((ThreadCache*) param);
+}
+#endif
+
+PLY_INLINE ThreadCache* ThreadCache::get(Heap_DL* heap) {
+    ThreadCache* tc = tlsThreadCaches;
+    if (tc == Disabled)
+        return nullptr;
+    // Most threads use a single heap, so the first cache in the list almost always matches.
+    for (; tc; tc = tc->nextInThread) {
+        if (tc->heap.load(Relaxed) == heap)
+            return tc;
+    }
+    return create(heap);
+}
+
+PLY_NO_INLINE ThreadCache* ThreadCache::create(Heap_DL* heap) {
+    // Register a callback so that the thread's caches are flushed when it exits.
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+#if PLY_TARGET_WIN32
+    if (threadCacheExitKey == FLS_OUT_OF_INDEXES) {
+        threadCacheExitKey = FlsAlloc(threadCacheExitCallback);
+    }
+    bool haveKey = (threadCacheExitKey != FLS_OUT_OF_INDEXES);
+#else
+    if (!threadCacheExitKeyCreated) {
+        threadCacheExitKeyCreated =
+            (pthread_key_create(&threadCacheExitKey, threadCacheExitCallback) == 0);
+    }
+    bool haveKey = threadCacheExitKeyCreated;
+#endif
+    RELEASE_MALLOC_GLOBAL_LOCK();
+    if (!haveKey) {
+        tlsThreadCaches = Disabled;
+        return nullptr;
+    }
+
+    ThreadCache* tc = nullptr;
+    {
+        LockGuard<Mutex_LazyInit> guard(heap->m_mutex);
+        void* mem = dlmalloc(sizeof(ThreadCache), &heap->m_mstate);
+        if (!mem)
+            return nullptr;
+        tc = new (mem) ThreadCache;
+        tc->heap.storeNonatomic(heap);
+        tc->nextInHeap = heap->m_threadCaches;
+        heap->m_threadCaches = tc;
+    }
+    tc->nextInThread = tlsThreadCaches;
+#if PLY_TARGET_WIN32
+    FlsSetValue(threadCacheExitKey, tc);
+#else
+    pthread_setspecific(threadCacheExitKey, tc);
+#endif
+    tlsThreadCaches = tc;
+    return tc;
+}
+
+void ThreadCache::onThreadExit(ThreadCache* tc) {
+    // Any blocks freed after this point go directly to the heap.
+    tlsThreadCaches = Disabled;
+    // The global lock keeps each heap from being destroyed while its cache is flushed.
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+    while (tc) {
+        ThreadCache* nextInThread = tc->nextInThread;
+        // If the heap was already destroyed, the cache was detached from it and is simply dropped.
+        if (Heap_DL* heap = tc->heap.loadNonatomic()) {
+            LockGuard<Mutex_LazyInit> guard(heap->m_mutex);
+            for (Bin& bin : tc->bins) {
+                tc->flush(heap, bin, bin.numBlocks);
+            }
+            for (ThreadCache** link = &heap->m_threadCaches; *link; link = &(*link)->nextInHeap) {
+                if (*link == tc) {
+                    *link = tc->nextInHeap;
+                    break;
+                }
+            }
+            tc->~ThreadCache();
+            dlfree(tc, &heap->m_mstate);
+        }
+        tc = nextInThread;
+    }
+    RELEASE_MALLOC_GLOBAL_LOCK();
+}
+
+// Called when a heap is destroyed. No thread may use the heap at this point, but threads that used
+// it may still be running, and their caches still point to it.
+PLY_NO_INLINE void ThreadCache::detachAll(Heap_DL* heap) {
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+    {
+        LockGuard<Mutex_LazyInit> guard(heap->m_mutex);
+        for (ThreadCache* tc = heap->m_threadCaches; tc; tc = tc->nextInHeap) {
+            tc->heap.store(nullptr, Relaxed);
+        }
+        heap->m_threadCaches = nullptr;
+    }
+    RELEASE_MALLOC_GLOBAL_LOCK();
+}
+
+#endif // PLY_DLMALLOC_THREAD_CACHE
+
 } // namespace memory_dl
+
+#if PLY_DLMALLOC_THREAD_CACHE
+
+//-----------------------------------------------------
+// Heap_DL thread cache support
+//-----------------------------------------------------
+PLY_NO_INLINE Heap_DL::~Heap_DL() {
+    memory_dl::ThreadCache::detachAll(this);
+}
+
+PLY_NO_INLINE void* Heap_DL::cachedAlloc(ureg size) {
+    using memory_dl::ThreadCache;
+    if (size > ThreadCache::MaxCachedSize)
+        return nullptr;
+    ThreadCache* tc = ThreadCache::get(this);
+    if (!tc)
+        return nullptr;
+    u32 sizeClass =
+        max<u32>(1, u32((size + ThreadCache::Granularity - 1) / ThreadCache::Granularity));
+    ThreadCache::Bin& bin = tc->bins[sizeClass - 1];
+    if (!bin.head) {
+        // Refill the bin with a batch of blocks.
+        LockGuard<Mutex_LazyInit> guard(m_mutex);
+        for (u32 i = 0; i < ThreadCache::RefillCount; i++) {
+            void* block = memory_dl::dlmalloc(sizeClass * ThreadCache::Granularity, &m_mstate);
+            if (!block)
+                break;
+            tc->push(bin, block);
+        }
+        if (!bin.head)
+            return nullptr;
+    }
+    return tc->pop(bin);
+}
+
+PLY_NO_INLINE bool Heap_DL::cachedFree(void* ptr) {
+    using memory_dl::ThreadCache;
+    ThreadCache* tc = ThreadCache::get(this);
+    if (!tc)
+        return false;
+    // Any block whose usable size is large enough can satisfy the size class it falls into.
+    ureg sizeClass = memory_dl::dlmalloc_usable_size(ptr) / ThreadCache::Granularity;
+    if (sizeClass == 0 || sizeClass > ThreadCache::NumClasses)
+        return false;
+    ThreadCache::Bin& bin = tc->bins[sizeClass - 1];
+    tc->push(bin, ptr);
+    if (bin.numBlocks > ThreadCache::MaxBlocksPerClass) {
+        // Return half of the bin to the heap.
+        LockGuard<Mutex_LazyInit> guard(m_mutex);
+        tc->flush(this, bin, ThreadCache::MaxBlocksPerClass / 2);
+    }
+    return true;
+}
+
+// Must be called with m_mutex locked.
+PLY_NO_INLINE void Heap_DL::addThreadCacheStats(memory_dl::Stats& stats) {
+    for (memory_dl::ThreadCache* tc = m_threadCaches; tc; tc = tc->nextInHeap) {
+        stats.threadCachedBytes += tc->cachedBytes.load(Relaxed);
+    }
+    PLY_ASSERT(stats.threadCachedBytes <= stats.inUseBytes);
+    stats.inUseBytes -= stats.threadCachedBytes;
+}
+
+#endif // PLY_DLMALLOC_THREAD_CACHE
+
 } // namespace ply
 
 #endif // PLY_USE_DLMALLOC && !PLY_DLL_IMPORTING
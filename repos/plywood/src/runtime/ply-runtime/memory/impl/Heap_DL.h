@@ -5,6 +5,8 @@
 #pragma once
 #include <ply-runtime/Core.h>
 #include <ply-runtime/thread/impl/Mutex_LazyInit.h>
+#include <ply-runtime/memory/Arena.h>
+#include <ply-runtime/memory/HeapProfiler.h>
 #include <string.h>
 
 namespace ply {
@@ -14,8 +16,13 @@ struct Stats {
     ureg peakSystemBytes;
     ureg systemBytes;
     ureg inUseBytes;
+    ureg threadCachedBytes; // Free blocks held by thread caches; not included in inUseBytes
 };
 
+#if PLY_DLMALLOC_THREAD_CACHE
+struct ThreadCache;
+#endif
+
 //-----------------------------------------------------
 // Adapted from Doug Lea's malloc: ftp://g.oswego.edu/pub/misc/malloc-2.8.6.c
 //
@@ -102,6 +109,7 @@ PLY_DLL_ENTRY void* dlpvalloc(size_t, mstate);
 PLY_DLL_ENTRY int dlmalloc_trim(size_t, mstate);
 PLY_DLL_ENTRY void dlmalloc_stats(mstate, Stats&);
 PLY_DLL_ENTRY size_t dlmalloc_usable_size(void*);
+PLY_DLL_ENTRY size_t dlmalloc_chunk_size(void*);
 //-----------------------------------------------------
 
 } // namespace memory_dl
@@ -110,6 +118,15 @@ class Heap_DL {
 private:
     memory_dl::malloc_state m_mstate;
     Mutex_LazyInit m_mutex;
+#if PLY_DLMALLOC_THREAD_CACHE
+    // When PLY_DLMALLOC_THREAD_CACHE is enabled, each thread keeps small free blocks in
+    // size-class free lists so that most allocations don't need to lock m_mutex.
+    friend struct memory_dl::ThreadCache;
+    memory_dl::ThreadCache* m_threadCaches; // Guarded by m_mutex
+    PLY_DLL_ENTRY void* cachedAlloc(ureg size);
+    PLY_DLL_ENTRY bool cachedFree(void* ptr);
+    PLY_DLL_ENTRY void addThreadCacheStats(memory_dl::Stats& stats);
+#endif
 
 public:
     // If you create a Heap_DL at global scope, it will be automatically
@@ -119,37 +136,91 @@ public:
         memset(static_cast<void*>(this), 0, sizeof(*this));
     }
 
+#if PLY_DLMALLOC_THREAD_CACHE
+    // Detaches any thread caches that still refer to this heap, so that their threads don't
+    // access it when they exit. The blocks held by those caches are discarded along with the heap.
+    PLY_DLL_ENTRY ~Heap_DL();
+#endif
+
     typedef memory_dl::Stats Stats;
 
     class Operator {
     private:
         Heap_DL& m_mem;
+#if PLY_HEAP_PROFILING
+        const char* m_site;
+#endif
 
     public:
+#if PLY_HEAP_PROFILING
+        Operator(Heap_DL& mem, const char* site) : m_mem(mem), m_site(site) {
+        }
+#else
         Operator(Heap_DL& mem) : m_mem(mem) {
         }
+#endif
 
         // There may also be extra indirection/checks inside the functions
         PLY_NO_INLINE void* alloc(ureg size) {
-            LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
-            return memory_dl::dlmalloc((size_t) size, &m_mem.m_mstate);
+            if (Arena* arena = Arena::current())
+                return arena->alloc(size);
+            void* ptr = nullptr;
+#if PLY_DLMALLOC_THREAD_CACHE
+            ptr = m_mem.cachedAlloc(size);
+            if (!ptr)
+#endif
+            {
+                LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
+                ptr = memory_dl::dlmalloc((size_t) size, &m_mem.m_mstate);
+            }
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onAlloc(m_site, ptr, size);
+#endif
+            return ptr;
         }
 
         PLY_NO_INLINE void* realloc(void* ptr, ureg newSize) {
+            if (Arena* arena = (ptr ? Arena::findOwner(ptr) : Arena::current()))
+                return arena->realloc(ptr, newSize);
             LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
-            return memory_dl::dlrealloc(ptr, (size_t) newSize, &m_mem.m_mstate);
+            void* result = memory_dl::dlrealloc(ptr, (size_t) newSize, &m_mem.m_mstate);
+#if PLY_HEAP_PROFILING
+            // Record the move while holding the lock. Otherwise, another thread could allocate
+            // the old address and record it before the old block's record is removed.
+            if (result || newSize == 0) {
+                HeapProfiler::onFree(ptr);
+                HeapProfiler::onAlloc(m_site, result, newSize);
+            }
+#endif
+            return result;
         }
 
         PLY_NO_INLINE void free(void* ptr) {
-            if (!ptr)
+            if (!ptr || Arena::findOwner(ptr))
                 return;
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onFree(ptr);
+#endif
+#if PLY_DLMALLOC_THREAD_CACHE
+            if (m_mem.cachedFree(ptr))
+                return;
+#endif
             LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
             return memory_dl::dlfree(ptr, &m_mem.m_mstate);
         }
 
         PLY_NO_INLINE void* allocAligned(ureg size, ureg alignment) {
-            LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
-            return memory_dl::dlmemalign((size_t) alignment, (size_t) size, &m_mem.m_mstate);
+            if (Arena* arena = Arena::current())
+                return arena->alloc(size, (u32) alignment);
+            void* ptr;
+            {
+                LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
+                ptr = memory_dl::dlmemalign((size_t) alignment, (size_t) size, &m_mem.m_mstate);
+            }
+#if PLY_HEAP_PROFILING
+            HeapProfiler::onAlloc(m_site, ptr, size);
+#endif
+            return ptr;
         }
 
         void freeAligned(void* ptr) {
@@ -160,6 +231,10 @@ public:
             Stats stats;
             LockGuard<Mutex_LazyInit> guard(m_mem.m_mutex);
             memory_dl::dlmalloc_stats(&m_mem.m_mstate, stats);
+            stats.threadCachedBytes = 0;
+#if PLY_DLMALLOC_THREAD_CACHE
+            m_mem.addThreadCacheStats(stats);
+#endif
             return stats;
         }
 
@@ -172,12 +247,20 @@ public:
 
     ureg getSize(void* ptr) {
         // No need to lock
+        if (Arena::findOwner(ptr))
+            return Arena::getSize(ptr);
         return memory_dl::dlmalloc_usable_size(ptr);
     }
 
+#if PLY_HEAP_PROFILING
+    Operator operate(const char* site) {
+        return Operator(*this, site);
+    }
+#else
     Operator operate(const char*) {
         return Operator(*this);
     }
+#endif
 };
 
 } // namespace ply
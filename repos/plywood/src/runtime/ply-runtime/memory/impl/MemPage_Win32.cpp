@@ -52,10 +52,9 @@ void MemPage_Win32::decommit(char* addr, uptr numBytes) {
     PLY_ASSERT(isAlignedPowerOf2((uptr) addr, getInfo().pageSize));
     PLY_ASSERT(isAlignedPowerOf2(numBytes, getInfo().pageSize));
 
-    DWORD type = MEM_COMMIT;
-    LPVOID result = VirtualAlloc(addr, (SIZE_T) numBytes, type, PAGE_READWRITE);
-    PLY_ASSERT(result != NULL);
-    PLY_UNUSED(result);
+    BOOL rc = VirtualFree(addr, (SIZE_T) numBytes, MEM_DECOMMIT);
+    PLY_ASSERT(rc);
+    PLY_UNUSED(rc);
 }
 
 void MemPage_Win32::free(char* addr, uptr numBytes) {
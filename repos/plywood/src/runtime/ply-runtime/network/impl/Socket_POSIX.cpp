@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <string.h>
 #include <signal.h>
+#include <fcntl.h>
 #include <ply-runtime/io/StdIO.h>
 
 #define PLY_IPPOSIX_ALLOW_UNKNOWN_ERRORS 1
@@ -64,6 +65,41 @@ PLY_NO_INLINE TCPConnection_POSIX::~TCPConnection_POSIX() {
     this->outPipe.fd = -1;
 }
 
+PLY_NO_INLINE s32 TCPConnection_POSIX::readNonBlocking(MutableStringView buf) {
+    PLY_ASSERT(this->inPipe.fd >= 0);
+    ssize_t rc;
+    do {
+        rc = ::recv(this->inPipe.fd, buf.bytes, buf.numBytes, MSG_DONTWAIT);
+    } while (rc == -1 && errno == EINTR);
+    if (rc >= 0) {
+        Socket_POSIX::lastResult_.store(IPResult::OK);
+        return (s32) rc;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        Socket_POSIX::lastResult_.store(IPResult::WouldBlock);
+    } else {
+        // Typically ECONNRESET
+        Socket_POSIX::lastResult_.store(IPResult::Unknown);
+    }
+    return -1;
+}
+
+PLY_NO_INLINE bool TCPConnection_POSIX::setNonBlocking(bool nonBlocking) {
+    int flags = fcntl(this->inPipe.fd, F_GETFL, 0);
+    if (flags < 0)
+        return false;
+    flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(this->inPipe.fd, F_SETFL, flags) == 0;
+}
+
+PLY_NO_INLINE bool TCPListener_POSIX::setNonBlocking(bool nonBlocking) {
+    int flags = fcntl(this->listenSocket, F_GETFL, 0);
+    if (flags < 0)
+        return false;
+    flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(this->listenSocket, F_SETFL, flags) == 0;
+}
+
 PLY_NO_INLINE Owned<TCPConnection_POSIX> TCPListener_POSIX::accept() {
     if (this->listenSocket < 0) {
         Socket_POSIX::lastResult_.store(IPResult::NoSocket);
@@ -76,9 +112,24 @@ PLY_NO_INLINE Owned<TCPConnection_POSIX> TCPListener_POSIX::accept() {
         remoteAddrLen = sizeof(sockaddr_in6);
     }
     socklen_t passedAddrLen = remoteAddrLen;
-    int hostSocket = ::accept(this->listenSocket, (struct sockaddr*) &remoteAddr, &remoteAddrLen);
+    int hostSocket;
+    do {
+        // ECONNABORTED means a pending connection was reset before it could be accepted. Move on
+        // to the next one.
+        remoteAddrLen = passedAddrLen;
+        hostSocket = ::accept(this->listenSocket, (struct sockaddr*) &remoteAddr, &remoteAddrLen);
+    } while (hostSocket < 0 && (errno == EINTR || errno == ECONNABORTED));
 
     if (hostSocket <= 0) {
+        if (hostSocket < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            Socket_POSIX::lastResult_.store(IPResult::WouldBlock);
+            return nullptr;
+        }
+        if (hostSocket < 0 &&
+            (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)) {
+            Socket_POSIX::lastResult_.store(IPResult::NoSocket);
+            return nullptr;
+        }
         // FIXME: Check errno
         PLY_ASSERT(PLY_IPPOSIX_ALLOW_UNKNOWN_ERRORS);
         Socket_POSIX::lastResult_.store(IPResult::Unknown);
@@ -172,7 +223,7 @@ PLY_NO_INLINE TCPListener_POSIX Socket_POSIX::bindTCP(u16 port) {
 
     rc = bind(listenSocket, (struct sockaddr*) &serverAddr, serverAddrLen);
     if (rc == 0) {
-        rc = listen(listenSocket, 1);
+        rc = listen(listenSocket, SOMAXCONN);
         if (rc == 0) {
             Socket_POSIX::lastResult_.store(IPResult::OK);
             return TCPListener_POSIX{listenSocket};
@@ -74,6 +74,16 @@ struct TCPConnection_POSIX {
     PLY_INLINE OutStream createOutStream() {
         return OutStream{borrow(&this->outPipe)};
     }
+
+    // Reads whatever data has already arrived, without blocking, even if the socket is in blocking
+    // mode. Returns the number of bytes read, or 0 if the peer closed the connection. Returns -1
+    // if no data is available yet, in which case lastResult() is WouldBlock, or if an error
+    // occurred.
+    PLY_DLL_ENTRY s32 readNonBlocking(MutableStringView buf);
+
+    // In non-blocking mode, reads and writes fail with EAGAIN instead of waiting, so the pipes
+    // returned by createInStream() and createOutStream() are only suitable for blocking mode.
+    PLY_DLL_ENTRY bool setNonBlocking(bool nonBlocking);
 };
 
 //------------------------------------------------------------------
@@ -114,6 +124,11 @@ public:
         }
     }
 
+    // In non-blocking mode, accept() returns nullptr and sets lastResult() to WouldBlock when there
+    // are no pending connections. Accepted connections are always in blocking mode. If the process
+    // is out of file descriptors, accept() returns nullptr and sets lastResult() to NoSocket; the
+    // pending connection stays in the queue.
+    PLY_DLL_ENTRY bool setNonBlocking(bool nonBlocking);
     PLY_DLL_ENTRY Owned<TCPConnection_POSIX> accept();
 };
 
@@ -0,0 +1,331 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/string/ByteClass.h>
+#if PLY_CPU_X86 || PLY_CPU_X64
+#define PLY_BYTECLASS_X86 1
+#include <immintrin.h>
+#elif PLY_CPU_ARM64
+#define PLY_BYTECLASS_NEON 1
+#include <arm_neon.h>
+#endif
+#if PLY_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+// GCC and Clang only emit instructions for extensions that are enabled, either for the whole
+// translation unit or per function. MSVC accepts any intrinsic.
+#if PLY_COMPILER_MSVC
+#define PLY_BYTECLASS_TARGET(ext)
+#else
+#define PLY_BYTECLASS_TARGET(ext) __attribute__((target(ext)))
+#endif
+
+namespace ply {
+
+// Used to look up bit (hi & 7) by high nibble.
+alignas(16) static const u8 NibbleBitTable[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                                   1, 2, 4, 8, 16, 32, 64, 128};
+
+//------------------------------------------------------------------
+// Scalar kernels
+//------------------------------------------------------------------
+static PLY_NO_INLINE const char* findByte_Scalar(const char* start, const char* end, char value) {
+    for (; start < end; start++) {
+        if (*start == value)
+            break;
+    }
+    return start;
+}
+
+static PLY_NO_INLINE const char* findInClass_Scalar(const char* start, const char* end,
+                                                    const ByteClass& cls, bool member) {
+    for (; start < end; start++) {
+        if (cls.contains(*start) == member)
+            break;
+    }
+    return start;
+}
+
+//------------------------------------------------------------------
+// x86/64 kernels
+//
+// Each loop tests one vector of bytes per iteration. When fewer bytes than a full vector remain,
+// the last vector is reloaded so that it ends exactly at `end`, and the bytes that were already
+// tested are shifted out of the result mask. Ranges shorter than one vector are scanned using the
+// scalar loop.
+//------------------------------------------------------------------
+#if PLY_BYTECLASS_X86
+
+static PLY_BYTECLASS_TARGET("sse2") const char* findByte_SSE2(const char* start,
+                                                              const char* end, char value) {
+    if (end - start < 16)
+        return findByte_Scalar(start, end, value);
+    __m128i needle = _mm_set1_epi8(value);
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 16) {
+            if (p >= end)
+                return end;
+            shift = u32(16 - (end - p));
+            p = end - 16;
+        }
+        __m128i v = _mm_loadu_si128((const __m128i*) p);
+        u32 bits = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)) >> shift;
+        if (bits != 0)
+            return p + shift + countTrailingZeros(bits);
+        p += 16;
+    }
+}
+
+// Returns a 16-bit mask with one bit set for each byte of v that belongs to cls.
+static PLY_INLINE PLY_BYTECLASS_TARGET("ssse3") u32
+    matchClass_SSSE3(__m128i v, __m128i lowTable, __m128i highTable) {
+    // The shuffle returns zero when the high bit of the index is set, so each table only
+    // contributes for its own half of the byte values.
+    __m128i bits = _mm_or_si128(_mm_shuffle_epi8(lowTable, v),
+                                _mm_shuffle_epi8(highTable, _mm_xor_si128(v, _mm_set1_epi8(-128))));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+    __m128i bit = _mm_shuffle_epi8(_mm_load_si128((const __m128i*) NibbleBitTable), hi);
+    return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bits, bit), bit));
+}
+
+static PLY_BYTECLASS_TARGET("ssse3") const char* findInClass_SSSE3(const char* start,
+                                                                   const char* end,
+                                                                   const ByteClass& cls,
+                                                                   bool member) {
+    if (end - start < 16)
+        return findInClass_Scalar(start, end, cls, member);
+    __m128i lowTable = _mm_loadu_si128((const __m128i*) cls.nibbleBits[0]);
+    __m128i highTable = _mm_loadu_si128((const __m128i*) cls.nibbleBits[1]);
+    u32 flip = member ? 0 : 0xffff;
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 16) {
+            if (p >= end)
+                return end;
+            shift = u32(16 - (end - p));
+            p = end - 16;
+        }
+        __m128i v = _mm_loadu_si128((const __m128i*) p);
+        u32 bits = (matchClass_SSSE3(v, lowTable, highTable) ^ flip) >> shift;
+        if (bits != 0)
+            return p + shift + countTrailingZeros(bits);
+        p += 16;
+    }
+}
+
+static PLY_BYTECLASS_TARGET("avx2") const char* findByte_AVX2(const char* start,
+                                                              const char* end, char value) {
+    if (end - start < 32)
+        return findByte_SSE2(start, end, value);
+    __m256i needle = _mm256_set1_epi8(value);
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 32) {
+            if (p >= end)
+                return end;
+            shift = u32(32 - (end - p));
+            p = end - 32;
+        }
+        __m256i v = _mm256_loadu_si256((const __m256i*) p);
+        u64 bits = u64(u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)))) >> shift;
+        if (bits != 0)
+            return p + shift + countTrailingZeros(bits);
+        p += 32;
+    }
+}
+
+static PLY_BYTECLASS_TARGET("avx2") const char* findInClass_AVX2(const char* start,
+                                                                 const char* end,
+                                                                 const ByteClass& cls,
+                                                                 bool member) {
+    if (end - start < 32)
+        return findInClass_SSSE3(start, end, cls, member);
+    // The 256-bit shuffle works within each 128-bit lane, so the tables are repeated in both.
+    __m256i lowTable =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) cls.nibbleBits[0]));
+    __m256i highTable =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) cls.nibbleBits[1]));
+    __m256i bitTable =
+        _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*) NibbleBitTable));
+    u64 flip = member ? 0 : 0xffffffffu;
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 32) {
+            if (p >= end)
+                return end;
+            shift = u32(32 - (end - p));
+            p = end - 32;
+        }
+        __m256i v = _mm256_loadu_si256((const __m256i*) p);
+        __m256i bits = _mm256_or_si256(
+            _mm256_shuffle_epi8(lowTable, v),
+            _mm256_shuffle_epi8(highTable, _mm256_xor_si256(v, _mm256_set1_epi8(-128))));
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+        __m256i bit = _mm256_shuffle_epi8(bitTable, hi);
+        u64 matches = u32(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(bits, bit), bit)));
+        matches = (matches ^ flip) >> shift;
+        if (matches != 0)
+            return p + shift + countTrailingZeros(matches);
+        p += 32;
+    }
+}
+
+//------------------------------------------------------------------
+// ARM64 kernels
+//
+// NEON has no movemask instruction. Instead, each byte of the comparison result is narrowed to 4
+// bits of a 64-bit mask, as in FlatHashMap, and bit indices are divided by 4.
+//------------------------------------------------------------------
+#elif PLY_BYTECLASS_NEON
+
+static PLY_INLINE u64 toNibbleMask(uint8x16_t matches) {
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+}
+
+static PLY_NO_INLINE const char* findByte_NEON(const char* start, const char* end, char value) {
+    if (end - start < 16)
+        return findByte_Scalar(start, end, value);
+    uint8x16_t needle = vdupq_n_u8((u8) value);
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 16) {
+            if (p >= end)
+                return end;
+            shift = u32(16 - (end - p));
+            p = end - 16;
+        }
+        uint8x16_t v = vld1q_u8((const u8*) p);
+        u64 bits = toNibbleMask(vceqq_u8(v, needle)) >> (shift * 4);
+        if (bits != 0)
+            return p + shift + (countTrailingZeros(bits) >> 2);
+        p += 16;
+    }
+}
+
+static PLY_NO_INLINE const char* findInClass_NEON(const char* start, const char* end,
+                                                  const ByteClass& cls, bool member) {
+    if (end - start < 16)
+        return findInClass_Scalar(start, end, cls, member);
+    // Unlike the x86 shuffle, the table lookup only uses the index as-is, so both tables are
+    // looked up together using a 5-bit index.
+    uint8x16x2_t tables = {{vld1q_u8(cls.nibbleBits[0]), vld1q_u8(cls.nibbleBits[1])}};
+    uint8x16_t bitTable = vld1q_u8(NibbleBitTable);
+    u64 flip = member ? 0 : 0x8888888888888888ull;
+    const char* p = start;
+    for (;;) {
+        u32 shift = 0;
+        if (end - p < 16) {
+            if (p >= end)
+                return end;
+            shift = u32(16 - (end - p));
+            p = end - 16;
+        }
+        uint8x16_t v = vld1q_u8((const u8*) p);
+        uint8x16_t index = vorrq_u8(vandq_u8(v, vdupq_n_u8(0x0f)),
+                                    vandq_u8(vshrq_n_u8(v, 3), vdupq_n_u8(0x10)));
+        uint8x16_t bits = vqtbl2q_u8(tables, index);
+        uint8x16_t bit = vqtbl1q_u8(bitTable, vshrq_n_u8(v, 4));
+        u64 matches = (toNibbleMask(vtstq_u8(bits, bit)) ^ flip) >> (shift * 4);
+        if (matches != 0)
+            return p + shift + (countTrailingZeros(matches) >> 2);
+        p += 16;
+    }
+}
+
+#endif
+
+//------------------------------------------------------------------
+// Runtime selection
+//------------------------------------------------------------------
+struct ByteScanKernels {
+    const char* (*findByte)(const char* start, const char* end, char value) = findByte_Scalar;
+    const char* (*findInClass)(const char* start, const char* end, const ByteClass& cls,
+                               bool member) = findInClass_Scalar;
+};
+
+#if PLY_BYTECLASS_X86
+struct X86Features {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool avx2 = false;
+};
+
+static PLY_NO_INLINE X86Features detectX86Features() {
+    X86Features features;
+#if PLY_COMPILER_MSVC
+    int regs[4];
+    __cpuid(regs, 0);
+    int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    features.sse2 = (regs[3] & (1 << 26)) != 0;
+    features.ssse3 = (regs[2] & (1 << 9)) != 0;
+    // AVX2 also requires the OS to save the upper halves of the YMM registers.
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(regs, 7, 0);
+        features.avx2 = (regs[1] & (1 << 5)) != 0;
+    }
+#else
+    // __builtin_cpu_supports also checks that the OS supports the AVX register state.
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.ssse3 = __builtin_cpu_supports("ssse3");
+    features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return features;
+}
+#endif
+
+static PLY_NO_INLINE ByteScanKernels selectKernels() {
+    ByteScanKernels kernels;
+#if PLY_BYTECLASS_X86
+    X86Features features = detectX86Features();
+    if (features.avx2) {
+        kernels.findByte = findByte_AVX2;
+        kernels.findInClass = findInClass_AVX2;
+    } else if (features.ssse3) {
+        kernels.findByte = findByte_SSE2;
+        kernels.findInClass = findInClass_SSSE3;
+    } else if (features.sse2) {
+        kernels.findByte = findByte_SSE2;
+    }
+#elif PLY_BYTECLASS_NEON
+    kernels.findByte = findByte_NEON;
+    kernels.findInClass = findInClass_NEON;
+#endif
+    return kernels;
+}
+
+static PLY_INLINE const ByteScanKernels& getKernels() {
+    static ByteScanKernels kernels = selectKernels();
+    return kernels;
+}
+
+//------------------------------------------------------------------
+// ByteClass
+//------------------------------------------------------------------
+PLY_NO_INLINE const char* ByteClass::findFirstIn(const char* start, const char* end) const {
+    return getKernels().findInClass(start, end, *this, true);
+}
+
+PLY_NO_INLINE const char* ByteClass::findFirstNotIn(const char* start, const char* end) const {
+    return getKernels().findInClass(start, end, *this, false);
+}
+
+PLY_NO_INLINE const char* findByteInRange(const char* start, const char* end, char value) {
+    return getKernels().findByte(start, end, value);
+}
+
+} // namespace ply
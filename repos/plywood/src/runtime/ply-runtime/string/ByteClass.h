@@ -0,0 +1,71 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+A set of byte values. Besides the plain 256-bit mask, `ByteClass` stores the same set as a pair of
+16-byte tables indexed by the low nibble of a byte, which lets the SIMD kernels test 16 or 32 bytes
+at a time using a byte shuffle.
+
+The constructor is `constexpr`, so a `ByteClass` declared at namespace scope is initialized at
+compile time.
+*/
+struct ByteClass {
+    u32 mask[8] = {};
+
+    // Bit (hi & 7) of nibbleBits[hi >> 3][lo] is set if the byte (hi << 4) | lo is in the set.
+    u8 nibbleBits[2][16] = {};
+
+    constexpr ByteClass() = default;
+
+    /*!
+    Constructs a `ByteClass` from a 256-bit mask in the format used by `fmt::scanUsingMask()`.
+    */
+    constexpr ByteClass(const u32* mask_) {
+        for (u32 i = 0; i < 8; i++) {
+            this->mask[i] = mask_[i];
+        }
+        for (u32 c = 0; c < 256; c++) {
+            if ((mask_[c >> 5] & (1u << (c & 31))) != 0) {
+                this->nibbleBits[c >> 7][c & 15] |= u8(1u << ((c >> 4) & 7));
+            }
+        }
+    }
+
+    /*!
+    Returns `true` if `c` is in the set.
+    */
+    PLY_INLINE bool contains(char c) const {
+        u8 u = (u8) c;
+        return (this->mask[u >> 5] & (1u << (u & 31))) != 0;
+    }
+
+    /*!
+    \beginGroup
+    Scan kernels. `findFirstIn()` returns a pointer to the first byte in the range [`start`,
+    `end`) that belongs to the set, and `findFirstNotIn()` returns a pointer to the first byte that
+    doesn't. Both return `end` if no such byte exists.
+
+    On x86/64, the kernel is selected at runtime: AVX2 if the CPU supports it, otherwise SSSE3,
+    otherwise a scalar loop. NEON is used on ARM64.
+    */
+    PLY_DLL_ENTRY const char* findFirstIn(const char* start, const char* end) const;
+    PLY_DLL_ENTRY const char* findFirstNotIn(const char* start, const char* end) const;
+    /*!
+    \endGroup
+    */
+};
+
+/*!
+Returns a pointer to the first occurrence of `value` in the range [`start`, `end`), or `end` if
+there is none. Uses the same runtime-selected kernels as `ByteClass`.
+*/
+PLY_DLL_ENTRY const char* findByteInRange(const char* start, const char* end, char value);
+
+} // namespace ply
@@ -5,46 +5,63 @@
 #include <ply-runtime/Precomp.h>
 #include <ply-runtime/Core.h>
 #include <ply-runtime/string/Label.h>
+#include <ply-runtime/memory/Arena.h>
 
 namespace ply {
 
 LabelMap LabelMap::instance;
 
 PLY_NO_INLINE LabelMap::LabelMap() {
-    this->bigPool.append('\0');
+    for (Shard& shard : this->shards) {
+        // Offset 0 is never used, so that Label{0} remains invalid.
+        shard.base = &shard.bigPool.append('\0');
+    }
 }
 
 PLY_NO_INLINE Label LabelMap::insertOrFind(StringView view) {
-    PLY_RACE_DETECT_GUARD(this->raceDetector);
+    u32 shardIdx = getShardIndex(view);
+    Shard& shard = this->shards[shardIdx];
+    {
+        // Most calls find an existing label, so try a shared lock first.
+        SharedLockGuard<RWLock> guard{shard.rwLock};
+        auto cursor = shard.strToIndex.find(view, &shard.bigPool);
+        if (cursor.wasFound())
+            return Label{(*cursor << ShardBits) | shardIdx};
+    }
 
-    auto cursor = this->strToIndex.insertOrFind(view, &this->bigPool);
+    ExclusiveLockGuard<RWLock> guard{shard.rwLock};
+    // The map outlives any Arena that the caller may be using.
+    Arena::Scope noArena{nullptr};
+    auto cursor = shard.strToIndex.insertOrFind(view, &shard.bigPool);
     if (cursor.wasFound())
-        return Label{*cursor};
+        return Label{(*cursor << ShardBits) | shardIdx};
 
     u32 numEntryBytes = details::LabelEncoder::getEncLen(view.numBytes) + view.numBytes;
-    u32 resultID = safeDemote<u32>(this->bigPool.numItems());
-    *cursor = resultID;
+    u32 offset = safeDemote<u32>(shard.bigPool.numItems());
+    PLY_ASSERT(offset < (1u << (32 - ShardBits)));
+    *cursor = offset;
 
-    char* ptr = this->bigPool.alloc(numEntryBytes);
+    char* ptr = shard.bigPool.alloc(numEntryBytes);
     details::LabelEncoder::encodeValue(ptr, view.numBytes);
     memcpy(ptr, view.bytes, view.numBytes);
-    PLY_ASSERT(ptr + view.numBytes == this->bigPool.end());
-    return Label{resultID};
+    PLY_ASSERT(ptr + view.numBytes == shard.bigPool.end());
+    return Label{(offset << ShardBits) | shardIdx};
 }
 
 PLY_NO_INLINE Label LabelMap::find(StringView view) const {
-    PLY_RACE_DETECT_GUARD(this->raceDetector);
-
-    auto cursor = this->strToIndex.find(view, &this->bigPool);
+    u32 shardIdx = getShardIndex(view);
+    const Shard& shard = this->shards[shardIdx];
+    SharedLockGuard<RWLock> guard{shard.rwLock};
+    auto cursor = shard.strToIndex.find(view, &shard.bigPool);
     if (cursor.wasFound())
-        return Label{*cursor};
-    return {};    
+        return Label{(*cursor << ShardBits) | shardIdx};
+    return {};
 }
 
 PLY_NO_INLINE StringView LabelMap::view(Label label) const {
-    PLY_RACE_DETECT_GUARD(this->raceDetector);
-
-    const char* ptr = this->bigPool.get(label.idx);
+    // The entry was fully written before its Label was returned by insertOrFind(), and the
+    // shard's BigPool never moves, so no lock is needed here.
+    const char* ptr = this->shards[label.idx & (NumShards - 1)].base + (label.idx >> ShardBits);
     u32 numBytes = details::LabelEncoder::decodeValue(ptr);
     return {ptr, numBytes};
 }
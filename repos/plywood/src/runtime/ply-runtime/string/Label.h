@@ -8,7 +8,7 @@
 #include <ply-runtime/container/BigPool.h>
 #include <ply-runtime/container/HashMap.h>
 #include <ply-runtime/string/details/LabelEncoder.h>
-#include <ply-runtime/thread/RaceDetector.h>
+#include <ply-runtime/thread/RWLock.h>
 
 namespace ply {
 
@@ -32,8 +32,21 @@ PLY_INLINE Hasher& operator<<(Hasher& hasher, const Label& label) {
     return hasher;
 }
 
+// LabelMap is safe to use from multiple threads. Labels are sharded by hash across several
+// BigPools. Each shard has its own lock for lookups and inserts, but each BigPool is append-only
+// and InPlaceOnly, so it never moves and view() doesn't take any lock.
 struct LabelMap {
+    // The low bits of each Label's index identify its shard.
+    static constexpr u32 ShardBits = 3;
+    static constexpr u32 NumShards = 1 << ShardBits;
+
 private:
+    // The shard is selected by the high bits of the hash, because each shard's HashMap selects
+    // cells using the low bits.
+    static PLY_INLINE u32 getShardIndex(StringView view) {
+        return Hasher::hash(view) >> (32 - ShardBits);
+    }
+
     struct Traits {
         using Key = StringView;
         using Item = u32;
@@ -45,9 +58,15 @@ private:
         }
     };
 
-    PLY_DEFINE_RACE_DETECTOR(raceDetector)
-    BigPool<> bigPool;
-    HashMap<Traits> strToIndex;
+    struct Shard {
+        mutable RWLock rwLock;
+        BigPool<> bigPool{BaseBigPool::DefaultNumReservedBytes / NumShards,
+                           BaseBigPool::InPlaceOnly};
+        HashMap<Traits> strToIndex;
+        const char* base = nullptr; // Never changes, so it can be read without a lock
+    };
+
+    Shard shards[NumShards];
 
 public:
     LabelMap();
@@ -61,8 +61,12 @@ PLY_NO_INLINE DecodeResult UTF8::decodePointSlowPath(StringView view) {
             break;
         }
 
-        default:
+        default: {
+            // Unexpected continuation byte, or a byte that never appears in UTF-8. No amount of
+            // additional input would make it valid.
+            result.status = DecodeResult::Status::Invalid;
             break;
+        }
     }
 
     // Bad encoding; consume just one byte
@@ -0,0 +1,486 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/string/TextKernels.h>
+#include <ply-runtime/string/TextEncoding.h>
+#include <string.h>
+#if PLY_CPU_X64
+#define PLY_TEXTKERNELS_SSE2 1
+#include <emmintrin.h>
+#elif PLY_CPU_ARM64
+#define PLY_TEXTKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ply {
+
+//------------------------------------------------------------------
+// Block16
+//
+// Tests 16 bytes at a time. Each test returns a mask with bit i set if byte i passes the test.
+// The kernels below are written entirely in terms of these masks.
+//------------------------------------------------------------------
+struct Block16 {
+#if PLY_TEXTKERNELS_SSE2
+    __m128i v;
+
+    static PLY_INLINE Block16 load(const char* src) {
+        return {_mm_loadu_si128((const __m128i*) src)};
+    }
+    PLY_INLINE u32 highBits() const {
+        return (u32) _mm_movemask_epi8(this->v);
+    }
+    PLY_INLINE u32 equal(u8 c) const {
+        return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(this->v, _mm_set1_epi8((char) c)));
+    }
+    PLY_INLINE u32 atLeast(u8 c) const {
+        __m128i bound = _mm_set1_epi8((char) c);
+        return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(this->v, bound), this->v));
+    }
+    PLY_INLINE u32 sum() const {
+        __m128i sums = _mm_sad_epu8(this->v, _mm_setzero_si128());
+        return (u32) (_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    }
+    // Writes each byte as a 16-bit unit. All bytes must be less than 0x80.
+    template <bool BigEndian>
+    PLY_INLINE void storeWidened(char* dst) const {
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = BigEndian ? _mm_unpacklo_epi8(zero, this->v) : _mm_unpacklo_epi8(this->v, zero);
+        __m128i hi = BigEndian ? _mm_unpackhi_epi8(zero, this->v) : _mm_unpackhi_epi8(this->v, zero);
+        _mm_storeu_si128((__m128i*) dst, lo);
+        _mm_storeu_si128((__m128i*) (dst + 16), hi);
+    }
+    // Writes each 16-bit unit as a byte. All units must be less than 0x80.
+    template <bool BigEndian>
+    PLY_INLINE void storeNarrowed(char* dst) const {
+        __m128i units = BigEndian ? _mm_srli_epi16(this->v, 8) : this->v;
+        _mm_storel_epi64((__m128i*) dst, _mm_packus_epi16(units, units));
+    }
+#elif PLY_TEXTKERNELS_NEON
+    uint8x16_t v;
+
+    static PLY_INLINE u32 toMask(uint8x16_t matches) {
+        static const u8 bitValues[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t bits = vandq_u8(matches, vld1q_u8(bitValues));
+        return u32(vaddv_u8(vget_low_u8(bits))) | (u32(vaddv_u8(vget_high_u8(bits))) << 8);
+    }
+    static PLY_INLINE Block16 load(const char* src) {
+        return {vld1q_u8((const u8*) src)};
+    }
+    PLY_INLINE u32 highBits() const {
+        return toMask(vcltq_s8(vreinterpretq_s8_u8(this->v), vdupq_n_s8(0)));
+    }
+    PLY_INLINE u32 equal(u8 c) const {
+        return toMask(vceqq_u8(this->v, vdupq_n_u8(c)));
+    }
+    PLY_INLINE u32 atLeast(u8 c) const {
+        return toMask(vcgeq_u8(this->v, vdupq_n_u8(c)));
+    }
+    PLY_INLINE u32 sum() const {
+        return vaddlvq_u8(this->v);
+    }
+    template <bool BigEndian>
+    PLY_INLINE void storeWidened(char* dst) const {
+        uint8x16_t zero = vdupq_n_u8(0);
+        uint8x16x2_t units = BigEndian ? vzipq_u8(zero, this->v) : vzipq_u8(this->v, zero);
+        vst1q_u8((u8*) dst, units.val[0]);
+        vst1q_u8((u8*) dst + 16, units.val[1]);
+    }
+    template <bool BigEndian>
+    PLY_INLINE void storeNarrowed(char* dst) const {
+        uint16x8_t units = vreinterpretq_u16_u8(this->v);
+        vst1_u8((u8*) dst, BigEndian ? vshrn_n_u16(units, 8) : vmovn_u16(units));
+    }
+#else
+    u8 v[16];
+
+    static PLY_INLINE Block16 load(const char* src) {
+        Block16 block;
+        memcpy(block.v, src, 16);
+        return block;
+    }
+    PLY_INLINE u32 highBits() const {
+        return this->atLeast(0x80);
+    }
+    PLY_INLINE u32 equal(u8 c) const {
+        u32 mask = 0;
+        for (u32 i = 0; i < 16; i++) {
+            mask |= u32(this->v[i] == c) << i;
+        }
+        return mask;
+    }
+    PLY_INLINE u32 atLeast(u8 c) const {
+        u32 mask = 0;
+        for (u32 i = 0; i < 16; i++) {
+            mask |= u32(this->v[i] >= c) << i;
+        }
+        return mask;
+    }
+    PLY_INLINE u32 sum() const {
+        u32 total = 0;
+        for (u32 i = 0; i < 16; i++) {
+            total += this->v[i];
+        }
+        return total;
+    }
+    template <bool BigEndian>
+    PLY_INLINE void storeWidened(char* dst) const {
+        for (u32 i = 0; i < 16; i++) {
+            UTF16<BigEndian>::putUnit(dst + i * 2, this->v[i]);
+        }
+    }
+    template <bool BigEndian>
+    PLY_INLINE void storeNarrowed(char* dst) const {
+        for (u32 i = 0; i < 8; i++) {
+            dst[i] = (char) UTF16<BigEndian>::getUnit((const char*) this->v + i * 2);
+        }
+    }
+#endif
+
+    // Returns a mask of the bytes that belong to UTF-16 units greater than or equal to 0x80.
+    template <bool BigEndian>
+    PLY_INLINE u32 nonASCII16() const {
+        // The most significant byte of each unit must be zero.
+        u32 msbMask = BigEndian ? 0x5555 : 0xaaaa;
+        return this->highBits() | (~this->equal(0) & msbMask);
+    }
+};
+
+static PLY_INLINE u32 countBits(u32 v) {
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return (((v + (v >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+//------------------------------------------------------------------
+// Scalar helpers
+//------------------------------------------------------------------
+static PLY_INLINE bool isContinuation(u8 c) {
+    return (c & 0xc0) == 0x80;
+}
+
+// Returns the length of the well-formed UTF-8 sequence at the start of [src, end), or 0 if the
+// sequence is ill-formed or truncated. src must be less than end.
+static PLY_INLINE u32 wellFormedLength(const u8* src, const u8* end) {
+    u8 first = src[0];
+    if (first < 0x80)
+        return 1;
+    if (first < 0xc2)
+        return 0; // Continuation byte, or overlong 2-byte sequence
+    if (first < 0xe0)
+        return (end - src >= 2 && isContinuation(src[1])) ? 2 : 0;
+    if (first < 0xf0) {
+        // Reject overlong sequences and surrogates.
+        u8 lo = (first == 0xe0) ? 0xa0 : 0x80;
+        u8 hi = (first == 0xed) ? 0x9f : 0xbf;
+        return (end - src >= 3 && src[1] >= lo && src[1] <= hi && isContinuation(src[2])) ? 3 : 0;
+    }
+    if (first < 0xf5) {
+        // Reject overlong sequences and points above U+10FFFF.
+        u8 lo = (first == 0xf0) ? 0x90 : 0x80;
+        u8 hi = (first == 0xf4) ? 0x8f : 0xbf;
+        return (end - src >= 4 && src[1] >= lo && src[1] <= hi && isContinuation(src[2]) &&
+                isContinuation(src[3]))
+                   ? 4
+                   : 0;
+    }
+    return 0;
+}
+
+// The sequence must be well-formed.
+static PLY_INLINE u32 decodeWellFormed(const u8* src, u32 numBytes) {
+    switch (numBytes) {
+        case 1:
+            return src[0];
+        case 2:
+            return (u32(src[0] & 0x1f) << 6) | (src[1] & 0x3f);
+        case 3:
+            return (u32(src[0] & 0xf) << 12) | (u32(src[1] & 0x3f) << 6) | (src[2] & 0x3f);
+        default:
+            return (u32(src[0] & 0x7) << 18) | (u32(src[1] & 0x3f) << 12) |
+                   (u32(src[2] & 0x3f) << 6) | (src[3] & 0x3f);
+    }
+}
+
+static PLY_INLINE void countASCIIByte(TextKernels::ASCIICounts* counts, u8 c) {
+    counts->numPoints++;
+    counts->totalPointValue += c;
+    if (c < 32) {
+        if (c == '\n') {
+            counts->numPlainAscii++;
+            counts->numLines++;
+            counts->numWhitespace++;
+            if (counts->prevWasCR) {
+                counts->numCRLF++;
+            }
+        } else if (c == '\t') {
+            counts->numPlainAscii++;
+            counts->numWhitespace++;
+        } else if (c == '\r') {
+            counts->numPlainAscii++;
+        } else {
+            counts->numControl++;
+            if (c == 0) {
+                counts->numNull++;
+            }
+        }
+    } else if (c < 127) {
+        counts->numPlainAscii++;
+        if (c == ' ') {
+            counts->numWhitespace++;
+        }
+    }
+    counts->prevWasCR = (c == '\r');
+}
+
+//------------------------------------------------------------------
+// TextKernels
+//------------------------------------------------------------------
+PLY_NO_INLINE u32 TextKernels::findNonASCII(StringView src) {
+    const char* cur = src.bytes;
+    const char* end = src.end();
+    for (; end - cur >= 16; cur += 16) {
+        u32 nonASCII = Block16::load(cur).highBits();
+        if (nonASCII != 0)
+            return u32(cur - src.bytes) + countTrailingZeros(nonASCII);
+    }
+    while (cur < end && u8(*cur) < 0x80) {
+        cur++;
+    }
+    return u32(cur - src.bytes);
+}
+
+PLY_NO_INLINE u32 TextKernels::findInvalidUTF8(StringView src) {
+    const u8* start = (const u8*) src.bytes;
+    const u8* end = start + src.numBytes;
+    const u8* cur = start;
+    const u8* boundary = start; // End of the last complete sequence that was checked
+
+    // Bits that carry over into the next block: continuation bytes that are expected, and leading
+    // bytes that restrict the range of the following byte.
+    u32 carryExpected = 0;
+    u32 carryE0 = 0;
+    u32 carryED = 0;
+    u32 carryF0 = 0;
+    u32 carryF4 = 0;
+    for (; end - cur >= 16; cur += 16) {
+        Block16 block = Block16::load((const char*) cur);
+        u32 high = block.highBits();
+        if ((high | carryExpected) == 0) {
+            boundary = cur + 16;
+            continue;
+        }
+        u32 lead2 = block.atLeast(0xc0);
+        u32 lead3 = block.atLeast(0xe0);
+        u32 lead4 = block.atLeast(0xf0);
+        u32 expected = (lead2 << 1) | (lead3 << 2) | (lead4 << 3) | carryExpected;
+        u32 e0 = block.equal(0xe0);
+        u32 ed = block.equal(0xed);
+        u32 f0 = block.equal(0xf0);
+        u32 f4 = block.equal(0xf4);
+        u32 atLeastA0 = block.atLeast(0xa0);
+        u32 atLeast90 = block.atLeast(0x90);
+        // Continuation bytes must appear exactly where they're expected.
+        u32 error = expected ^ (high & ~lead2);
+        error |= block.equal(0xc0) | block.equal(0xc1) | block.atLeast(0xf5);
+        error |= ((e0 << 1) | carryE0) & ~atLeastA0;
+        error |= ((ed << 1) | carryED) & atLeastA0;
+        error |= ((f0 << 1) | carryF0) & ~atLeast90;
+        error |= ((f4 << 1) | carryF4) & atLeast90;
+        if ((error & 0xffff) != 0)
+            break; // Find the exact position below
+        carryExpected = expected >> 16;
+        carryE0 = e0 >> 15;
+        carryED = ed >> 15;
+        carryF0 = f0 >> 15;
+        carryF4 = f4 >> 15;
+        // If a sequence continues into the next block, it starts at the last leading byte.
+        boundary = carryExpected ? cur + (63 - countLeadingZeros(lead2)) : cur + 16;
+    }
+
+    // Check the rest one sequence at a time.
+    cur = boundary;
+    while (cur < end) {
+        u32 numBytes = wellFormedLength(cur, end);
+        if (numBytes == 0)
+            break;
+        cur += numBytes;
+    }
+    return u32(cur - start);
+}
+
+PLY_NO_INLINE TextKernels::ConvertResult TextKernels::convertASCII(MutableStringView dst,
+                                                                   StringView src) {
+    u32 numBytes = findNonASCII(src.left(min(src.numBytes, dst.numBytes)));
+    memcpy(dst.bytes, src.bytes, numBytes);
+    return {numBytes, numBytes};
+}
+
+PLY_NO_INLINE TextKernels::ConvertResult TextKernels::convertUTF8ToUTF8(MutableStringView dst,
+                                                                        StringView src) {
+    // Only validate as much input as can fit in dst.
+    u32 numValid = findInvalidUTF8(src.left(min(src.numBytes, dst.numBytes + 3)));
+    u32 numBytes = min(numValid, dst.numBytes);
+    if (numBytes < numValid) {
+        // Don't split a sequence.
+        while (numBytes > 0 && isContinuation(src.bytes[numBytes])) {
+            numBytes--;
+        }
+    }
+    memcpy(dst.bytes, src.bytes, numBytes);
+    return {numBytes, numBytes};
+}
+
+template <bool BigEndian>
+static PLY_INLINE TextKernels::ConvertResult convertUTF8ToUTF16Impl(MutableStringView dst,
+                                                                    StringView src) {
+    const u8* srcCur = (const u8*) src.bytes;
+    const u8* srcEnd = srcCur + src.numBytes;
+    char* dstCur = dst.bytes;
+    char* dstEnd = dst.bytes + dst.numBytes;
+    while (srcCur < srcEnd) {
+        if (srcEnd - srcCur >= 16 && dstEnd - dstCur >= 32) {
+            Block16 block = Block16::load((const char*) srcCur);
+            u32 nonASCII = block.highBits();
+            if (nonASCII == 0) {
+                block.storeWidened<BigEndian>(dstCur);
+                srcCur += 16;
+                dstCur += 32;
+                continue;
+            }
+            for (u32 i = countTrailingZeros(nonASCII); i > 0; i--) {
+                UTF16<BigEndian>::putUnit(dstCur, *srcCur);
+                srcCur++;
+                dstCur += 2;
+            }
+        }
+
+        // Convert one code point.
+        u32 numSrcBytes = wellFormedLength(srcCur, srcEnd);
+        if (numSrcBytes == 0)
+            break;
+        u32 point = decodeWellFormed(srcCur, numSrcBytes);
+        if (u32(dstEnd - dstCur) < UTF16<BigEndian>::numBytes(point))
+            break;
+        dstCur += UTF16<BigEndian>::encodePoint({dstCur, u32(dstEnd - dstCur)}, point);
+        srcCur += numSrcBytes;
+    }
+    return {u32(srcCur - (const u8*) src.bytes), u32(dstCur - dst.bytes)};
+}
+
+PLY_NO_INLINE TextKernels::ConvertResult
+TextKernels::convertUTF8ToUTF16(MutableStringView dst, StringView src, bool bigEndian) {
+    return bigEndian ? convertUTF8ToUTF16Impl<true>(dst, src)
+                     : convertUTF8ToUTF16Impl<false>(dst, src);
+}
+
+template <bool BigEndian>
+static PLY_INLINE TextKernels::ConvertResult convertUTF16ToUTF8Impl(MutableStringView dst,
+                                                                    StringView src) {
+    const char* srcCur = src.bytes;
+    const char* srcEnd = src.end();
+    char* dstCur = dst.bytes;
+    char* dstEnd = dst.bytes + dst.numBytes;
+    while (srcEnd - srcCur >= 2) {
+        if (srcEnd - srcCur >= 16 && dstEnd - dstCur >= 8) {
+            Block16 block = Block16::load(srcCur);
+            u32 nonASCII = block.nonASCII16<BigEndian>();
+            if (nonASCII == 0) {
+                block.storeNarrowed<BigEndian>(dstCur);
+                srcCur += 16;
+                dstCur += 8;
+                continue;
+            }
+            for (u32 i = countTrailingZeros(nonASCII) >> 1; i > 0; i--) {
+                *dstCur = (char) UTF16<BigEndian>::getUnit(srcCur);
+                srcCur += 2;
+                dstCur++;
+            }
+        }
+
+        // Convert one code point. Unpaired surrogates are left to the caller.
+        u16 first = UTF16<BigEndian>::getUnit(srcCur);
+        u32 point = first;
+        u32 numSrcBytes = 2;
+        if (first >= 0xd800 && first < 0xe000) {
+            if (first >= 0xdc00 || srcEnd - srcCur < 4)
+                break;
+            u16 second = UTF16<BigEndian>::getUnit(srcCur + 2);
+            if (!(second >= 0xdc00 && second < 0xe000))
+                break;
+            point = 0x10000 + ((u32(first) - 0xd800) << 10) + (second - 0xdc00);
+            numSrcBytes = 4;
+        }
+        if (u32(dstEnd - dstCur) < UTF8::numBytes(point))
+            break;
+        dstCur += UTF8::encodePoint({dstCur, u32(dstEnd - dstCur)}, point);
+        srcCur += numSrcBytes;
+    }
+    return {u32(srcCur - src.bytes), u32(dstCur - dst.bytes)};
+}
+
+PLY_NO_INLINE TextKernels::ConvertResult
+TextKernels::convertUTF16ToUTF8(MutableStringView dst, StringView src, bool bigEndian) {
+    return bigEndian ? convertUTF16ToUTF8Impl<true>(dst, src)
+                     : convertUTF16ToUTF8Impl<false>(dst, src);
+}
+
+template <bool BigEndian>
+static PLY_INLINE u32 narrowASCII16Impl(MutableStringView dst, StringView src) {
+    const char* srcCur = src.bytes;
+    const char* srcEnd = srcCur + min(src.numBytes & ~1u, dst.numBytes * 2);
+    char* dstCur = dst.bytes;
+    for (; srcEnd - srcCur >= 16; srcCur += 16, dstCur += 8) {
+        Block16 block = Block16::load(srcCur);
+        u32 nonASCII = block.nonASCII16<BigEndian>();
+        if (nonASCII != 0) {
+            srcEnd = srcCur + (countTrailingZeros(nonASCII) & ~1u);
+            break;
+        }
+        block.storeNarrowed<BigEndian>(dstCur);
+    }
+    for (; srcCur < srcEnd; srcCur += 2, dstCur++) {
+        u16 unit = UTF16<BigEndian>::getUnit(srcCur);
+        if (unit >= 0x80)
+            break;
+        *dstCur = (char) unit;
+    }
+    return u32(dstCur - dst.bytes);
+}
+
+PLY_NO_INLINE u32 TextKernels::narrowASCII16(MutableStringView dst, StringView src,
+                                             bool bigEndian) {
+    return bigEndian ? narrowASCII16Impl<true>(dst, src) : narrowASCII16Impl<false>(dst, src);
+}
+
+PLY_NO_INLINE u32 TextKernels::countASCII(ASCIICounts* counts, StringView src) {
+    const char* cur = src.bytes;
+    const char* end = src.end();
+    for (; end - cur >= 16; cur += 16) {
+        Block16 block = Block16::load(cur);
+        if (block.highBits() != 0)
+            break;
+        u32 lf = block.equal('\n');
+        u32 cr = block.equal('\r');
+        u32 tab = block.equal('\t');
+        u32 control = ~(block.atLeast(32) | lf | cr | tab) & 0xffff;
+        u32 del = block.equal(127);
+        counts->numPoints += 16;
+        counts->totalPointValue += block.sum();
+        counts->numLines += countBits(lf);
+        counts->numCRLF += countBits(((cr << 1) | u32(counts->prevWasCR)) & lf);
+        counts->numControl += countBits(control);
+        counts->numNull += countBits(block.equal(0));
+        counts->numPlainAscii += 16 - countBits(control | del);
+        counts->numWhitespace += countBits(lf | tab | block.equal(' '));
+        counts->prevWasCR = (cr >> 15) != 0;
+    }
+    for (; cur < end && u8(*cur) < 0x80; cur++) {
+        countASCIIByte(counts, *cur);
+    }
+    return u32(cur - src.bytes);
+}
+
+} // namespace ply
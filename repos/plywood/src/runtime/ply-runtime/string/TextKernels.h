@@ -0,0 +1,78 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/string/StringView.h>
+
+namespace ply {
+
+//------------------------------------------------------------------------------------------------
+/*!
+Bulk text kernels used by `TextConverter` and `TextFormat::autodetect()`. They use SSE2 on x64 and
+NEON on ARM64, and fall back to scalar loops on other targets.
+
+The conversion functions only convert input that the per-point `decodePoint()` functions in
+`TextEncoding.h` would decode as `Valid`, and whose result is identical when converted one point
+at a time. Each one stops at the first code point that is invalid, overlong, truncated by the end
+of `src`, or that doesn't fit in `dst`, so the caller can handle it one point at a time.
+*/
+struct TextKernels {
+    struct ConvertResult {
+        u32 numSrcBytes = 0;
+        u32 numDstBytes = 0;
+    };
+
+    // Running counts of ASCII characters, in the form collected by TextFormat::autodetect.
+    struct ASCIICounts {
+        u32 numPoints = 0;
+        u32 totalPointValue = 0;
+        u32 numLines = 0;
+        u32 numCRLF = 0;
+        u32 numControl = 0; // Non-whitespace points < 32, including nulls
+        u32 numNull = 0;
+        u32 numPlainAscii = 0; // Includes whitespace, excludes control characters < 32
+        u32 numWhitespace = 0;
+        bool prevWasCR = false;
+    };
+
+    /*!
+    Returns the number of bytes at the start of `src` that are less than 0x80.
+    */
+    static PLY_DLL_ENTRY u32 findNonASCII(StringView src);
+
+    /*!
+    Returns the length of the longest prefix of `src` that consists of complete, well-formed UTF-8
+    sequences. Overlong encodings, surrogates and code points above U+10FFFF are rejected.
+    */
+    static PLY_DLL_ENTRY u32 findInvalidUTF8(StringView src);
+
+    /*!
+    \beginGroup
+    Converters between pairs of encodings.
+    */
+    static PLY_DLL_ENTRY ConvertResult convertASCII(MutableStringView dst, StringView src);
+    static PLY_DLL_ENTRY ConvertResult convertUTF8ToUTF8(MutableStringView dst, StringView src);
+    static PLY_DLL_ENTRY ConvertResult convertUTF8ToUTF16(MutableStringView dst, StringView src,
+                                                          bool bigEndian);
+    static PLY_DLL_ENTRY ConvertResult convertUTF16ToUTF8(MutableStringView dst, StringView src,
+                                                          bool bigEndian);
+    /*!
+    \endGroup
+    */
+
+    /*!
+    Copies the leading UTF-16 code units of `src` that are less than 0x80 to `dst`, one byte per
+    unit, and returns the number of units copied.
+    */
+    static PLY_DLL_ENTRY u32 narrowASCII16(MutableStringView dst, StringView src, bool bigEndian);
+
+    /*!
+    Adds the characters at the start of `src` that are less than 0x80 to `counts`, and returns the
+    number of bytes counted.
+    */
+    static PLY_DLL_ENTRY u32 countASCII(ASCIICounts* counts, StringView src);
+};
+
+} // namespace ply
@@ -0,0 +1,322 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/Precomp.h>
+#include <ply-runtime/thread/ThreadPool.h>
+#include <ply-runtime/thread/Affinity.h>
+
+namespace ply {
+
+ThreadLocal<ThreadPool::Worker*> ThreadPool::currentWorker_;
+
+//-----------------------------------------------------------------------
+// Deque
+//
+// This follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê, Pop, Cohen &
+// Zappa Nardelli, 2013), with the buffer growing as needed.
+//-----------------------------------------------------------------------
+static constexpr s64 InitialDequeSize = 256;
+
+PLY_NO_INLINE ThreadPool::Deque::Buffer* createDequeBuffer(s64 size) {
+    PLY_ASSERT(isPowerOf2((u64) size));
+    ThreadPool::Deque::Buffer* buf = new ThreadPool::Deque::Buffer;
+    buf->sizeMask = size - 1;
+    buf->items = new Atomic<ThreadPool::Task*>[size];
+    return buf;
+}
+
+PLY_NO_INLINE void destroyDequeBuffer(ThreadPool::Deque::Buffer* buf) {
+    delete[] buf->items;
+    delete buf;
+}
+
+PLY_NO_INLINE ThreadPool::Deque::Deque() {
+    this->buffer.storeNonatomic(createDequeBuffer(InitialDequeSize));
+}
+
+PLY_NO_INLINE ThreadPool::Deque::~Deque() {
+    PLY_ASSERT(this->isEmpty());
+    destroyDequeBuffer(this->buffer.loadNonatomic());
+    for (Buffer* buf : this->retired) {
+        destroyDequeBuffer(buf);
+    }
+}
+
+PLY_NO_INLINE void ThreadPool::Deque::push(Task* task) {
+    s64 b = this->bottom.load(Relaxed);
+    s64 t = this->top.load(Acquire);
+    Buffer* buf = this->buffer.load(Relaxed);
+    if (b - t > buf->sizeMask) {
+        // Full. Copy the live items to a buffer twice the size.
+        Buffer* newBuf = createDequeBuffer((buf->sizeMask + 1) * 2);
+        for (s64 i = t; i < b; i++) {
+            newBuf->items[i & newBuf->sizeMask].store(buf->items[i & buf->sizeMask].load(Relaxed),
+                                                      Relaxed);
+        }
+        this->retired.append(buf);
+        this->buffer.store(newBuf, Release);
+        buf = newBuf;
+    }
+    buf->items[b & buf->sizeMask].store(task, Relaxed);
+    threadFenceRelease();
+    this->bottom.store(b + 1, Relaxed);
+}
+
+PLY_NO_INLINE ThreadPool::Task* ThreadPool::Deque::pop() {
+    s64 b = this->bottom.load(Relaxed) - 1;
+    Buffer* buf = this->buffer.load(Relaxed);
+    this->bottom.store(b, Relaxed);
+    threadFenceSeqCst();
+    s64 t = this->top.load(Relaxed);
+    if (t > b) {
+        // Empty
+        this->bottom.store(b + 1, Relaxed);
+        return nullptr;
+    }
+    Task* task = buf->items[b & buf->sizeMask].load(Relaxed);
+    if (t == b) {
+        // This is the last item. Race against thieves for it.
+        if (!this->top.compareExchangeStrong(t, t + 1, SeqCst)) {
+            task = nullptr;
+        }
+        this->bottom.store(b + 1, Relaxed);
+    }
+    return task;
+}
+
+PLY_NO_INLINE ThreadPool::Task* ThreadPool::Deque::steal() {
+    s64 t = this->top.load(Acquire);
+    threadFenceSeqCst();
+    s64 b = this->bottom.load(Acquire);
+    if (t >= b)
+        return nullptr;
+    Buffer* buf = this->buffer.load(Acquire);
+    Task* task = buf->items[t & buf->sizeMask].load(Relaxed);
+    if (!this->top.compareExchangeStrong(t, t + 1, SeqCst))
+        return nullptr; // Lost the race to another thief or to the owner
+    return task;
+}
+
+//-----------------------------------------------------------------------
+// ThreadPool
+//-----------------------------------------------------------------------
+PLY_NO_INLINE ThreadPool::ThreadPool(u32 numThreads, bool pinThreads) {
+    Affinity affinity;
+    if (numThreads == 0) {
+        numThreads = affinity.getNumHWThreads();
+    }
+    numThreads = max<u32>(numThreads, 1);
+    this->workers.resize(numThreads);
+    for (u32 i = 0; i < numThreads; i++) {
+        Worker* worker = new Worker;
+        worker->pool = this;
+        worker->index = i;
+        worker->stealSeed = i * 0x9e3779b9u + 1;
+        this->workers[i] = worker;
+    }
+
+    // Start workers only after the workers array is complete, since they steal from each other.
+    for (u32 i = 0; i < numThreads; i++) {
+        Worker* worker = this->workers[i];
+        ureg core = 0;
+        ureg hwThread = 0;
+        if (pinThreads && affinity.isAccurate()) {
+            // Fill each physical core before using its additional hardware threads.
+            u32 numCores = affinity.getNumPhysicalCores();
+            core = i % numCores;
+            hwThread = (i / numCores) % affinity.getNumHWThreadsForCore(core);
+        } else {
+            pinThreads = false;
+        }
+        worker->thread.run([worker, pinThreads, affinity, core, hwThread]() mutable {
+            if (pinThreads) {
+                affinity.setAffinity(core, hwThread);
+            }
+            worker->pool->runWorker(worker);
+        });
+    }
+}
+
+PLY_NO_INLINE ThreadPool::~ThreadPool() {
+    {
+        LockGuard<Mutex> guard{this->mutex};
+        this->isShuttingDown = true;
+        this->wakeCondVar.wakeAll();
+    }
+    for (Worker* worker : this->workers) {
+        worker->thread.join();
+    }
+    PLY_ASSERT(this->injected.isEmpty());
+}
+
+PLY_NO_INLINE void ThreadPool::submit(Task* task) {
+    if (Worker* worker = this->getCurrentWorker()) {
+        worker->deque.push(task);
+    } else {
+        LockGuard<Mutex> guard{this->mutex};
+        this->injected.append(task);
+        this->numInjected.fetchAdd(1, Relaxed);
+    }
+    // Pairs with the fence in runWorker(). Either a worker that's about to sleep sees the new
+    // task, or we see that it's sleeping and wake it.
+    threadFenceSeqCst();
+    if (this->numSleeping.load(Relaxed) > 0) {
+        this->wakeWorker();
+    }
+}
+
+PLY_NO_INLINE void ThreadPool::wakeWorker() {
+    LockGuard<Mutex> guard{this->mutex};
+    this->wakeCondVar.wakeOne();
+}
+
+PLY_NO_INLINE bool ThreadPool::hasWork() const {
+    if (this->numInjected.load(Relaxed) > 0)
+        return true;
+    for (const Worker* worker : this->workers) {
+        if (!worker->deque.isEmpty())
+            return true;
+    }
+    return false;
+}
+
+PLY_NO_INLINE ThreadPool::Task* ThreadPool::findTask(Worker* worker) {
+    // Own deque first
+    if (worker) {
+        if (Task* task = worker->deque.pop())
+            return task;
+    }
+
+    // Then tasks submitted from outside the pool
+    if (this->numInjected.load(Relaxed) > 0) {
+        LockGuard<Mutex> guard{this->mutex};
+        if (!this->injected.isEmpty()) {
+            Task* task = this->injected[0];
+            this->injected.erase(0);
+            this->numInjected.fetchSub(1, Relaxed);
+            return task;
+        }
+    }
+
+    // Then steal, starting from a pseudo-random victim so that thieves don't all pile onto the
+    // same worker.
+    u32 numWorkers = this->workers.numItems();
+    u32 start = 0;
+    if (worker) {
+        worker->stealSeed ^= worker->stealSeed << 13;
+        worker->stealSeed ^= worker->stealSeed >> 17;
+        worker->stealSeed ^= worker->stealSeed << 5;
+        start = worker->stealSeed % numWorkers;
+    }
+    for (u32 i = 0; i < numWorkers; i++) {
+        Worker* victim = this->workers[(start + i) % numWorkers];
+        if (victim == worker)
+            continue;
+        if (Task* task = victim->deque.steal())
+            return task;
+    }
+    return nullptr;
+}
+
+PLY_NO_INLINE void ThreadPool::execute(Task* task) {
+    // Read the group first, since runAndDestroy() deletes the task.
+    TaskGroup* group = task->group;
+    task->runAndDestroy(task);
+    if (group && group->numPending.fetchSub(1, AcquireRelease) == 1) {
+        // The group may be destroyed as soon as its waiter sees numPending reach zero, so don't
+        // touch it after this point.
+        LockGuard<Mutex> guard{this->mutex};
+        this->doneCondVar.wakeAll();
+    }
+}
+
+PLY_NO_INLINE void ThreadPool::runWorker(Worker* worker) {
+    currentWorker_.store(worker);
+    static constexpr u32 NumSpins = 64;
+    u32 numFailedAttempts = 0;
+    for (;;) {
+        if (Task* task = this->findTask(worker)) {
+            if (numFailedAttempts > 0 && this->numSleeping.load(Relaxed) > 0 && this->hasWork()) {
+                // This worker was idle, so others might be too. Wake one to share the rest of the
+                // work.
+                this->wakeWorker();
+            }
+            numFailedAttempts = 0;
+            this->execute(task);
+            continue;
+        }
+        if (++numFailedAttempts < NumSpins)
+            continue;
+
+        // Sleep until more work is submitted.
+        LockGuard<Mutex> guard{this->mutex};
+        this->numSleeping.fetchAdd(1, Relaxed);
+        threadFenceSeqCst();
+        bool hasWork = this->hasWork();
+        if (!hasWork) {
+            if (this->isShuttingDown) {
+                this->numSleeping.fetchSub(1, Relaxed);
+                break;
+            }
+            this->wakeCondVar.wait(guard);
+        }
+        this->numSleeping.fetchSub(1, Relaxed);
+        numFailedAttempts = 0;
+    }
+    currentWorker_.store(nullptr);
+}
+
+PLY_NO_INLINE void ThreadPool::parallelForRanges(u32 numItems, u32 grainSize,
+                                                 const LambdaView<void(u32 start, u32 end)>& body) {
+    if (numItems == 0)
+        return;
+    if (grainSize == 0) {
+        // Aim for several subranges per worker so that the load balances out.
+        grainSize = max<u32>(numItems / (this->numThreads() * 8), 1);
+    }
+
+    struct Splitter {
+        TaskGroup* group;
+        u32 grainSize;
+        const LambdaView<void(u32 start, u32 end)>* body;
+
+        void run(u32 start, u32 end) const {
+            // Hand off the upper half of the range until what's left is small enough.
+            while (end - start > this->grainSize) {
+                u32 mid = start + (end - start) / 2;
+                const Splitter* self = this;
+                this->group->run([self, mid, end] { self->run(mid, end); });
+                end = mid;
+            }
+            (*this->body)(start, end);
+        }
+    };
+
+    TaskGroup group{this};
+    Splitter splitter{&group, grainSize, &body};
+    splitter.run(0, numItems);
+    group.wait();
+}
+
+//-----------------------------------------------------------------------
+// TaskGroup
+//-----------------------------------------------------------------------
+PLY_NO_INLINE void TaskGroup::wait() {
+    ThreadPool::Worker* worker = this->pool->getCurrentWorker();
+    while (this->numPending.load(Acquire) > 0) {
+        // Help run tasks while waiting. They may or may not belong to this group.
+        if (ThreadPool::Task* task = this->pool->findTask(worker)) {
+            this->pool->execute(task);
+            continue;
+        }
+
+        // Nothing left to run, so this group's remaining tasks are running on other threads.
+        LockGuard<Mutex> guard{this->pool->mutex};
+        if (this->numPending.load(Acquire) == 0)
+            break;
+        this->pool->doneCondVar.wait(guard);
+    }
+}
+
+} // namespace ply
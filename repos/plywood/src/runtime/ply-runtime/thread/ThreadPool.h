@@ -0,0 +1,200 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <ply-runtime/Core.h>
+#include <ply-runtime/container/Array.h>
+#include <ply-runtime/container/ArrayView.h>
+#include <ply-runtime/container/LambdaView.h>
+#include <ply-runtime/container/Owned.h>
+#include <ply-runtime/thread/Atomic.h>
+#include <ply-runtime/thread/ConditionVariable.h>
+#include <ply-runtime/thread/Mutex.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-runtime/thread/ThreadLocal.h>
+
+namespace ply {
+
+struct TaskGroup;
+
+//------------------------------------------------------------------------------------------------
+/*!
+A `ThreadPool` runs tasks on a fixed set of worker threads.
+
+Each worker owns a Chase-Lev work-stealing deque. A task submitted from one of the pool's own
+workers is pushed onto that worker's deque, and the worker pops it back in LIFO order, which keeps
+nested fork/join work on the same thread and in cache. Idle workers steal the oldest task from the
+top of another worker's deque. Tasks submitted from any other thread go into a shared FIFO queue
+protected by a mutex. Workers that run out of tasks sleep on a condition variable until more tasks
+are submitted.
+
+Use a `TaskGroup` to wait for a set of tasks to complete, or `parallelFor()` to run a callable on
+every item in an `ArrayView`.
+
+    ThreadPool pool;
+    pool.parallelFor(items.view(), [](Item& item) { item.update(); });
+
+Tasks must not throw exceptions. All tasks must have completed before the `ThreadPool` is
+destroyed; the destructor waits for any tasks that are still queued, then joins the workers.
+*/
+struct ThreadPool {
+    //--------------------------------------
+    // Task
+    //--------------------------------------
+    struct Task {
+        // Runs the task, then deletes it.
+        void (*runAndDestroy)(Task* task) = nullptr;
+        TaskGroup* group = nullptr;
+    };
+
+    template <typename Callable>
+    struct TaskImpl : Task {
+        std::decay_t<Callable> callable;
+
+        static PLY_NO_INLINE void runAndDestroy(Task* task) {
+            TaskImpl* self = static_cast<TaskImpl*>(task);
+            self->callable();
+            delete self;
+        }
+        template <typename I>
+        PLY_INLINE TaskImpl(I&& callable, TaskGroup* group)
+            : Task{&runAndDestroy, group}, callable{std::forward<I>(callable)} {
+        }
+    };
+
+    //--------------------------------------
+    // Deque
+    // A Chase-Lev deque of task pointers. Only the owning worker calls push() and pop(), at the
+    // bottom of the deque. Any thread can call steal(), which takes from the top.
+    //--------------------------------------
+    struct Deque {
+        struct Buffer {
+            s64 sizeMask = 0;
+            Atomic<Task*>* items = nullptr;
+        };
+
+        Atomic<s64> top = 0;
+        Atomic<s64> bottom = 0;
+        Atomic<Buffer*> buffer = nullptr;
+        // Buffers that were outgrown. A thief might still be reading from one of them, so they're
+        // only freed when the deque is destroyed.
+        Array<Buffer*> retired;
+
+        PLY_DLL_ENTRY Deque();
+        PLY_DLL_ENTRY ~Deque();
+        PLY_DLL_ENTRY void push(Task* task);
+        PLY_DLL_ENTRY Task* pop();
+        // Returns nullptr if the deque is empty or if another thread took the top task first.
+        PLY_DLL_ENTRY Task* steal();
+        PLY_INLINE bool isEmpty() const {
+            return this->bottom.load(Relaxed) <= this->top.load(Relaxed);
+        }
+    };
+
+    //--------------------------------------
+    // Worker
+    //--------------------------------------
+    struct Worker {
+        ThreadPool* pool = nullptr;
+        u32 index = 0;
+        u32 stealSeed = 0;
+        Deque deque;
+        Thread thread;
+    };
+
+    Array<Owned<Worker>> workers;
+    Mutex mutex;
+    ConditionVariable wakeCondVar; // Idle workers sleep here
+    ConditionVariable doneCondVar; // Threads with nothing to do in TaskGroup::wait() sleep here
+    Array<Task*> injected;         // Tasks submitted from outside the pool, protected by mutex
+    Atomic<u32> numInjected = 0;
+    Atomic<u32> numSleeping = 0;
+    bool isShuttingDown = false; // Protected by mutex
+
+    static ThreadLocal<Worker*> currentWorker_;
+
+    /*!
+    Creates a pool with `numThreads` workers. If `numThreads` is 0, one worker is created for each
+    hardware thread. If `pinThreads` is true, each worker is pinned to a hardware thread using
+    `Affinity`, spreading workers across physical cores first.
+    */
+    PLY_DLL_ENTRY ThreadPool(u32 numThreads = 0, bool pinThreads = false);
+    PLY_DLL_ENTRY ~ThreadPool();
+
+    PLY_INLINE u32 numThreads() const {
+        return this->workers.numItems();
+    }
+
+    /*!
+    Runs `callable` on one of the pool's workers. There's no way to wait for the task to complete
+    other than through a `TaskGroup`.
+    */
+    template <typename Callable>
+    PLY_INLINE void run(Callable&& callable) {
+        this->submit(new TaskImpl<Callable>{std::forward<Callable>(callable), nullptr});
+    }
+
+    /*!
+    Splits the range `[0, numItems)` into subranges of at least `grainSize` items and calls `body`
+    on each subrange in parallel, then waits for all of them to complete. The range is split in
+    halves recursively, so that idle workers steal large subranges. If `grainSize` is 0, a grain
+    size is chosen based on the number of workers. The calling thread helps to run subranges.
+    */
+    PLY_DLL_ENTRY void parallelForRanges(u32 numItems, u32 grainSize,
+                                         const LambdaView<void(u32 start, u32 end)>& body);
+
+    /*!
+    Calls `callable` on every item in `items` in parallel, then waits for all calls to complete.
+    */
+    template <typename T, typename Callable>
+    PLY_INLINE void parallelFor(ArrayView<T> items, const Callable& callable, u32 grainSize = 0) {
+        this->parallelForRanges(items.numItems, grainSize, [&](u32 start, u32 end) {
+            for (u32 i = start; i < end; i++) {
+                callable(items[i]);
+            }
+        });
+    }
+
+    // Internal functions
+    PLY_DLL_ENTRY void submit(Task* task);
+    PLY_DLL_ENTRY Task* findTask(Worker* worker);
+    PLY_DLL_ENTRY void execute(Task* task);
+    PLY_DLL_ENTRY bool hasWork() const;
+    PLY_DLL_ENTRY void wakeWorker();
+    PLY_DLL_ENTRY void runWorker(Worker* worker);
+    PLY_INLINE Worker* getCurrentWorker() const {
+        Worker* worker = currentWorker_.load();
+        return (worker && worker->pool == this) ? worker : nullptr;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+/*!
+A `TaskGroup` runs tasks on a `ThreadPool` and waits for them to complete. Tasks can create their
+own `TaskGroup`s and wait on them, so fork/join parallelism can be nested to any depth.
+
+While waiting, the calling thread runs tasks from the pool instead of blocking, so waiting from
+inside a task doesn't tie up a worker. The destructor waits for any tasks that are still pending.
+*/
+struct TaskGroup {
+    ThreadPool* pool = nullptr;
+    Atomic<u32> numPending = 0;
+
+    PLY_INLINE TaskGroup(ThreadPool* pool) : pool{pool} {
+    }
+    PLY_INLINE ~TaskGroup() {
+        this->wait();
+    }
+
+    template <typename Callable>
+    PLY_INLINE void run(Callable&& callable) {
+        this->numPending.fetchAdd(1, Relaxed);
+        this->pool->submit(
+            new ThreadPool::TaskImpl<Callable>{std::forward<Callable>(callable), this});
+    }
+
+    PLY_DLL_ENTRY void wait();
+};
+
+} // namespace ply
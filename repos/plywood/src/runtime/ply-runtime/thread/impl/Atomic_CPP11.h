@@ -27,6 +27,7 @@ enum MemoryOrder {
     Release = std::memory_order_release,
     ConsumeRelease = std::memory_order_acq_rel,
     AcquireRelease = std::memory_order_acq_rel,
+    SeqCst = std::memory_order_seq_cst,
 };
 
 template <typename T>
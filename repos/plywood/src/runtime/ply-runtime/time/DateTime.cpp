@@ -56,8 +56,8 @@ PLY_INLINE T floorDiv(T dividend, T divisor) {
 }
 
 // Based on http://howardhinnant.github.io/date_algorithms.html
-void setDateFromEpochDays(DateTime* dateTime, s32 days) {
-    days += 719468;
+void setDateFromEpochDays(DateTime* dateTime, s32 epochDays) {
+    s32 days = epochDays + 719468;
     s32 era = (days >= 0 ? days : days - 146096) / 146097;
     u32 doe = u32(days - era * 146097);                              // [0, 146096]
     u32 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
@@ -69,7 +69,8 @@ void setDateFromEpochDays(DateTime* dateTime, s32 days) {
     dateTime->year = y + (m <= 2);
     dateTime->month = safeDemote<u8>(m);
     dateTime->day = safeDemote<u8>(d);
-    dateTime->weekday = safeDemote<u8>(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+    dateTime->weekday = safeDemote<u8>(epochDays >= -4 ? (epochDays + 4) % 7
+                                                       : (epochDays + 5) % 7 + 6);
 }
 
 // Based on http://howardhinnant.github.io/date_algorithms.html
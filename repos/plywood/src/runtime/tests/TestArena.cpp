@@ -0,0 +1,83 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/memory/Arena.h>
+#include <ply-runtime/memory/Heap.h>
+#include <ply-runtime/container/Array.h>
+#include <ply-runtime/string/Label.h>
+#include <ply-runtime/string/String.h>
+#include <string.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX Arena_
+
+PLY_TEST_CASE("Arena alloc, realloc and reset") {
+    Arena arena{1024 * 1024};
+    char* a = (char*) arena.alloc(10);
+    char* b = (char*) arena.alloc(100, 64);
+    PLY_TEST_CHECK(arena.contains(a) && arena.contains(b));
+    PLY_TEST_CHECK((uptr(a) & (Arena::DefaultAlignment - 1)) == 0);
+    PLY_TEST_CHECK((uptr(b) & 63) == 0);
+    PLY_TEST_CHECK(Arena::getSize(b) == 100);
+    PLY_TEST_CHECK(Arena::findOwner(b) == &arena);
+    memset(b, 'x', 100);
+    // The last block is resized in place
+    PLY_TEST_CHECK(arena.realloc(b, 200) == b);
+    // Other blocks are moved
+    memset(a, 'y', 10);
+    char* c = (char*) arena.realloc(a, 20);
+    PLY_TEST_CHECK(c != a && memcmp(c, "yyyyyyyyyy", 10) == 0);
+    arena.reset();
+    PLY_TEST_CHECK(arena.numBytesUsed() == 0);
+    PLY_TEST_CHECK(arena.alloc(10) == a);
+}
+
+PLY_TEST_CASE("Arena redirects PLY_HEAP within a Scope") {
+    Arena arena{1024 * 1024};
+    {
+        Arena::Scope scope{&arena};
+        Array<u32> arr;
+        for (u32 i = 0; i < 1000; i++) {
+            arr.append(i);
+        }
+        PLY_TEST_CHECK(arena.contains(arr.get()));
+        void* ptr = PLY_HEAP.alloc(50);
+        PLY_TEST_CHECK(arena.contains(ptr));
+        PLY_HEAP.free(ptr);
+        {
+            // A null Scope restores the regular heap
+            Arena::Scope inner{nullptr};
+            void* heapPtr = PLY_HEAP.alloc(50);
+            PLY_TEST_CHECK(!arena.contains(heapPtr));
+            PLY_HEAP.free(heapPtr);
+        }
+    }
+    PLY_TEST_CHECK(Arena::current() == nullptr);
+    PLY_TEST_CHECK(arena.numBytesUsed() > 4000);
+}
+
+PLY_TEST_CASE("Arena doesn't hold LabelMap tables") {
+    LabelMap labelMap;
+    // Sized up front so that the Array itself isn't moved into the Arena.
+    Array<Label> labels;
+    labels.resize(5000);
+    {
+        Arena arena{16 * 1024 * 1024};
+        Arena::Scope scope{&arena};
+        // Enough labels to make the shards' maps grow while the Scope is active.
+        for (u32 i = 0; i < labels.numItems(); i++) {
+            labels[i] = labelMap.insertOrFind(String::format("arena{}", i));
+        }
+        arena.reset();
+    }
+    for (u32 i = 0; i < labels.numItems(); i++) {
+        PLY_TEST_CHECK(labelMap.find(String::format("arena{}", i)) == labels[i]);
+    }
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,102 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/BTree.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX BTree_
+
+struct BTree_Traits {
+    using Index = u32;
+    using Item = u32;
+    static constexpr u32 NodeCapacity = 4;
+    static Index getIndex(Item item) {
+        return item;
+    }
+    static bool less(Index a, Index b) {
+        return a < b;
+    }
+    static void onItemMoved(Item, void*) {
+    }
+};
+
+static Array<u32> makeSortedItems(u32 numItems) {
+    Array<u32> items;
+    for (u32 i = 0; i < numItems; i++) {
+        items.append(i * 2);
+    }
+    return items;
+}
+
+static Array<u32> toArray(BTree<BTree_Traits>& tree) {
+    Array<u32> result;
+    for (u32 item : tree) {
+        result.append(item);
+    }
+    return result;
+}
+
+PLY_TEST_CASE("BTree bulkLoad") {
+    for (u32 numItems : {0, 1, 4, 5, 17, 1000}) {
+        Array<u32> items = makeSortedItems(numItems);
+        BTree<BTree_Traits> tree;
+        tree.insert(12345);
+        tree.bulkLoad(items);
+        PLY_TEST_CHECK(toArray(tree) == items);
+        // The tree must remain usable after bulk loading
+        tree.insert(7);
+        PLY_TEST_CHECK(tree.findFirstGreaterOrEqualTo(7).getItem() == 7);
+    }
+}
+
+PLY_TEST_CASE("BTree lowerBound and upperBound") {
+    BTree<BTree_Traits> tree;
+    tree.bulkLoad(makeSortedItems(100));
+    tree.insert(50);
+    tree.insert(50);
+    PLY_TEST_CHECK(tree.lowerBound(50).getItem() == 50);
+    PLY_TEST_CHECK(tree.upperBound(50).getItem() == 52);
+    PLY_TEST_CHECK(tree.lowerBound(51).getItem() == 52);
+    PLY_TEST_CHECK(tree.upperBound(51).getItem() == 52);
+    PLY_TEST_CHECK(tree.lowerBound(0).getItem() == 0);
+    PLY_TEST_CHECK(!tree.upperBound(198).isValid());
+    u32 numFifties = 0;
+    for (auto iter = tree.lowerBound(50); iter != tree.upperBound(50); iter.next()) {
+        numFifties++;
+    }
+    PLY_TEST_CHECK(numFifties == 3);
+}
+
+PLY_TEST_CASE("BTree eraseRange") {
+    BTree<BTree_Traits> tree;
+    tree.bulkLoad(makeSortedItems(1000));
+    PLY_TEST_CHECK(tree.eraseRange(100, 1100) == 500);
+    PLY_TEST_CHECK(tree.eraseRange(100, 1100) == 0);
+    Array<u32> remaining = toArray(tree);
+    PLY_TEST_CHECK(remaining.numItems() == 500);
+    PLY_TEST_CHECK(remaining[49] == 98 && remaining[50] == 1100);
+    PLY_TEST_CHECK(tree.eraseRange(0, 2000) == 500);
+    PLY_TEST_CHECK(tree.isEmpty());
+}
+
+PLY_TEST_CASE("BTree splitIntoRanges") {
+    BTree<BTree_Traits> tree;
+    Array<u32> items = makeSortedItems(1000);
+    tree.bulkLoad(items);
+    Array<BTree<BTree_Traits>::SubRange> ranges = tree.splitIntoRanges(8);
+    PLY_TEST_CHECK(ranges.numItems() >= 8);
+    Array<u32> concatenated;
+    for (auto& range : ranges) {
+        for (auto iter = range.first; iter != range.last; iter.next()) {
+            concatenated.append(iter.getItem());
+        }
+    }
+    PLY_TEST_CHECK(concatenated == items);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,88 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/BigPool.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX BigPool_
+
+PLY_TEST_CASE("BigPool grows past its reservation") {
+    BigPool<u32> pool{64 * 1024};
+    for (u32 i = 0; i < 1000000; i++) {
+        pool.append(i);
+    }
+    bool ok = true;
+    for (u32 i = 0; i < pool.numItems(); i++) {
+        ok = ok && (pool[i] == i);
+    }
+    PLY_TEST_CHECK(ok);
+    PLY_TEST_CHECK(pool.numItems() == 1000000);
+}
+
+PLY_TEST_CASE("BigPool trim decommits unused pages") {
+    BigPool<> pool{16 * 1024 * 1024};
+    memset(pool.alloc(4 * 1024 * 1024), 'x', 4 * 1024 * 1024);
+    uptr numCommitted = pool.numBytesCommitted();
+    PLY_TEST_CHECK(numCommitted >= 4 * 1024 * 1024);
+    pool.truncate(100);
+    pool.trim();
+    PLY_TEST_CHECK(pool.numBytesCommitted() < numCommitted);
+    PLY_TEST_CHECK(pool[99] == 'x');
+    pool.clear();
+    PLY_TEST_CHECK(pool.numBytesCommitted() == 0);
+    // Pages can be committed again after being decommitted.
+    pool.append('y');
+    PLY_TEST_CHECK(pool[0] == 'y');
+}
+
+PLY_TEST_CASE("BigPool backed by a file") {
+    FileSystem* fs = FileSystem::native();
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestBigPool.bin");
+    // Left over if a previous run was interrupted.
+    if (fs->exists(path) == ExistsResult::File) {
+        fs->deleteFile(path);
+    }
+    {
+        BigPool<u32> pool{path, 64 * 1024};
+        PLY_TEST_CHECK(!pool.hasFileError());
+        PLY_TEST_CHECK(pool.numItems() == 0);
+        for (u32 i = 0; i < 100000; i++) {
+            pool.append(i * 3);
+        }
+    }
+    {
+        // The items written by the previous pool are available immediately.
+        BigPool<u32> pool{path};
+        PLY_TEST_CHECK(pool.numItems() == 100000);
+        PLY_TEST_CHECK(pool[0] == 0 && pool[99999] == 99999 * 3);
+        pool.truncate(10);
+        pool.trim();
+        pool.append(12345u);
+    }
+    {
+        BigPool<u32> pool{path};
+        PLY_TEST_CHECK(pool.numItems() == 11);
+        PLY_TEST_CHECK(pool[9] == 27 && pool[10] == 12345);
+    }
+    fs->deleteFile(path);
+}
+
+PLY_TEST_CASE("BigPool reports a file that can't be opened") {
+    // A directory can't be opened as a file.
+    BigPool<u32> pool{PLY_BUILD_FOLDER, 64 * 1024};
+    PLY_TEST_CHECK(pool.hasFileError());
+    PLY_TEST_CHECK(pool.numItems() == 0);
+    // The pool still works in memory.
+    for (u32 i = 0; i < 100000; i++) {
+        pool.append(i);
+    }
+    PLY_TEST_CHECK(pool[99999] == 99999);
+}
+
+} // namespace tests
+} // namespace ply
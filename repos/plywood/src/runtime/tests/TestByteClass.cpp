@@ -0,0 +1,80 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/string/ByteClass.h>
+#include <ply-runtime/io/InStream.h>
+#include <ply-runtime/algorithm/Random.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX ByteClass_
+
+PLY_TEST_CASE("ByteClass kernels match a scalar loop") {
+    // Every start offset and length up to a few vectors, so that the unaligned head, the
+    // overlapping tail and the scalar fallback are all covered.
+    Random random{123};
+    char buf[160];
+    for (u32 trial = 0; trial < 20; trial++) {
+        u32 mask[8];
+        for (u32 i = 0; i < 8; i++) {
+            mask[i] = random.next32() & random.next32();
+        }
+        ByteClass cls{mask};
+        char value = (char) random.next8();
+        for (char& c : buf) {
+            // Sparse matches, so that long runs are tested too.
+            c = (random.next8() < 8) ? value : (char) random.next8();
+        }
+        for (u32 start = 0; start < 40; start++) {
+            for (u32 end = start; end <= 160; end++) {
+                const char* expected = buf + start;
+                while (expected < buf + end && *expected != value) {
+                    expected++;
+                }
+                PLY_TEST_CHECK(findByteInRange(buf + start, buf + end, value) == expected);
+
+                const char* expectedIn = buf + start;
+                while (expectedIn < buf + end && !cls.contains(*expectedIn)) {
+                    expectedIn++;
+                }
+                PLY_TEST_CHECK(cls.findFirstIn(buf + start, buf + end) == expectedIn);
+
+                const char* expectedNotIn = buf + start;
+                while (expectedNotIn < buf + end && cls.contains(*expectedNotIn)) {
+                    expectedNotIn++;
+                }
+                PLY_TEST_CHECK(cls.findFirstNotIn(buf + start, buf + end) == expectedNotIn);
+            }
+        }
+    }
+}
+
+PLY_TEST_CASE("ByteClass contains every byte value") {
+    for (u32 c = 0; c < 256; c++) {
+        u32 mask[8] = {};
+        mask[c >> 5] = 1u << (c & 31);
+        ByteClass cls{mask};
+        char buf[64];
+        for (u32 i = 0; i < 64; i++) {
+            buf[i] = (char) (i == 50 ? c : c ^ (i + 1));
+        }
+        PLY_TEST_CHECK(cls.findFirstIn(buf, buf + 64) == buf + 50);
+    }
+}
+
+PLY_TEST_CASE("ByteClass long runs in InStream parsers") {
+    String spaces = String::allocate(100);
+    memset(spaces.bytes, ' ', 100);
+    String text = spaces + "abc_" + String::format("{}", u64(12345678901234567)) + "\xc3\xa9-x\n";
+    ViewInStream vins{text};
+    PLY_TEST_CHECK(vins.readView<fmt::Whitespace>().numBytes == 100);
+    PLY_TEST_CHECK(vins.readView(fmt::Identifier{}) == "abc_12345678901234567\xc3\xa9");
+    PLY_TEST_CHECK(vins.readView<fmt::Line>() == "-x\n");
+    PLY_TEST_CHECK(vins.numBytesAvailable() == 0);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,91 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/ConcurrentSequence.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-runtime/string/String.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX ConcurrentBlockList_
+
+PLY_TEST_CASE("ConcurrentBlockList single-threaded append") {
+    ConcurrentBlockList list;
+    String expected;
+    for (u32 i = 0; i < 1000; i++) {
+        String line = String::format("line {}\n", i);
+        list.append(line);
+        expected += line;
+    }
+    // A record larger than the default block size gets a block of its own.
+    String big = String::allocate(5000);
+    memset(big.bytes, 'x', big.numBytes);
+    list.append(big);
+    expected += big;
+    PLY_TEST_CHECK(list.toString() == expected);
+}
+
+PLY_TEST_CASE("ConcurrentBlockList reader sees only committed data") {
+    ConcurrentBlockList list;
+    ConcurrentBlockList::Reader reader = list.createReader();
+    ConcurrentBlockList::Reservation res = list.beginWrite(4);
+    memcpy(res.bytes, "abcd", 4);
+    PLY_TEST_CHECK(reader.read().isEmpty());
+    ConcurrentBlockList::endWrite(res);
+    PLY_TEST_CHECK(reader.read() == "abcd");
+    PLY_TEST_CHECK(reader.read().isEmpty());
+    list.append("efg");
+    PLY_TEST_CHECK(reader.read() == "efg");
+}
+
+PLY_TEST_CASE("ConcurrentSequence multiple producers") {
+    struct Record {
+        u32 thread;
+        u32 index;
+    };
+    static constexpr u32 NumThreads = 4;
+    static constexpr u32 NumRecords = 20000;
+    ConcurrentSequence<Record> seq;
+    Thread threads[NumThreads];
+    for (u32 t = 0; t < NumThreads; t++) {
+        threads[t].run([&seq, t] {
+            for (u32 i = 0; i < NumRecords; i++) {
+                seq.append(Record{t, i});
+            }
+        });
+    }
+    for (Thread& thread : threads) {
+        thread.join();
+    }
+
+    // Each thread's records must all be present, in the order that thread appended them.
+    u32 nextIndex[NumThreads] = {0};
+    bool ordered = true;
+    auto reader = seq.createReader();
+    while (ArrayView<const Record> records = reader.read()) {
+        for (const Record& rec : records) {
+            ordered = ordered && (rec.index == nextIndex[rec.thread]);
+            nextIndex[rec.thread]++;
+        }
+    }
+    PLY_TEST_CHECK(ordered);
+    for (u32 t = 0; t < NumThreads; t++) {
+        PLY_TEST_CHECK(nextIndex[t] == NumRecords);
+    }
+}
+
+PLY_TEST_CASE("ConcurrentSequence destructs items") {
+    ConcurrentSequence<String> seq;
+    for (u32 i = 0; i < 500; i++) {
+        seq.append(String::format("item{}", i));
+    }
+    Array<String> items = seq.copyToArray();
+    PLY_TEST_CHECK(items.numItems() == 500);
+    PLY_TEST_CHECK(items[499] == "item499");
+}
+
+} // namespace tests
+} // namespace ply
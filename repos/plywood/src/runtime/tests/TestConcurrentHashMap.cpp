@@ -0,0 +1,95 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/ConcurrentHashMap.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX ConcurrentHashMap_
+
+struct ConcurrentHashMap_Traits {
+    using Key = u32;
+    using Value = u32;
+};
+
+PLY_TEST_CASE("ConcurrentHashMap insert and find") {
+    ConcurrentHashMap<ConcurrentHashMap_Traits> map;
+    for (u32 i = 1; i <= 10000; i++) {
+        PLY_TEST_CHECK(map.insertOrFind(i, i * 2 + 2) == i * 2 + 2);
+    }
+    for (u32 i = 1; i <= 10000; i++) {
+        PLY_TEST_CHECK(map.insertOrFind(i, 99) == i * 2 + 2);
+        PLY_TEST_CHECK(map.find(i) == i * 2 + 2);
+    }
+    PLY_TEST_CHECK(map.find(10001) == 0);
+}
+
+PLY_TEST_CASE("ConcurrentHashMap exchange and erase") {
+    ConcurrentHashMap<ConcurrentHashMap_Traits> map;
+    for (u32 i = 1; i <= 1000; i++) {
+        PLY_TEST_CHECK(map.exchange(i, 10) == 0);
+        PLY_TEST_CHECK(map.exchange(i, 20) == 10);
+    }
+    for (u32 i = 1; i <= 1000; i += 2) {
+        PLY_TEST_CHECK(map.erase(i) == 20);
+        PLY_TEST_CHECK(map.erase(i) == 0);
+    }
+    for (u32 i = 1; i <= 1000; i++) {
+        PLY_TEST_CHECK(map.find(i) == ((i & 1) ? 0 : 20));
+    }
+}
+
+PLY_TEST_CASE("ConcurrentHashMap migration restarts when the destination overflows") {
+    using details::ConcurrentHashMap;
+    // Place keys 1..600 in cells 1..600, then migrate using a hash that sends keys 1..300 to
+    // bucket 0 and keys 301..600 to bucket 4097. The migration is started without an overflow, so
+    // the destination is the same size as the source. In every table smaller than 8192 cells,
+    // both buckets collide, and the second group can't be placed within LinearSearchLimit.
+    static const ConcurrentHashMap::Callbacks identity = {[](uptr key) { return u32(key); }};
+    static const ConcurrentHashMap::Callbacks clustered = {
+        [](uptr key) { return key <= 300 ? 0u : 4097u; }};
+    ConcurrentHashMap map{1024};
+    for (uptr key = 1; key <= 600; key++) {
+        PLY_TEST_CHECK(map.insertOrFind(&identity, key, key + 1) == key + 1);
+    }
+    map.participateInMigration(&clustered, map.m_root.load(Relaxed), 0);
+    PLY_TEST_CHECK(map.m_root.load(Relaxed)->sizeMask + 1 == 8192);
+    for (uptr key = 1; key <= 600; key++) {
+        PLY_TEST_CHECK(map.find(&clustered, key) == key + 1);
+    }
+}
+
+PLY_TEST_CASE("ConcurrentHashMap multithreaded insert") {
+    static constexpr u32 NumThreads = 4;
+    static constexpr u32 NumKeys = 20000;
+    ConcurrentHashMap<ConcurrentHashMap_Traits> map;
+    Atomic<u32> numMismatches{0};
+    Thread threads[NumThreads];
+    for (u32 t = 0; t < NumThreads; t++) {
+        threads[t].run([&map, &numMismatches, t] {
+            // Every thread inserts every key, in a different order, with a different value.
+            for (u32 i = 0; i < NumKeys; i++) {
+                u32 key = ((i * 7919 + t * 1234) % NumKeys) + 1;
+                u32 value = map.insertOrFind(key, t + 2);
+                if (value < 2 || value >= NumThreads + 2 || map.find(key) != value) {
+                    numMismatches.fetchAdd(1, Relaxed);
+                }
+            }
+        });
+    }
+    for (u32 t = 0; t < NumThreads; t++) {
+        threads[t].join();
+    }
+    PLY_TEST_CHECK(numMismatches.load(Relaxed) == 0);
+    for (u32 key = 1; key <= NumKeys; key++) {
+        u32 value = map.find(key);
+        PLY_TEST_CHECK(value >= 2 && value < NumThreads + 2);
+    }
+}
+
+} // namespace tests
+} // namespace ply
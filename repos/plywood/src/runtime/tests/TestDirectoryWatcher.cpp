@@ -0,0 +1,73 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/filesystem/DirectoryWatcher.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-runtime/thread/Mutex.h>
+#include <ply-runtime/thread/ConditionVariable.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX DirectoryWatcher_
+
+#if PLY_KERNEL_LINUX
+
+// Collects the paths passed to the watcher's callback.
+struct ChangeRecorder {
+    Mutex mutex;
+    ConditionVariable condVar;
+    Array<Tuple<String, bool>> changes;
+
+    void onChange(StringView path, bool mustRecurse) {
+        LockGuard<Mutex> guard{this->mutex};
+        this->changes.append(NativePath::normalize(path), mustRecurse);
+        this->condVar.wakeAll();
+    }
+
+    // Waits up to 5 seconds for a change to the specified path.
+    bool waitFor(StringView path, bool mustRecurse) {
+        String normalized = NativePath::normalize(path);
+        LockGuard<Mutex> guard{this->mutex};
+        for (u32 i = 0; i < 50; i++) {
+            for (const Tuple<String, bool>& change : this->changes) {
+                if (change.first == normalized && change.second == mustRecurse)
+                    return true;
+            }
+            this->condVar.timedWait(guard, 100);
+        }
+        return false;
+    }
+};
+
+PLY_TEST_CASE("Report changes in new subdirectories") {
+    String root = NativePath::join(PLY_BUILD_FOLDER, "TestDirectoryWatcher");
+    FileSystem* fs = FileSystem::native();
+    if (fs->exists(root) == ExistsResult::Directory) {
+        fs->removeDirTree(root);
+    }
+    fs->makeDirs(NativePath::join(root, "existing"));
+
+    ChangeRecorder recorder;
+    {
+        DirectoryWatcher watcher{root, [&](StringView path, bool mustRecurse) {
+                                     recorder.onChange(path, mustRecurse);
+                                 }};
+        fs->makeDirsAndSaveBinaryIfDifferent(NativePath::join(root, "existing", "a.txt"), "a");
+        PLY_TEST_CHECK(recorder.waitFor(NativePath::join("existing", "a.txt"), false));
+
+        fs->makeDir(NativePath::join(root, "added"));
+        PLY_TEST_CHECK(recorder.waitFor("added", true));
+        fs->makeDirsAndSaveBinaryIfDifferent(NativePath::join(root, "added", "b.txt"), "b");
+        PLY_TEST_CHECK(recorder.waitFor(NativePath::join("added", "b.txt"), false));
+    }
+
+    fs->removeDirTree(root);
+}
+
+#endif // PLY_KERNEL_LINUX
+
+} // namespace tests
+} // namespace ply
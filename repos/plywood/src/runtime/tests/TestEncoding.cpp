@@ -4,6 +4,9 @@
 ------------------------------------*/
 #include <ply-test/TestSuite.h>
 #include <ply-runtime/io/text/TextConverter.h>
+#include <ply-runtime/io/text/TextFormat.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-runtime/algorithm/Random.h>
 
 namespace ply {
 namespace tests {
@@ -27,5 +30,108 @@ PLY_TEST_CASE("Decode truncated UTF-8") {
     PLY_TEST_CHECK(result == StringView{"\xe3\x00\x80\x00", 4});
 }
 
+// Feeds src to the converter in chunks and collects the output using small destination buffers,
+// so that every kind of split is exercised.
+String convertInChunks(TextConverter* conv, StringView src, u32 srcChunk, u32 dstChunk) {
+    MemOutStream mout;
+    char dst[64];
+    PLY_ASSERT(dstChunk <= PLY_STATIC_ARRAY_SIZE(dst));
+    for (;;) {
+        StringView srcBuf = src.left(min(src.numBytes, srcChunk));
+        bool flush = (srcBuf.numBytes == src.numBytes);
+        MutableStringView dstBuf{dst, dstChunk};
+        bool didWork = conv->convert(&dstBuf, &srcBuf, flush);
+        src.offsetHead(u32(srcBuf.bytes - src.bytes));
+        mout.write({dst, u32(dstBuf.bytes - dst)});
+        if (!didWork) {
+            if (flush)
+                break;
+            // The converter is waiting for the rest of a truncated sequence.
+            srcChunk += 4;
+        }
+    }
+    return mout.moveToString();
+}
+
+// Random text that's mostly ASCII, with multibyte sequences and some invalid bytes.
+String makeRandomText(Random& random, u32 numPoints, const TextEncoding* enc) {
+    MemOutStream mout;
+    for (u32 i = 0; i < numPoints; i++) {
+        u32 kind = random.next32() % 16;
+        u32 point = 32 + random.next32() % 95;
+        if (kind == 0) {
+            point = 0x80 + random.next32() % 0x780;
+        } else if (kind == 1) {
+            point = 0x800 + random.next32() % 0xd000;
+        } else if (kind == 2) {
+            point = 0x10000 + random.next32() % 0x100000;
+        } else if (kind == 3) {
+            // Invalid in both UTF-8 and UTF-16
+            const char* junk[] = {"\x80", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xdc"};
+            mout << StringView{junk[random.next32() % 5]};
+            continue;
+        }
+        char buf[4];
+        mout.write({buf, enc->encodePoint({buf, 4}, point)});
+    }
+    return mout.moveToString();
+}
+
+PLY_TEST_CASE("Bulk conversion matches point-by-point conversion") {
+    const TextEncoding* encodings[] = {TextEncoding::get<UTF8>(), TextEncoding::get<UTF16_LE>(),
+                                       TextEncoding::get<UTF16_BE>(),
+                                       TextEncoding::get<Enc_Bytes>()};
+    Random random{123};
+    for (const TextEncoding* srcEnc : encodings) {
+        for (const TextEncoding* dstEnc : encodings) {
+            for (u32 trial = 0; trial < 10; trial++) {
+                String src = makeRandomText(random, 200, srcEnc);
+                u32 srcChunk = 1 + random.next32() % 100;
+                u32 dstChunk = 1 + random.next32() % 64;
+                TextConverter bulk{dstEnc, srcEnc};
+                TextConverter reference{dstEnc, srcEnc};
+                reference.bulkConvert = nullptr;
+                PLY_TEST_CHECK(convertInChunks(&bulk, src, srcChunk, dstChunk) ==
+                               convertInChunks(&reference, src, srcChunk, dstChunk));
+            }
+        }
+    }
+}
+
+PLY_TEST_CASE("findInvalidUTF8 stops at the first ill-formed sequence") {
+    Random random{123};
+    for (u32 trial = 0; trial < 200; trial++) {
+        String text = makeRandomText(random, 50, TextEncoding::get<UTF8>());
+        // Check against a point-by-point scan.
+        u32 expected = 0;
+        while (expected < text.numBytes) {
+            DecodeResult decoded = UTF8::decodePoint(text.subStr(expected));
+            if (decoded.status != DecodeResult::Status::Valid ||
+                UTF8::numBytes(decoded.point) != decoded.numBytes ||
+                (decoded.point >= 0xd800 && decoded.point < 0xe000) || decoded.point > 0x10ffff)
+                break;
+            expected += decoded.numBytes;
+        }
+        PLY_TEST_CHECK(TextKernels::findInvalidUTF8(text) == expected);
+    }
+}
+
+PLY_TEST_CASE("Autodetect UTF-16 with CRLF") {
+    String text = "line \xe2\x82\xac two\r\n";
+    for (u32 i = 0; i < 200; i++) {
+        text += "Plain ASCII text, long enough to fill a few vectors.\r\n";
+    }
+    String utf16 = TextConverter::convert<UTF16_BE, UTF8>(text);
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestEncoding_utf16.txt");
+    PLY_TEST_CHECK(FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(path, utf16) ==
+                   FSResult::OK);
+    Tuple<String, TextFormat> loaded = FileSystem::native()->loadTextAutodetect(path);
+    PLY_TEST_CHECK(loaded.second.encoding == TextFormat::Encoding::UTF16_be);
+    PLY_TEST_CHECK(loaded.second.newLine == TextFormat::NewLine::CRLF);
+    PLY_TEST_CHECK(loaded.first.findByte('\r') < 0);
+    PLY_TEST_CHECK(loaded.first.startsWith("line \xe2\x82\xac two\nPlain ASCII"));
+    FileSystem::native()->deleteFile(path);
+}
+
 } // namespace tests
 } // namespace ply
@@ -0,0 +1,46 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/filesystem/FileStatusCache.h>
+#include <ply-runtime/container/Hash128.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX FileStatusCache_
+
+PLY_TEST_CASE("FileStatusCache invalidation and content hashes") {
+    FileSystem* fs = FileSystem::native();
+    String dir = NativePath::join(PLY_BUILD_FOLDER, "TestFileStatusCache");
+    String path = NativePath::join(dir, "file.txt");
+    fs->makeDirsAndSaveBinaryIfDifferent(path, "hello");
+
+    // A long TTL, so that only explicit invalidation refreshes statuses.
+    FileStatusCache cache{fs, 1000.f};
+    FileStatus status = cache.getFileStatus(path);
+    PLY_TEST_CHECK(status.result == FSResult::OK);
+    PLY_TEST_CHECK(status.fileSize == 5);
+    PLY_TEST_CHECK(status.fileID != 0);
+    Tuple<FSResult, u128> hash = cache.getContentHash(path);
+    PLY_TEST_CHECK(hash.first == FSResult::OK);
+    PLY_TEST_CHECK(hash.second == Hash128::compute("hello"));
+
+    // The cached status is returned until the directory is invalidated.
+    fs->makeDirsAndSaveBinaryIfDifferent(path, "hello, world");
+    PLY_TEST_CHECK(cache.getFileStatus(path).fileSize == 5);
+    cache.invalidate(dir);
+    PLY_TEST_CHECK(cache.getFileStatus(path).fileSize == 12);
+    PLY_TEST_CHECK(cache.getContentHash(path).second == Hash128::compute("hello, world"));
+
+    // Missing files are cached too.
+    String missing = NativePath::join(dir, "missing.txt");
+    PLY_TEST_CHECK(cache.getFileStatus(missing).result == FSResult::NotFound);
+    PLY_TEST_CHECK(cache.getContentHash(missing).first == FSResult::NotFound);
+
+    fs->removeDirTree(dir);
+}
+
+} // namespace tests
+} // namespace ply
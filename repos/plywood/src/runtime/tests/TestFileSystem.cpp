@@ -0,0 +1,176 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-runtime/algorithm/Sort.h>
+#include <ply-runtime/algorithm/Find.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX FileSystem_
+
+// Writes more files than loadManyAsync() keeps in flight at once, including an empty file, and
+// adds a path that doesn't exist.
+static Array<String> writeTestFiles(StringView dir) {
+    FileSystem::native()->makeDirs(dir);
+    Array<String> paths;
+    for (u32 i = 0; i < 150; i++) {
+        String path = NativePath::join(dir, String::format("file{}.txt", i));
+        MemOutStream mout;
+        for (u32 j = 0; j < i * 37; j++) {
+            mout << i << ',';
+        }
+        FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(path, mout.moveToString());
+        paths.append(std::move(path));
+    }
+    paths.append(NativePath::join(dir, "missing.txt"));
+    return paths;
+}
+
+static bool checkLoadedFiles(const Array<String>& paths,
+                             const Array<Tuple<FSResult, String>>& loaded,
+                             const Array<u32>& numCallbacks) {
+    bool ok = true;
+    for (u32 i = 0; i < paths.numItems(); i++) {
+        ok = ok && (numCallbacks[i] == 1);
+        if (i + 1 == paths.numItems()) {
+            ok = ok && (loaded[i].first == FSResult::NotFound) && loaded[i].second.isEmpty();
+        } else {
+            ok = ok && (loaded[i].first == FSResult::OK) &&
+                 (loaded[i].second == FileSystem::native()->loadBinary(paths[i]));
+        }
+    }
+    return ok;
+}
+
+PLY_TEST_CASE("loadManyAsync()") {
+    String dir = NativePath::join(PLY_BUILD_FOLDER, "TestLoadMany");
+    Array<String> paths = writeTestFiles(dir);
+
+    for (u32 useThreads = 0; useThreads < 2; useThreads++) {
+        Array<Tuple<FSResult, String>> loaded;
+        loaded.resize(paths.numItems());
+        Array<u32> numCallbacks;
+        numCallbacks.resize(paths.numItems());
+        memset(numCallbacks.get(), 0, numCallbacks.numItems() * sizeof(u32));
+        auto onComplete = [&](u32 index, FSResult result, String&& contents) {
+            loaded[index] = {result, std::move(contents)};
+            numCallbacks[index]++;
+        };
+        Array<StringView> pathViews;
+        for (const String& path : paths) {
+            pathViews.append(path);
+        }
+        if (useThreads) {
+            FileSystem::loadManyUsingThreads(FileSystem::native(), pathViews, onComplete);
+        } else {
+            FileSystem::native()->loadManyAsync(pathViews, onComplete);
+        }
+        PLY_TEST_CHECK(checkLoadedFiles(paths, loaded, numCallbacks));
+    }
+
+    FileSystem::native()->removeDirTree(dir);
+}
+
+PLY_TEST_CASE("makeDirsAndSaveBinaryIfDifferent()") {
+    String dir = NativePath::join(PLY_BUILD_FOLDER, "TestSaveIfDifferent");
+    String path = NativePath::join(dir, "sub", "file.txt");
+    FileSystem* fs = FileSystem::native();
+    String big = String::allocate(20000);
+    for (u32 i = 0; i < big.numBytes; i++) {
+        big.bytes[i] = char('a' + i % 26);
+    }
+
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, big) == FSResult::OK);
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, big) == FSResult::Unchanged);
+    PLY_TEST_CHECK(fs->lastResult() == FSResult::Unchanged);
+    // Same size, differs near the end
+    String modified = big;
+    modified.bytes[19990] = '!';
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, modified) == FSResult::OK);
+    PLY_TEST_CHECK(fs->loadBinary(path) == modified);
+    // Different sizes
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, "short") == FSResult::OK);
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, "short") == FSResult::Unchanged);
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, {}) == FSResult::OK);
+    PLY_TEST_CHECK(fs->makeDirsAndSaveBinaryIfDifferent(path, {}) == FSResult::Unchanged);
+    PLY_TEST_CHECK(fs->loadBinary(path).isEmpty());
+
+    // No temporary files are left behind
+    u32 numFiles = 0;
+    for (const DirectoryEntry& entry : fs->listDir(NativePath::join(dir, "sub"))) {
+        PLY_UNUSED(entry);
+        numFiles++;
+    }
+    PLY_TEST_CHECK(numFiles == 1);
+
+    fs->removeDirTree(dir);
+}
+
+// Flattens a walk into sorted "path:size" strings so that different walk orders can be compared.
+struct WalkRecorder {
+    Array<String> items;
+
+    void add(const WalkTriple& triple) {
+        for (const WalkTriple::FileInfo& file : triple.files) {
+            this->items.append(String::format("{}:{}", NativePath::join(triple.dirPath, file.name),
+                                              file.fileSize));
+        }
+        for (StringView dirName : triple.dirNames) {
+            this->items.append(NativePath::join(triple.dirPath, dirName));
+        }
+    }
+    Array<String> sorted() {
+        sort(this->items.view());
+        return std::move(this->items);
+    }
+};
+
+PLY_TEST_CASE("walkParallel()") {
+    String top = NativePath::join(PLY_BUILD_FOLDER, "TestWalkParallel");
+    FileSystem* fs = FileSystem::native();
+    for (u32 i = 0; i < 5; i++) {
+        for (u32 j = 0; j < 4; j++) {
+            String dir = NativePath::join(top, String::format("dir{}", i), String::format("sub{}", j));
+            for (u32 k = 0; k <= j; k++) {
+                fs->makeDirsAndSaveBinaryIfDifferent(
+                    NativePath::join(dir, String::format("file{}.txt", k)), String::allocate(i + k));
+            }
+        }
+    }
+
+    WalkRecorder expected;
+    for (const WalkTriple& triple : fs->walk(top, FileSystem::WithSizes)) {
+        expected.add(triple);
+    }
+    WalkRecorder actual;
+    u32 numDirs = 0;
+    fs->walkParallel(top, FileSystem::WithSizes, [&](WalkTriple& triple) {
+        actual.add(triple);
+        numDirs++;
+    });
+    Array<String> expectedItems = expected.sorted();
+    PLY_TEST_CHECK(numDirs == 26);
+    PLY_TEST_CHECK(expectedItems.numItems() == 75);
+    PLY_TEST_CHECK(actual.sorted() == expectedItems);
+
+    // Prune every directory named sub2
+    numDirs = 0;
+    fs->walkParallel(top, 0, [&](WalkTriple& triple) {
+        s32 i = find(triple.dirNames, "sub2");
+        if (i >= 0) {
+            triple.dirNames.erase(i);
+        }
+        PLY_TEST_CHECK(!triple.dirPath.endsWith("sub2"));
+        numDirs++;
+    });
+    PLY_TEST_CHECK(numDirs == 21);
+
+    fs->removeDirTree(top);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,116 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/FlatHashMap.h>
+#include <ply-runtime/container/Array.h>
+#include <ply-runtime/algorithm/Random.h>
+#include <ply-runtime/string/String.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX FlatHashMap_
+
+struct FlatHashMap_IntTraits {
+    using Key = u32;
+    using Item = u32;
+    static PLY_INLINE bool match(Item item, Key key) {
+        return item == key;
+    }
+};
+
+struct FlatHashMap_StringTraits {
+    using Key = StringView;
+    struct Item {
+        String name;
+        u32 value = 0;
+        PLY_INLINE Item(StringView name) : name{name} {
+        }
+    };
+    static PLY_INLINE bool match(const Item& item, Key key) {
+        return item.name == key;
+    }
+};
+
+struct FlatHashMap_IndexTraits {
+    using Key = StringView;
+    using Item = u32;
+    using Context = Array<String>;
+    static PLY_INLINE bool match(Item item, Key key, const Context& ctx) {
+        return ctx[item] == key;
+    }
+};
+
+PLY_TEST_CASE("FlatHashMap insertOrFind and find") {
+    FlatHashMap<FlatHashMap_IntTraits> map;
+    for (u32 i = 0; i < 10000; i++) {
+        auto cursor = map.insertOrFind(i * 3);
+        PLY_TEST_CHECK(!cursor.wasFound());
+        PLY_TEST_CHECK(*cursor == i * 3);
+    }
+    PLY_TEST_CHECK(map.numItems() == 10000);
+    for (u32 i = 0; i < 30000; i++) {
+        PLY_TEST_CHECK(map.find(i).wasFound() == (i % 3 == 0));
+    }
+    PLY_TEST_CHECK(map.insertOrFind(300).wasFound());
+    u32 numIterated = 0;
+    for (u32 item : map) {
+        PLY_TEST_CHECK(item % 3 == 0);
+        numIterated++;
+    }
+    PLY_TEST_CHECK(numIterated == 10000);
+}
+
+PLY_TEST_CASE("FlatHashMap erase matches HashMap") {
+    // Heavy churn exercises Deleted slots and in-place rebuilds.
+    FlatHashMap<FlatHashMap_IntTraits> flat;
+    HashMap<FlatHashMap_IntTraits> reference;
+    Random random{123};
+    for (u32 i = 0; i < 50000; i++) {
+        u32 key = random.next32() % 2000;
+        if (random.next32() % 3 == 0) {
+            auto flatCursor = flat.find(key);
+            auto refCursor = reference.find(key);
+            PLY_TEST_CHECK(flatCursor.wasFound() == refCursor.wasFound());
+            if (flatCursor.wasFound()) {
+                flatCursor.erase();
+                refCursor.erase();
+            }
+        } else {
+            PLY_TEST_CHECK(flat.insertOrFind(key).wasFound() ==
+                           reference.insertOrFind(key).wasFound());
+        }
+    }
+    PLY_TEST_CHECK(flat.numItems() == reference.numItems());
+    for (u32 item : reference) {
+        PLY_TEST_CHECK(flat.find(item).wasFound());
+    }
+}
+
+PLY_TEST_CASE("FlatHashMap with non-trivial items") {
+    FlatHashMap<FlatHashMap_StringTraits> map;
+    for (u32 i = 0; i < 1000; i++) {
+        map.insertOrFind(String::format("item{}", i))->value = i;
+    }
+    FlatHashMap<FlatHashMap_StringTraits> moved = std::move(map);
+    PLY_TEST_CHECK(moved.numItems() == 1000);
+    PLY_TEST_CHECK(moved.find("item123")->value == 123);
+    moved.find("item123").erase();
+    PLY_TEST_CHECK(!moved.find("item123").wasFound());
+    PLY_TEST_CHECK(moved.find("item999")->value == 999);
+}
+
+PLY_TEST_CASE("FlatHashMap with context") {
+    Array<String> names = {"apple", "banana", "cherry"};
+    FlatHashMap<FlatHashMap_IndexTraits> map;
+    for (u32 i = 0; i < names.numItems(); i++) {
+        *map.insertOrFind(names[i], &names) = i;
+    }
+    PLY_TEST_CHECK(*map.find("banana", &names) == 1);
+    PLY_TEST_CHECK(!map.find("durian", &names).wasFound());
+}
+
+} // namespace tests
+} // namespace ply
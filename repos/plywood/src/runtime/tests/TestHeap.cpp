@@ -0,0 +1,91 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/memory/Heap.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-runtime/thread/ManualResetEvent.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX Heap_
+
+// The thread cache is opt-in, so these tests only run when the runtime is built with
+// -DPLY_DLMALLOC_THREAD_CACHE=1.
+#if PLY_USE_DLMALLOC && PLY_DLMALLOC_THREAD_CACHE
+
+static Heap_DL* createHeap() {
+    Heap_DL* heap = new Heap_DL;
+    heap->zeroInit();
+    return heap;
+}
+
+PLY_TEST_CASE("Heap_DL thread caches are flushed when threads exit") {
+    static constexpr u32 NumBlocks = 1000;
+    Heap_DL* heap = createHeap();
+    void* blocks[NumBlocks];
+    Thread producer;
+    producer.run([&] {
+        for (u32 i = 0; i < NumBlocks; i++) {
+            blocks[i] = PLY_HEAP_DIRECT(*heap).alloc(16 + i % 200);
+        }
+    });
+    producer.join();
+
+    // The blocks are freed on another thread, which caches some of them.
+    ManualResetEvent freed;
+    ManualResetEvent canExit;
+    Thread consumer;
+    consumer.run([&] {
+        for (u32 i = 0; i < NumBlocks; i++) {
+            PLY_HEAP_DIRECT(*heap).free(blocks[i]);
+        }
+        freed.signal();
+        canExit.wait();
+    });
+    freed.wait();
+    Heap_DL::Stats stats = PLY_HEAP_DIRECT(*heap).getStats();
+    PLY_TEST_CHECK(stats.threadCachedBytes > 0);
+
+    canExit.signal();
+    consumer.join();
+    stats = PLY_HEAP_DIRECT(*heap).getStats();
+    PLY_TEST_CHECK(stats.threadCachedBytes == 0);
+    PLY_TEST_CHECK(stats.inUseBytes == 0);
+    delete heap;
+}
+
+PLY_TEST_CASE("Heap_DL can be destroyed while threads that used it are running") {
+    Heap_DL* heap1 = createHeap();
+    Heap_DL* heap2 = createHeap();
+    ManualResetEvent ready;
+    ManualResetEvent heap1Destroyed;
+    Thread thread;
+    thread.run([&] {
+        // The thread gets a cache for each heap.
+        PLY_HEAP_DIRECT(*heap1).free(PLY_HEAP_DIRECT(*heap1).alloc(32));
+        PLY_HEAP_DIRECT(*heap2).free(PLY_HEAP_DIRECT(*heap2).alloc(32));
+        ready.signal();
+        heap1Destroyed.wait();
+        PLY_HEAP_DIRECT(*heap2).free(PLY_HEAP_DIRECT(*heap2).alloc(48));
+    });
+    ready.wait();
+    PLY_TEST_CHECK(PLY_HEAP_DIRECT(*heap1).getStats().threadCachedBytes > 0);
+    PLY_TEST_CHECK(PLY_HEAP_DIRECT(*heap2).getStats().threadCachedBytes > 0);
+
+    // When the thread exits, it must only flush its cache for heap2.
+    delete heap1;
+    heap1Destroyed.signal();
+    thread.join();
+    Heap_DL::Stats stats = PLY_HEAP_DIRECT(*heap2).getStats();
+    PLY_TEST_CHECK(stats.threadCachedBytes == 0);
+    PLY_TEST_CHECK(stats.inUseBytes == 0);
+    delete heap2;
+}
+
+#endif // PLY_USE_DLMALLOC && PLY_DLMALLOC_THREAD_CACHE
+
+} // namespace tests
+} // namespace ply
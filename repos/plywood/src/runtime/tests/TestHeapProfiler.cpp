@@ -0,0 +1,80 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/memory/HeapProfiler.h>
+#include <ply-runtime/container/Array.h>
+#include <ply-runtime/string/String.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX HeapProfiler_
+
+static const HeapProfiler::SiteStats* findSite(ArrayView<const HeapProfiler::SiteStats> sites,
+                                               StringView site) {
+    for (const HeapProfiler::SiteStats& stats : sites) {
+        if (StringView{stats.site} == site)
+            return &stats;
+    }
+    return nullptr;
+}
+
+PLY_TEST_CASE("HeapProfiler aggregates per site") {
+    // Fake block addresses are fine, since the profiler never dereferences them.
+    char blocks[4000];
+    for (u32 i = 0; i < 1000; i++) {
+        HeapProfiler::onAlloc("TestHeapProfiler(a)", blocks + i, 10);
+    }
+    for (u32 i = 1000; i < 1010; i++) {
+        HeapProfiler::onAlloc("TestHeapProfiler(b)", blocks + i, 100);
+    }
+    for (u32 i = 0; i < 500; i++) {
+        HeapProfiler::onFree(blocks + i);
+    }
+    {
+        Array<HeapProfiler::SiteStats> sites = HeapProfiler::getSiteStats();
+        const HeapProfiler::SiteStats* a = findSite(sites.view(), "TestHeapProfiler(a)");
+        const HeapProfiler::SiteStats* b = findSite(sites.view(), "TestHeapProfiler(b)");
+        PLY_TEST_CHECK(a && b);
+        PLY_TEST_CHECK(a->numLiveBytes == 5000 && a->peakLiveBytes == 10000);
+        PLY_TEST_CHECK(a->numLiveAllocs == 500 && a->numAllocs == 1000);
+        PLY_TEST_CHECK(b->numLiveBytes == 1000 && b->numLiveAllocs == 10);
+        String pylon = HeapProfiler::toPylon();
+        PLY_TEST_CHECK(pylon.startsWith("{\n") && pylon.endsWith("}\n"));
+    }
+    for (u32 i = 500; i < 1010; i++) {
+        HeapProfiler::onFree(blocks + i);
+    }
+    Array<HeapProfiler::SiteStats> sites = HeapProfiler::getSiteStats();
+    PLY_TEST_CHECK(findSite(sites.view(), "TestHeapProfiler(a)")->numLiveAllocs == 0);
+    PLY_TEST_CHECK(findSite(sites.view(), "TestHeapProfiler(b)")->numLiveBytes == 0);
+}
+
+PLY_TEST_CASE("HeapProfiler merges sites with identical strings") {
+    // Two copies of the same string, as when a header is compiled into several modules.
+    static char site1[] = "TestHeapProfiler(c)";
+    static char site2[] = "TestHeapProfiler(c)";
+    char blocks[30];
+    for (u32 i = 0; i < 20; i++) {
+        HeapProfiler::onAlloc(site1, blocks + i, 10);
+    }
+    for (u32 i = 0; i < 20; i++) {
+        HeapProfiler::onFree(blocks + i);
+    }
+    for (u32 i = 20; i < 30; i++) {
+        HeapProfiler::onAlloc(site2, blocks + i, 10);
+    }
+    Array<HeapProfiler::SiteStats> sites = HeapProfiler::getSiteStats();
+    const HeapProfiler::SiteStats* c = findSite(sites.view(), "TestHeapProfiler(c)");
+    PLY_TEST_CHECK(c && c->numLiveBytes == 100 && c->numAllocs == 30);
+    // The peaks didn't overlap, so the merged peak is the larger one, not their sum.
+    PLY_TEST_CHECK(c->peakLiveBytes == 200);
+    for (u32 i = 20; i < 30; i++) {
+        HeapProfiler::onFree(blocks + i);
+    }
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,79 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/string/Label.h>
+#include <ply-runtime/string/String.h>
+#include <ply-runtime/thread/Thread.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX Label_
+
+PLY_TEST_CASE("Label insertOrFind and view") {
+    LabelMap labelMap;
+    Label a = labelMap.insertOrFind("apple");
+    Label b = labelMap.insertOrFind("banana");
+    PLY_TEST_CHECK(a.isValid() && b.isValid());
+    PLY_TEST_CHECK(!(a == b));
+    PLY_TEST_CHECK(labelMap.insertOrFind("apple") == a);
+    PLY_TEST_CHECK(labelMap.find("banana") == b);
+    PLY_TEST_CHECK(labelMap.view(a) == "apple");
+    PLY_TEST_CHECK(labelMap.view(b) == "banana");
+    PLY_TEST_CHECK(labelMap.view(Label{}).isEmpty());
+}
+
+PLY_TEST_CASE("Label many labels in every shard") {
+    static constexpr u32 NumLabels = 50000;
+    LabelMap labelMap;
+    Array<Label> labels;
+    u32 numPerShard[LabelMap::NumShards] = {};
+    for (u32 i = 0; i < NumLabels; i++) {
+        Label label = labelMap.insertOrFind(String::format("name{}", i));
+        numPerShard[label.idx & (LabelMap::NumShards - 1)]++;
+        labels.append(label);
+    }
+    for (u32 count : numPerShard) {
+        PLY_TEST_CHECK(count > 0);
+    }
+    for (u32 i = 0; i < NumLabels; i++) {
+        String name = String::format("name{}", i);
+        PLY_TEST_CHECK(labelMap.find(name) == labels[i]);
+        PLY_TEST_CHECK(labelMap.view(labels[i]) == name);
+    }
+    PLY_TEST_CHECK(!labelMap.find("name-1").isValid());
+}
+
+PLY_TEST_CASE("Label multithreaded insertOrFind") {
+    static constexpr u32 NumThreads = 4;
+    static constexpr u32 NumLabels = 2000;
+    LabelMap labelMap;
+    Array<Label> results[NumThreads];
+    Thread threads[NumThreads];
+    for (u32 t = 0; t < NumThreads; t++) {
+        threads[t].run([&labelMap, &results, t] {
+            for (u32 i = 0; i < NumLabels; i++) {
+                String name = String::format("label_{}", i);
+                Label label = labelMap.insertOrFind(name);
+                if (labelMap.view(label) != name) {
+                    label = {};
+                }
+                results[t].append(label);
+            }
+        });
+    }
+    for (u32 t = 0; t < NumThreads; t++) {
+        threads[t].join();
+    }
+    for (u32 i = 0; i < NumLabels; i++) {
+        PLY_TEST_CHECK(results[0][i].isValid());
+        for (u32 t = 1; t < NumThreads; t++) {
+            PLY_TEST_CHECK(results[t][i] == results[0][i]);
+        }
+    }
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,69 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-runtime/io/MappedFile.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX MappedFile_
+
+PLY_TEST_CASE("Map a file and read it back") {
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestMappedFile.bin");
+    String contents;
+    for (u32 i = 0; i < 10000; i++) {
+        contents += String::format("{} ", i);
+    }
+    FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(path, contents);
+
+    Reference<MappedFile> file = FileSystem::native()->mapFileForRead(path);
+    PLY_TEST_CHECK(file && FileSystem::native()->lastResult() == FSResult::OK);
+    PLY_TEST_CHECK(file->view() == contents);
+
+    // Parse directly from the mapping.
+    ViewInStream vins = file->createInStream();
+    u32 sum = 0;
+    for (u32 i = 0; i < 10000; i++) {
+        sum += vins.parse<u32>();
+        vins.parse<fmt::Whitespace>();
+    }
+    PLY_TEST_CHECK(sum == 10000 * 9999 / 2);
+    PLY_TEST_CHECK(vins.atEOF());
+
+    // Read through an InPipe in small chunks. The pipe keeps the mapping alive.
+    Owned<InPipe> inPipe = new InPipe_Mapped{std::move(file)};
+    PLY_TEST_CHECK(!file);
+    PLY_TEST_CHECK(inPipe->getFileSize() == contents.numBytes);
+    String copy;
+    char buf[1000];
+    while (u32 numBytes = inPipe->readSome({buf, sizeof(buf)})) {
+        copy += StringView{buf, numBytes};
+    }
+    PLY_TEST_CHECK(copy == contents);
+    inPipe = nullptr;
+
+    FileSystem::native()->deleteFile(path);
+}
+
+PLY_TEST_CASE("Map an empty file") {
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestMappedFile.bin");
+    FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(path, {});
+    Reference<MappedFile> file = FileSystem::native()->mapFileForRead(path);
+    PLY_TEST_CHECK(file && file->numBytes == 0);
+    PLY_TEST_CHECK(file->createInStream().numBytesAvailable() == 0);
+    file = nullptr;
+    FileSystem::native()->deleteFile(path);
+}
+
+PLY_TEST_CASE("Map a file that doesn't exist") {
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestMappedFile_missing.bin");
+    Reference<MappedFile> file = FileSystem::native()->mapFileForRead(path);
+    PLY_TEST_CHECK(!file);
+    PLY_TEST_CHECK(FileSystem::native()->lastResult() == FSResult::NotFound);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,138 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/io/OutStream.h>
+#include <ply-runtime/filesystem/FileSystem.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX OutStream_
+
+// An OutPipe that records everything written to it and counts the calls it receives.
+struct OutPipe_Recorder : OutPipe {
+    static Funcs Funcs_;
+    MemOutStream mout;
+    u32 numWrites = 0;
+    u32 numWriteManys = 0;
+
+    OutPipe_Recorder() : OutPipe{&Funcs_} {
+    }
+};
+
+void OutPipe_Recorder_destroy(OutPipe* outPipe_) {
+    OutPipe_Recorder* outPipe = static_cast<OutPipe_Recorder*>(outPipe_);
+    destruct(outPipe->mout);
+}
+
+bool OutPipe_Recorder_write(OutPipe* outPipe_, StringView buf) {
+    OutPipe_Recorder* outPipe = static_cast<OutPipe_Recorder*>(outPipe_);
+    outPipe->numWrites++;
+    outPipe->mout.write(buf);
+    return true;
+}
+
+bool OutPipe_Recorder_flush(OutPipe*, bool) {
+    return true;
+}
+
+bool OutPipe_Recorder_writeMany(OutPipe* outPipe_, ArrayView<const StringView> bufs) {
+    OutPipe_Recorder* outPipe = static_cast<OutPipe_Recorder*>(outPipe_);
+    outPipe->numWriteManys++;
+    for (StringView buf : bufs) {
+        outPipe->mout.write(buf);
+    }
+    return true;
+}
+
+OutPipe::Funcs OutPipe_Recorder::Funcs_ = {
+    OutPipe_Recorder_destroy,
+    OutPipe_Recorder_write,
+    OutPipe_Recorder_flush,
+    OutPipe::seek_Empty,
+    OutPipe_Recorder_writeMany,
+};
+
+String makeTestData() {
+    MemOutStream mout;
+    for (u32 i = 0; i < 20000; i++) {
+        mout.format("{},", i);
+    }
+    return mout.moveToString();
+}
+
+PLY_TEST_CASE("OutStream gathers blocks into writeMany()") {
+    String data = makeTestData();
+    OutPipe_Recorder recorder;
+    {
+        OutStream outs{borrow(&recorder)};
+        // Write in small pieces so that many blocks fill up.
+        for (u32 i = 0; i < data.numBytes; i += 7) {
+            outs.write(data.subStr(i, min<u32>(7, data.numBytes - i)));
+        }
+        PLY_TEST_CHECK(outs.getSeekPos() == data.numBytes);
+        outs.flushMem();
+        outs.write("end");
+    }
+    // More than 100 KB was written in 4 KB blocks, but only a handful of calls reached the pipe.
+    PLY_TEST_CHECK(recorder.numWriteManys > 0);
+    PLY_TEST_CHECK(recorder.numWriteManys + recorder.numWrites < 10);
+    PLY_TEST_CHECK(recorder.mout.moveToString() == data + "end");
+}
+
+PLY_TEST_CASE("OutStream writev to a file") {
+    String data = makeTestData();
+    String path = NativePath::join(PLY_BUILD_FOLDER, "TestOutStream.txt");
+    {
+        Owned<OutStream> outs = FileSystem::native()->openStreamForWrite(path);
+        PLY_TEST_CHECK(outs);
+        for (u32 i = 0; i < data.numBytes; i += 1000) {
+            outs->write(data.subStr(i, min<u32>(1000, data.numBytes - i)));
+        }
+    }
+    PLY_TEST_CHECK(FileSystem::native()->loadBinary(path) == data);
+    FileSystem::native()->deleteFile(path);
+}
+
+PLY_TEST_CASE("OutStream transferFrom() a file") {
+    String data = makeTestData();
+    String srcPath = NativePath::join(PLY_BUILD_FOLDER, "TestOutStream_src.txt");
+    String dstPath = NativePath::join(PLY_BUILD_FOLDER, "TestOutStream.txt");
+    FileSystem::native()->makeDirsAndSaveBinaryIfDifferent(srcPath, data);
+
+    // File to file, which uses sendfile() on Linux
+    {
+        Owned<InPipe> src = FileSystem::native()->openPipeForRead(srcPath);
+        Owned<OutStream> outs = FileSystem::native()->openStreamForWrite(dstPath);
+        *outs << "header,";
+        PLY_TEST_CHECK(outs->transferFrom(src, 1000));
+        PLY_TEST_CHECK(outs->transferFrom(src, data.numBytes - 1000));
+        PLY_TEST_CHECK(outs->getSeekPos() == data.numBytes + 7);
+        *outs << ",footer";
+    }
+    PLY_TEST_CHECK(FileSystem::native()->loadBinary(dstPath) == "header," + data + ",footer");
+
+    // To a pipe without a transferFrom() implementation
+    {
+        Owned<InPipe> src = FileSystem::native()->openPipeForRead(srcPath);
+        OutPipe_Recorder recorder;
+        PLY_TEST_CHECK(recorder.transferFrom(src, data.numBytes));
+        PLY_TEST_CHECK(recorder.mout.moveToString() == data);
+    }
+
+    // To memory, and past the end of the source
+    {
+        Owned<InPipe> src = FileSystem::native()->openPipeForRead(srcPath);
+        MemOutStream mout;
+        PLY_TEST_CHECK(!mout.transferFrom(src, data.numBytes + 1));
+        PLY_TEST_CHECK(mout.moveToString() == data);
+    }
+
+    FileSystem::native()->deleteFile(srcPath);
+    FileSystem::native()->deleteFile(dstPath);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,92 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/container/Pool.h>
+#include <ply-runtime/string/String.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX Pool_
+
+static Array<u32> iterateValues(const Pool<u32>& pool) {
+    Array<u32> result;
+    for (auto iter = pool.begin(); iter != pool.end(); ++iter) {
+        result.append(*(*iter).get());
+    }
+    return result;
+}
+
+PLY_TEST_CASE("Pool iteration skips free slots") {
+    Pool<u32> pool;
+    Array<PoolIndex<u32, u32>> indices;
+    for (u32 i = 0; i < 200; i++) {
+        indices.append(pool.newItem<u32>(i));
+    }
+    for (u32 i = 0; i < 200; i++) {
+        if (i % 3 != 0) {
+            pool.delItem(indices[i]);
+        }
+    }
+    Array<u32> values = iterateValues(pool);
+    PLY_TEST_CHECK(values.numItems() == 67);
+    PLY_TEST_CHECK(pool.numItems() == 67);
+    bool ok = true;
+    for (u32 i = 0; i < values.numItems(); i++) {
+        ok = ok && (values[i] == i * 3);
+    }
+    PLY_TEST_CHECK(ok);
+}
+
+PLY_TEST_CASE("Pool newItems reuses free slots") {
+    Pool<u32> pool;
+    auto first = pool.newItems<u32>(100, 7u);
+    PLY_TEST_CHECK(first.numItems() == 100);
+    pool.delItem(first[10]);
+    pool.delItem(first[20]);
+    auto second = pool.newItems<u32>(50, 9u);
+    PLY_TEST_CHECK(second.numItems() == 50);
+    PLY_TEST_CHECK(pool.numItems() == 148);
+    PLY_TEST_CHECK(second[49].idx == 147);
+    u32 numNines = 0;
+    for (u32 value : iterateValues(pool)) {
+        numNines += (value == 9);
+    }
+    PLY_TEST_CHECK(numNines == 50);
+}
+
+PLY_TEST_CASE("Pool compact remaps indices") {
+    Pool<String> pool;
+    Array<PoolIndex<String, u16>> indices;
+    for (u32 i = 0; i < 300; i++) {
+        indices.append(pool.newItem<u16>(String::from(i)));
+    }
+    for (u32 i = 0; i < 300; i++) {
+        if (i % 4 != 1) {
+            pool.delItem(indices[i]);
+            indices[i] = {};
+        }
+    }
+    Array<u32> remapTable = pool.compact();
+    PLY_TEST_CHECK(remapTable.numItems() == 300);
+    bool ok = true;
+    for (u32 i = 0; i < 300; i++) {
+        Pool<String>::remapIndex(indices[i], remapTable);
+        if (indices[i].isValid()) {
+            ok = ok && (indices[i].idx < 75);
+            ok = ok && (*pool.get(indices[i]).get() == String::from(i));
+        }
+    }
+    PLY_TEST_CHECK(ok);
+    PLY_TEST_CHECK(pool.numItems() == 75);
+    u32 numIterated = 0;
+    for (auto iter = pool.begin(); iter != pool.end(); ++iter) {
+        numIterated++;
+    }
+    PLY_TEST_CHECK(numIterated == 75);
+}
+
+} // namespace tests
+} // namespace ply
@@ -0,0 +1,120 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <ply-runtime/thread/ThreadPool.h>
+#include <ply-test/TestSuite.h>
+
+namespace ply {
+namespace tests {
+
+#define PLY_TEST_CASE_PREFIX ThreadPool_
+
+PLY_TEST_CASE("ThreadPool deque pops LIFO, steals FIFO and grows") {
+    ThreadPool::Deque deque;
+    Array<ThreadPool::Task> tasks;
+    tasks.resize(1000);
+    for (ThreadPool::Task& task : tasks) {
+        deque.push(&task);
+    }
+    PLY_TEST_CHECK(deque.steal() == &tasks[0]);
+    PLY_TEST_CHECK(deque.steal() == &tasks[1]);
+    PLY_TEST_CHECK(deque.pop() == &tasks[999]);
+    for (u32 i = 998; i >= 2; i--) {
+        PLY_TEST_CHECK(deque.pop() == &tasks[i]);
+    }
+    PLY_TEST_CHECK(deque.isEmpty());
+    PLY_TEST_CHECK(deque.pop() == nullptr);
+    PLY_TEST_CHECK(deque.steal() == nullptr);
+}
+
+PLY_TEST_CASE("ThreadPool parallelFor visits every item once") {
+    ThreadPool pool{4};
+    Array<u32> items;
+    items.resize(100000);
+    for (u32 i = 0; i < items.numItems(); i++) {
+        items[i] = i;
+    }
+    pool.parallelFor(items.view(), [](u32& item) { item = item * 2 + 1; });
+    bool allVisited = true;
+    for (u32 i = 0; i < items.numItems(); i++) {
+        allVisited = allVisited && (items[i] == i * 2 + 1);
+    }
+    PLY_TEST_CHECK(allVisited);
+
+    // Also with an explicit grain size and with ranges smaller than a grain.
+    Atomic<u32> total = 0;
+    pool.parallelForRanges(1000, 7, [&](u32 start, u32 end) {
+        PLY_ASSERT(end - start <= 7);
+        total.fetchAdd(end - start, Relaxed);
+    });
+    PLY_TEST_CHECK(total.load(Relaxed) == 1000);
+    pool.parallelForRanges(3, 100, [&](u32 start, u32 end) { total.fetchAdd(end - start, Relaxed); });
+    PLY_TEST_CHECK(total.load(Relaxed) == 1003);
+}
+
+u64 parallelFib(ThreadPool* pool, u32 n) {
+    if (n < 12) {
+        u64 a = 0;
+        u64 b = 1;
+        for (u32 i = 0; i < n; i++) {
+            u64 c = a + b;
+            a = b;
+            b = c;
+        }
+        return a;
+    }
+    u64 x = 0;
+    TaskGroup group{pool};
+    group.run([&] { x = parallelFib(pool, n - 1); });
+    u64 y = parallelFib(pool, n - 2);
+    group.wait();
+    return x + y;
+}
+
+PLY_TEST_CASE("ThreadPool nested fork/join") {
+    ThreadPool pool{4};
+    PLY_TEST_CHECK(parallelFib(&pool, 27) == 196418);
+
+    // A task that waits on its own group from inside the pool.
+    u64 result = 0;
+    TaskGroup outer{&pool};
+    outer.run([&] { result = parallelFib(&pool, 25); });
+    outer.wait();
+    PLY_TEST_CHECK(result == 75025);
+}
+
+PLY_TEST_CASE("ThreadPool runs tasks submitted from many threads") {
+    static constexpr u32 NumThreads = 4;
+    static constexpr u32 NumTasks = 5000;
+    ThreadPool pool{3, true};
+    Atomic<u32> count = 0;
+    {
+        TaskGroup group{&pool};
+        Thread threads[NumThreads];
+        for (Thread& thread : threads) {
+            thread.run([&] {
+                for (u32 i = 0; i < NumTasks; i++) {
+                    group.run([&] { count.fetchAdd(1, Relaxed); });
+                }
+            });
+        }
+        for (Thread& thread : threads) {
+            thread.join();
+        }
+        // ~TaskGroup waits for the tasks
+    }
+    PLY_TEST_CHECK(count.load(Relaxed) == NumThreads * NumTasks);
+
+    // Detached tasks are finished before the pool is destroyed.
+    {
+        ThreadPool pool2{2};
+        for (u32 i = 0; i < 100; i++) {
+            pool2.run([&] { count.fetchAdd(1, Relaxed); });
+        }
+    }
+    PLY_TEST_CHECK(count.load(Relaxed) == NumThreads * NumTasks + 100);
+}
+
+} // namespace tests
+} // namespace ply
@@ -49,23 +49,55 @@ PLY_NO_INLINE void FetchFromFileSystem::serve(const FetchFromFileSystem* params,
         return;
     }
 
+    Reference<ResponseCache::Entry> cacheEntry;
+    u64 generation = 0;
+    if (params->cache) {
+        cacheEntry = params->cache->find(requestPath);
+        if (cacheEntry) {
+            ResponseCache::respond(cacheEntry, responseIface);
+            return;
+        }
+        // Read the generation before the file, in case the file changes while it's being loaded.
+        generation = params->cache->getGeneration();
+    }
+
+    FileSystem* fs = FileSystem::native();
     String nativePath =
         NativePath::join(params->rootDir, requestPath.ltrim([](char c) { return c == '/'; }));
 
-    // FIXME: Don't load the whole file completely in memory first.
-    // Could open the raw pipe and feed it to outs.
-    String bin = FileSystem::native()->loadBinary(nativePath);
-    if (FileSystem::native()->lastResult() != FSResult::OK) {
-        // file could not be loaded
+    if (params->cache) {
+        // Load small files into the cache. Larger files are streamed.
+        FileStatus status = fs->getFileStatus(nativePath);
+        if (status.result == FSResult::OK && status.fileSize <= params->cache->maxEntryBytes) {
+            String contents = fs->loadBinary(nativePath);
+            if (fs->lastResult() != FSResult::OK) {
+                // file could not be opened
+                responseIface->respondGeneric(ResponseCode::NotFound);
+                return;
+            }
+            cacheEntry = params->cache->add(requestPath, generation, cursor->mimeType,
+                                            "max-age=1200", status.modificationTime,
+                                            std::move(contents));
+            ResponseCache::respond(cacheEntry, responseIface);
+            return;
+        }
+    }
+
+    Owned<InPipe> inPipe = fs->openPipeForRead(nativePath);
+    if (!inPipe) {
+        // file could not be opened
         responseIface->respondGeneric(ResponseCode::NotFound);
         return;
     }
+    u64 fileSize = inPipe->getFileSize();
 
-    OutStream* outs = responseIface->beginResponseHeader(ResponseCode::OK);
+    OutStream* outs = responseIface->beginResponseHeader(ResponseCode::OK, fileSize);
     outs->format("Content-Type: {}\r\n", cursor->mimeType);
     *outs << "Cache-Control: max-age=1200\r\n\r\n";
     responseIface->endResponseHeader();
-    outs->write(bin);
+    // Send the file without loading it into memory. When serving over a socket on Linux, the
+    // kernel copies it directly from the page cache.
+    outs->transferFrom(inPipe, fileSize);
 }
 
 } // namespace web
@@ -5,6 +5,7 @@
 #pragma once
 #include <web-common/Core.h>
 #include <web-common/Response.h>
+#include <web-common/ResponseCache.h>
 
 namespace ply {
 namespace web {
@@ -25,6 +26,8 @@ struct FetchFromFileSystem {
 
     String rootDir;
     HashMap<ContentTypeTraits> extensionToContentType;
+    // Optional. If set, files that fit in the cache are served from memory.
+    ResponseCache* cache = nullptr;
 
     PLY_NO_INLINE FetchFromFileSystem();
     PLY_NO_INLINE static void serve(const FetchFromFileSystem* params, StringView requestPath,
@@ -10,9 +10,8 @@ namespace web {
 
 PLY_NO_INLINE void OutPipe_HTTPChunked_destroy(OutPipe* outPipe_) {
     OutPipe_HTTPChunked* outPipe = static_cast<OutPipe_HTTPChunked*>(outPipe_);
-    // End of chunk stream
+    // End of chunk stream. The owner of outs decides when to flush it.
     *outPipe->outs << "0\r\n\r\n";
-    outPipe->outs->flushMem();
 }
 
 PLY_NO_INLINE bool OutPipe_HTTPChunked_write(OutPipe* outPipe_, StringView srcBuf) {
@@ -28,8 +27,49 @@ PLY_NO_INLINE bool OutPipe_HTTPChunked_write(OutPipe* outPipe_, StringView srcBu
     return !outPipe->outs->atEOF();
 }
 
+PLY_NO_INLINE bool OutPipe_HTTPChunked_writeMany(OutPipe* outPipe_,
+                                                 ArrayView<const StringView> bufs) {
+    OutPipe_HTTPChunked* outPipe = static_cast<OutPipe_HTTPChunked*>(outPipe_);
+    if (outPipe->chunkMode) {
+        // Send all the buffers as a single chunk.
+        u32 numBytes = 0;
+        for (StringView buf : bufs) {
+            numBytes += buf.numBytes;
+        }
+        if (numBytes == 0)
+            return true;
+        outPipe->outs->format("{}\r\n", fmt::Hex{numBytes, true});
+    }
+    for (StringView buf : bufs) {
+        outPipe->outs->write(buf);
+    }
+    if (outPipe->chunkMode) {
+        *outPipe->outs << "\r\n";
+    }
+    return !outPipe->outs->atEOF();
+}
+
+PLY_NO_INLINE bool OutPipe_HTTPChunked_transferFrom(OutPipe* outPipe_, InPipe* src,
+                                                    u64 numBytes) {
+    OutPipe_HTTPChunked* outPipe = static_cast<OutPipe_HTTPChunked*>(outPipe_);
+    if (numBytes == 0)
+        return true;
+    if (outPipe->chunkMode) {
+        // Send the entire transfer as a single chunk.
+        outPipe->outs->format("{}\r\n", fmt::Hex{numBytes, true});
+    }
+    if (!outPipe->outs->transferFrom(src, numBytes))
+        return false;
+    if (outPipe->chunkMode) {
+        *outPipe->outs << "\r\n";
+    }
+    return !outPipe->outs->atEOF();
+}
+
 PLY_NO_INLINE bool OutPipe_HTTPChunked_flush(OutPipe* outPipe_, bool toDevice) {
     OutPipe_HTTPChunked* outPipe = static_cast<OutPipe_HTTPChunked*>(outPipe_);
+    if (!outPipe->forwardFlush)
+        return true;
     return outPipe->outs->flush(toDevice);
 }
 
@@ -38,6 +78,8 @@ OutPipe::Funcs OutPipe_HTTPChunked::Funcs_ = {
     OutPipe_HTTPChunked_write,
     OutPipe_HTTPChunked_flush,
     OutPipe::seek_Empty,
+    OutPipe_HTTPChunked_writeMany,
+    OutPipe_HTTPChunked_transferFrom,
 };
 
 } // namespace web
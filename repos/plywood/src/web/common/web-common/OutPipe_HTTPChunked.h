@@ -15,6 +15,9 @@ struct OutPipe_HTTPChunked : OutPipe {
     static Funcs Funcs_;
     OptionallyOwned<OutStream> outs;
     bool chunkMode = false;
+    // When false, flushing this pipe doesn't flush outs. This lets a response's header, content
+    // and last chunk be sent in a single write.
+    bool forwardFlush = true;
 
     PLY_INLINE OutPipe_HTTPChunked(OptionallyOwned<OutStream>&& outs)
         : OutPipe{&Funcs_}, outs{std::move(outs)} {
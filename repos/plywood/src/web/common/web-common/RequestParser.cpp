@@ -0,0 +1,322 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <web-common/Core.h>
+#include <web-common/RequestParser.h>
+#include <ply-runtime/string/ByteClass.h>
+
+namespace ply {
+namespace web {
+
+PLY_NO_INLINE bool equalsNoCase(StringView a, StringView b) {
+    if (a.numBytes != b.numBytes)
+        return false;
+    for (u32 i = 0; i < a.numBytes; i++) {
+        char x = a.bytes[i];
+        char y = b.bytes[i];
+        if (x >= 'A' && x <= 'Z') {
+            x += 'a' - 'A';
+        }
+        if (y >= 'A' && y <= 'Z') {
+            y += 'a' - 'A';
+        }
+        if (x != y)
+            return false;
+    }
+    return true;
+}
+
+PLY_NO_INLINE StringView Request::findHeader(StringView name) const {
+    for (const HeaderField& field : this->headerFields) {
+        if (equalsNoCase(field.name, name))
+            return field.value;
+    }
+    return {};
+}
+
+PLY_NO_INLINE bool Request::hasHeaderToken(StringView name, StringView token) const {
+    for (const HeaderField& field : this->headerFields) {
+        if (!equalsNoCase(field.name, name))
+            continue;
+        StringView rest = field.value;
+        while (rest.numBytes > 0) {
+            s32 comma = rest.findByte(',');
+            StringView item = (comma >= 0 ? rest.left(comma) : rest);
+            if (equalsNoCase(item.trim(isWhite), token))
+                return true;
+            rest.offsetHead(comma >= 0 ? comma + 1 : rest.numBytes);
+        }
+    }
+    return false;
+}
+
+PLY_INLINE bool isTokenSeparator(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Moves view from a buffer that starts at oldBase to one that starts at newBase.
+PLY_INLINE void relocate(StringView* view, const char* oldBase, const char* newBase) {
+    if (view->bytes) {
+        view->bytes = newBase + ((uptr) view->bytes - (uptr) oldBase);
+    }
+}
+
+//-----------------------------------------------------------------------
+// RequestParser
+//-----------------------------------------------------------------------
+PLY_NO_INLINE void RequestParser::reset(Request* request) {
+    this->state = State::StartLine;
+    this->errorCode = ResponseCode::Unknown;
+    this->base = nullptr;
+    this->pos = 0;
+    this->scanPos = 0;
+    this->numSectionBytes = 0;
+    this->bodyStart = 0;
+    this->bodyEnd = 0;
+    this->remaining = 0;
+    this->isChunked = false;
+    request->startLine = {};
+    request->headerFields.resize(0);
+    request->body = {};
+}
+
+PLY_NO_INLINE RequestParser::Result RequestParser::parse(Request* request, MutableStringView buf) {
+    if (this->base && this->base != buf.bytes) {
+        // The caller moved the buffer. Relocate the views that were already parsed.
+        relocate(&request->startLine.method, this->base, buf.bytes);
+        relocate(&request->startLine.uri, this->base, buf.bytes);
+        relocate(&request->startLine.httpVersion, this->base, buf.bytes);
+        for (Request::HeaderField& field : request->headerFields) {
+            relocate(&field.name, this->base, buf.bytes);
+            relocate(&field.value, this->base, buf.bytes);
+        }
+    }
+    this->base = buf.bytes;
+
+    auto fail = [&](ResponseCode errorCode) {
+        this->state = State::Error;
+        this->errorCode = errorCode;
+        return Result::Error;
+    };
+
+    char* const start = buf.bytes;
+    char* const end = buf.bytes + buf.numBytes;
+    for (;;) {
+        switch (this->state) {
+            case State::Done:
+                return Result::Complete;
+
+            case State::Error:
+                return Result::Error;
+
+            case State::Body:
+            case State::ChunkData: {
+                u32 numBytes = min<u32>(buf.numBytes - this->pos, this->remaining);
+                if (this->isChunked && this->bodyEnd != this->pos) {
+                    // Decode in place by moving the chunk data down, over the chunk framing.
+                    memmove(start + this->bodyEnd, start + this->pos, numBytes);
+                }
+                this->pos += numBytes;
+                this->bodyEnd += numBytes;
+                this->remaining -= numBytes;
+                this->scanPos = this->pos;
+                if (this->remaining > 0)
+                    return Result::NeedMore;
+                if (this->isChunked) {
+                    this->state = State::ChunkDataEnd;
+                    break;
+                }
+                this->state = State::Done;
+                request->body = {start + this->bodyStart, this->bodyEnd - this->bodyStart};
+                return Result::Complete;
+            }
+
+            default: {
+                // Every other state consumes a line. Don't look further than the line is allowed
+                // to extend.
+                if (this->scanPos == buf.numBytes)
+                    return Result::NeedMore;
+                u32 allowed = this->limits.maxHeaderBytes - this->numSectionBytes;
+                char* lineStart = start + this->pos;
+                char* scanEnd = min(end, lineStart + allowed);
+                char* newline = findByteInRange(start + this->scanPos, scanEnd, '\n');
+                if (newline == scanEnd) {
+                    if (scanEnd < end) {
+                        bool isFraming = (this->state == State::ChunkSizeLine ||
+                                          this->state == State::ChunkDataEnd);
+                        return fail(isFraming ? ResponseCode::PayloadTooLarge
+                                              : ResponseCode::HeaderFieldsTooLarge);
+                    }
+                    this->scanPos = safeDemote<u32>(scanEnd - start);
+                    return Result::NeedMore;
+                }
+                this->numSectionBytes += safeDemote<u32>(newline + 1 - lineStart);
+                this->pos = safeDemote<u32>(newline + 1 - start);
+                this->scanPos = this->pos;
+                StringView line = StringView::fromRange(lineStart, newline);
+                if (line.numBytes > 0 && line[line.numBytes - 1] == '\r') {
+                    line.numBytes--;
+                }
+
+                if (this->state == State::StartLine) {
+                    if (line.isEmpty())
+                        break; // Ignore blank lines before the request line
+                    // method SP request-target SP HTTP-version
+                    s32 sp1 = line.findByte(' ');
+                    if (sp1 <= 0)
+                        return fail(ResponseCode::BadRequest);
+                    StringView method = line.left(sp1);
+                    StringView rest = line.subStr(sp1 + 1);
+                    s32 sp2 = rest.findByte(' ');
+                    if (sp2 <= 0)
+                        return fail(ResponseCode::BadRequest);
+                    StringView uri = rest.left(sp2);
+                    StringView httpVersion = rest.subStr(sp2 + 1);
+                    if (method.findByte(isTokenSeparator) >= 0 ||
+                        uri.findByte(isTokenSeparator) >= 0 ||
+                        httpVersion.findByte(isTokenSeparator) >= 0 ||
+                        !httpVersion.startsWith("HTTP/1."))
+                        return fail(ResponseCode::BadRequest);
+                    request->startLine = {method, uri, httpVersion};
+                    this->state = State::HeaderLine;
+                    break;
+                }
+
+                if (this->state == State::HeaderLine) {
+                    if (line.isEmpty()) {
+                        // End of header. Determine the length of the body.
+                        // https://tools.ietf.org/html/rfc7230#section-3.3.3
+                        StringView transferEncoding;
+                        bool hasContentLength = false;
+                        u64 contentLength = 0;
+                        for (const Request::HeaderField& field : request->headerFields) {
+                            if (equalsNoCase(field.name, "Transfer-Encoding")) {
+                                if (!transferEncoding.isEmpty())
+                                    return fail(ResponseCode::NotImplemented);
+                                transferEncoding = field.value;
+                            } else if (equalsNoCase(field.name, "Content-Length")) {
+                                if (field.value.isEmpty())
+                                    return fail(ResponseCode::BadRequest);
+                                u64 value = 0;
+                                for (u32 i = 0; i < field.value.numBytes; i++) {
+                                    char c = field.value[i];
+                                    if (!isDecimalDigit(c))
+                                        return fail(ResponseCode::BadRequest);
+                                    value = min<u64>(value * 10 + (c - '0'), u64(1) << 40);
+                                }
+                                if (hasContentLength && value != contentLength)
+                                    return fail(ResponseCode::BadRequest);
+                                hasContentLength = true;
+                                contentLength = value;
+                            }
+                        }
+                        this->numSectionBytes = 0;
+                        this->bodyStart = this->pos;
+                        this->bodyEnd = this->pos;
+                        if (!transferEncoding.isEmpty()) {
+                            if (hasContentLength)
+                                return fail(ResponseCode::BadRequest);
+                            if (!equalsNoCase(transferEncoding, "chunked"))
+                                return fail(ResponseCode::NotImplemented);
+                            this->isChunked = true;
+                            this->state = State::ChunkSizeLine;
+                        } else {
+                            if (contentLength > this->limits.maxBodyBytes)
+                                return fail(ResponseCode::PayloadTooLarge);
+                            this->remaining = (u32) contentLength;
+                            this->state = State::Body;
+                        }
+                        break;
+                    }
+
+                    if (isTokenSeparator(line[0])) {
+                        // Obsolete line folding. Replace the line break with spaces so that the
+                        // previous field's value extends over this line.
+                        // https://tools.ietf.org/html/rfc7230#section-3.2.4
+                        if (request->headerFields.isEmpty())
+                            return fail(ResponseCode::BadRequest);
+                        StringView continuation = line.trim(isWhite);
+                        if (continuation.isEmpty())
+                            break;
+                        for (char* c = lineStart - 2; c < lineStart; c++) {
+                            if (*c == '\r' || *c == '\n') {
+                                *c = ' ';
+                            }
+                        }
+                        StringView& value = request->headerFields.back().value;
+                        if (value.isEmpty()) {
+                            value = continuation;
+                        } else {
+                            value = StringView::fromRange(value.bytes, continuation.end());
+                        }
+                        break;
+                    }
+
+                    s32 colonPos = line.findByte(':');
+                    if (colonPos <= 0)
+                        return fail(ResponseCode::BadRequest);
+                    StringView name = line.left(colonPos);
+                    if (name.findByte(isTokenSeparator) >= 0)
+                        return fail(ResponseCode::BadRequest);
+                    if (request->headerFields.numItems() >= this->limits.maxHeaderFields)
+                        return fail(ResponseCode::HeaderFieldsTooLarge);
+                    request->headerFields.append({name, line.subStr(colonPos + 1).trim(isWhite)});
+                    break;
+                }
+
+                if (this->state == State::ChunkSizeLine) {
+                    // chunk-size [ chunk-ext ] CRLF
+                    s32 extPos = line.findByte(';');
+                    StringView hex = (extPos >= 0 ? line.left(extPos) : line).trim(isWhite);
+                    if (hex.isEmpty())
+                        return fail(ResponseCode::BadRequest);
+                    u64 chunkSize = 0;
+                    for (u32 i = 0; i < hex.numBytes; i++) {
+                        char c = hex[i];
+                        u32 digit;
+                        if (c >= '0' && c <= '9') {
+                            digit = c - '0';
+                        } else if (c >= 'a' && c <= 'f') {
+                            digit = c - 'a' + 10;
+                        } else if (c >= 'A' && c <= 'F') {
+                            digit = c - 'A' + 10;
+                        } else {
+                            return fail(ResponseCode::BadRequest);
+                        }
+                        chunkSize = min<u64>(chunkSize * 16 + digit, u64(1) << 40);
+                    }
+                    if (chunkSize == 0) {
+                        this->state = State::TrailerLine;
+                    } else {
+                        u32 bodySize = this->bodyEnd - this->bodyStart;
+                        if (chunkSize > this->limits.maxBodyBytes - bodySize)
+                            return fail(ResponseCode::PayloadTooLarge);
+                        this->remaining = (u32) chunkSize;
+                        this->state = State::ChunkData;
+                    }
+                    break;
+                }
+
+                if (this->state == State::ChunkDataEnd) {
+                    if (!line.isEmpty())
+                        return fail(ResponseCode::BadRequest);
+                    this->state = State::ChunkSizeLine;
+                    break;
+                }
+
+                PLY_ASSERT(this->state == State::TrailerLine);
+                // Trailer fields are skipped.
+                if (line.isEmpty()) {
+                    this->state = State::Done;
+                    request->body = {start + this->bodyStart, this->bodyEnd - this->bodyStart};
+                    return Result::Complete;
+                }
+                break;
+            }
+        }
+    }
+}
+
+} // namespace web
+} // namespace ply
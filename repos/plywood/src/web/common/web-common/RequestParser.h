@@ -0,0 +1,89 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <web-common/Core.h>
+#include <web-common/Response.h>
+
+namespace ply {
+namespace web {
+
+struct RequestLimits {
+    // Maximum size of the request line and header fields, including line endings. The same limit
+    // applies separately to the chunk framing and trailers of a chunked body.
+    u32 maxHeaderBytes = 16384;
+    u32 maxHeaderFields = 100;
+    u32 maxBodyBytes = 1048576;
+};
+
+//-----------------------------------------------------------------------
+// RequestParser
+//
+// Incrementally parses an HTTP/1.x request as its bytes are received. Each call to parse() picks
+// up where the previous call left off, so every byte is scanned only once.
+//
+// The parser doesn't allocate memory or copy anything. The StringViews stored in Request point
+// directly into the buffer passed to parse(). Folded header lines are unfolded, and chunked
+// bodies are decoded, by modifying that buffer in place.
+//-----------------------------------------------------------------------
+struct RequestParser {
+    enum class Result {
+        NeedMore,
+        Complete,
+        Error,
+    };
+
+    enum class State : u8 {
+        StartLine,
+        HeaderLine,
+        Body,
+        ChunkSizeLine,
+        ChunkData,
+        ChunkDataEnd,
+        TrailerLine,
+        Done,
+        Error,
+    };
+
+    RequestLimits limits;
+    State state = State::StartLine;
+    ResponseCode errorCode = ResponseCode::Unknown;
+    // Address of the buffer passed to the last call to parse(). If the caller moves the buffer,
+    // the views in Request are relocated on the next call.
+    const char* base = nullptr;
+    u32 pos = 0;     // Offset of the first line (or body byte) that hasn't been parsed yet
+    u32 scanPos = 0; // Offset where the search for the end of the current line resumes
+    // Number of bytes in the header so far. Once the header is complete, counts the bytes of
+    // chunk framing and trailers instead.
+    u32 numSectionBytes = 0;
+    u32 bodyStart = 0;
+    u32 bodyEnd = 0;   // Chunked bodies are moved down to here as they're decoded
+    u32 remaining = 0; // Number of bytes left in the body or current chunk
+    bool isChunked = false;
+
+    PLY_INLINE RequestParser(const RequestLimits& limits = {}) : limits{limits} {
+    }
+
+    // Prepares to parse the next request. request's header field array keeps its memory.
+    PLY_NO_INLINE void reset(Request* request);
+
+    // buf must contain every byte received since the start of the request, and may contain bytes
+    // of pipelined requests after it. Returns Complete once the entire request, including its
+    // body, has been parsed; numBytesConsumed() then gives its size. Returns Error if the request
+    // is ill-formed or exceeds limits; errorCode then holds a suitable response code.
+    PLY_NO_INLINE Result parse(Request* request, MutableStringView buf);
+
+    PLY_INLINE u32 numBytesConsumed() const {
+        PLY_ASSERT(this->state == State::Done);
+        return this->pos;
+    }
+
+    // Largest buffer size that parse() can need to complete a request under these limits.
+    PLY_INLINE u32 maxBufferSize() const {
+        return this->limits.maxHeaderBytes * 2 + this->limits.maxBodyBytes;
+    }
+};
+
+} // namespace web
+} // namespace ply
@@ -11,9 +11,13 @@ namespace web {
 enum class ResponseCode {
     Unknown = 0,
     OK,
+    NotModified,
     BadRequest,
     NotFound,
+    PayloadTooLarge,
+    HeaderFieldsTooLarge,
     InternalError,
+    NotImplemented,
 };
 
 struct Request {
@@ -32,17 +36,33 @@ struct Request {
     u16 clientPort = 0;
     StartLine startLine;
     Array<HeaderField> headerFields;
+    // Empty if the request has no body. A chunked body has already been decoded.
+    StringView body;
+
+    // Returns the value of the first header field with the given name, ignoring case, or an empty
+    // view if there isn't one.
+    PLY_NO_INLINE StringView findHeader(StringView name) const;
+    // Returns true if any header field with the given name has token in its comma-separated list of
+    // values, ignoring case. For example, hasHeaderToken("Connection", "close").
+    PLY_NO_INLINE bool hasHeaderToken(StringView name, StringView token) const;
 };
 
 // This interface exists so that the same response code can be used both from FastCGI or from a
 // webserver directly.
 struct ResponseIface {
+    static constexpr u64 UnknownLength = u64(-1);
+
     Request request;
 
-    // The request handler must call respondWith first, then manually write any optional headers,
-    // followed by a blank \r\n line, followed by the content.
-    virtual OutStream* beginResponseHeader(ResponseCode responseCode) = 0;
+    // The request handler must call beginResponseHeader first, then manually write any optional
+    // headers, followed by a blank \r\n line, then call endResponseHeader, followed by the
+    // content. If the length of the content is known in advance, pass it as contentLength; the
+    // handler must then write exactly that many bytes.
+    virtual OutStream* beginResponseHeader(ResponseCode responseCode,
+                                           u64 contentLength = UnknownLength) = 0;
     virtual void endResponseHeader() = 0;
+    // Sends a complete response in one step.
+    void respondWith(ResponseCode responseCode, StringView contentType, StringView content);
     void respondGeneric(ResponseCode responseCode);
 };
 
@@ -0,0 +1,148 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#include <web-common/Core.h>
+#include <web-common/ResponseCache.h>
+#include <ply-runtime/container/Hash128.h>
+
+namespace ply {
+namespace web {
+
+// Formats a POSIX time as an IMF-fixdate, such as "Sun, 06 Nov 1994 08:49:37 GMT".
+// https://tools.ietf.org/html/rfc7231#section-7.1.1.1
+PLY_NO_INLINE String formatHTTPDate(double posixTime) {
+    static const char DayNames[] = "SunMonTueWedThuFriSat";
+    static const char MonthNames[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    DateTime dateTime = DateTime::fromEpochMicroseconds(s64(posixTime) * 1000000);
+    auto writeDigits = [](char* dst, u32 value, u32 numDigits) {
+        for (u32 i = numDigits; i > 0; i--) {
+            dst[i - 1] = char('0' + value % 10);
+            value /= 10;
+        }
+    };
+    String result = String::allocate(29);
+    char* dst = result.bytes;
+    memcpy(dst, DayNames + dateTime.weekday * 3, 3);
+    memcpy(dst + 3, ", ", 2);
+    writeDigits(dst + 5, dateTime.day, 2);
+    dst[7] = ' ';
+    memcpy(dst + 8, MonthNames + (dateTime.month - 1) * 3, 3);
+    dst[11] = ' ';
+    writeDigits(dst + 12, (u32) dateTime.year, 4);
+    dst[16] = ' ';
+    writeDigits(dst + 17, dateTime.hour, 2);
+    dst[19] = ':';
+    writeDigits(dst + 20, dateTime.minute, 2);
+    dst[22] = ':';
+    writeDigits(dst + 23, dateTime.second, 2);
+    memcpy(dst + 25, " GMT", 4);
+    return result;
+}
+
+// Returns true if the value of an If-None-Match header field matches etag, using the weak
+// comparison function. https://tools.ietf.org/html/rfc7232#section-3.2
+PLY_NO_INLINE bool ifNoneMatchMatches(StringView ifNoneMatch, StringView etag) {
+    StringView rest = ifNoneMatch;
+    while (rest.numBytes > 0) {
+        s32 comma = rest.findByte(',');
+        StringView item = (comma >= 0 ? rest.left(comma) : rest).trim(isWhite);
+        rest.offsetHead(comma >= 0 ? comma + 1 : rest.numBytes);
+        if (item == "*")
+            return true;
+        if (item.startsWith("W/")) {
+            item.offsetHead(2);
+        }
+        if (item == etag)
+            return true;
+    }
+    return false;
+}
+
+PLY_NO_INLINE void ResponseCache::watch(StringView root) {
+    Owned<DirectoryWatcher> watcher =
+        new DirectoryWatcher{root, [this](StringView, bool) { this->invalidateAll(); }};
+    LockGuard<Mutex> guard{this->mutex};
+    this->watchers.append(std::move(watcher));
+    // Entries under the root may already be stale.
+    this->invalidateAll();
+}
+
+PLY_NO_INLINE Reference<ResponseCache::Entry> ResponseCache::find(StringView path) {
+    LockGuard<Mutex> guard{this->mutex};
+    auto cursor = this->entries.find(path);
+    if (!cursor.wasFound() || cursor->entry->generation != this->getGeneration())
+        return {};
+    return cursor->entry;
+}
+
+PLY_NO_INLINE Reference<ResponseCache::Entry>
+ResponseCache::add(StringView path, u64 generation, StringView contentType,
+                   StringView cacheControl, double modificationTime, String&& content) {
+    Reference<Entry> entry = new Entry;
+    entry->generation = generation;
+    entry->contentType = contentType;
+    u128 contentHash = Hash128::compute(content);
+    entry->etag = String::format("\"{}-{}\"", fmt::Hex{contentHash.hi}, fmt::Hex{contentHash.lo});
+    if (modificationTime > 0) {
+        entry->lastModified = formatHTTPDate(modificationTime);
+    }
+    MemOutStream mout;
+    mout.format("ETag: {}\r\n", entry->etag);
+    if (entry->lastModified) {
+        mout.format("Last-Modified: {}\r\n", entry->lastModified);
+    }
+    if (cacheControl) {
+        mout.format("Cache-Control: {}\r\n", cacheControl);
+    }
+    entry->validatorFields = mout.moveToString();
+    entry->content = std::move(content);
+
+    u32 numBytes = entry->content.numBytes;
+    if (numBytes > this->maxEntryBytes || generation != this->getGeneration())
+        return entry;
+    LockGuard<Mutex> guard{this->mutex};
+    if (this->totalBytes + numBytes > this->maxTotalBytes) {
+        this->entries = HashMap<Traits>{};
+        this->totalBytes = 0;
+    }
+    auto cursor = this->entries.insertOrFind(path);
+    if (cursor->entry) {
+        this->totalBytes -= cursor->entry->content.numBytes;
+    }
+    cursor->entry = entry;
+    this->totalBytes += numBytes;
+    return entry;
+}
+
+PLY_NO_INLINE void ResponseCache::respond(const Entry* entry, ResponseIface* responseIface) {
+    // If-None-Match takes precedence over If-Modified-Since. Like most servers, only accept an
+    // If-Modified-Since date that's identical to the one that was sent, instead of parsing it.
+    // https://tools.ietf.org/html/rfc7232#section-6
+    const Request& request = responseIface->request;
+    bool notModified = false;
+    if (request.startLine.method == "GET" || request.startLine.method == "HEAD") {
+        StringView ifNoneMatch = request.findHeader("If-None-Match");
+        if (ifNoneMatch) {
+            notModified = ifNoneMatchMatches(ifNoneMatch, entry->etag);
+        } else if (entry->lastModified) {
+            notModified = (request.findHeader("If-Modified-Since") == entry->lastModified);
+        }
+    }
+
+    if (notModified) {
+        OutStream* outs = responseIface->beginResponseHeader(ResponseCode::NotModified, 0);
+        *outs << entry->validatorFields << "\r\n";
+        responseIface->endResponseHeader();
+    } else {
+        OutStream* outs =
+            responseIface->beginResponseHeader(ResponseCode::OK, entry->content.numBytes);
+        outs->format("Content-Type: {}\r\n", entry->contentType);
+        *outs << entry->validatorFields << "\r\n";
+        responseIface->endResponseHeader();
+        outs->write(entry->content);
+    }
+}
+
+} // namespace web
+} // namespace ply
@@ -0,0 +1,96 @@
+/*------------------------------------
+  ///\  Plywood C++ Framework
+  \\\/  https://plywood.arc80.com/
+------------------------------------*/
+#pragma once
+#include <web-common/Core.h>
+#include <web-common/Response.h>
+#include <ply-runtime/filesystem/DirectoryWatcher.h>
+
+namespace ply {
+namespace web {
+
+//-----------------------------------------------------------------------
+// ResponseCache
+//
+// Remembers complete 200 responses in memory, keyed by request path, so that request handlers
+// don't have to load files or regenerate pages every time. Each entry gets an ETag computed from
+// its content and, when known, a Last-Modified date. Conditional requests that match them are
+// answered with 304 Not Modified.
+//
+// Entries are validated by a generation number. Handlers read the generation before loading the
+// files a response is built from, and store it in the entry. Any change under a directory passed
+// to watch() increments the generation, which makes every older entry stale.
+//
+// All member functions are thread-safe.
+//-----------------------------------------------------------------------
+struct ResponseCache {
+    struct Entry : RefCounted<Entry> {
+        u64 generation = 0;
+        String contentType;
+        // ETag, Last-Modified and Cache-Control header fields, each ending with \r\n. These are
+        // sent with both 200 and 304 responses.
+        String validatorFields;
+        String etag;
+        String lastModified;
+        String content;
+
+        PLY_INLINE void onRefCountZero() {
+            delete this;
+        }
+    };
+
+    struct Traits {
+        using Key = StringView;
+        struct Item {
+            String path;
+            Reference<Entry> entry;
+            PLY_INLINE Item(StringView path) : path{path} {
+            }
+        };
+        static PLY_INLINE bool match(const Item& item, Key key) {
+            return item.path == key;
+        }
+    };
+
+    // Responses larger than this aren't cached. When the total size of cached content would
+    // exceed maxTotalBytes, the cache is emptied.
+    u32 maxEntryBytes = 1048576;
+    u64 maxTotalBytes = 64 * 1048576;
+    Atomic<u64> generation = 1;
+
+    // These members are protected by mutex:
+    Mutex mutex;
+    HashMap<Traits> entries;
+    u64 totalBytes = 0;
+
+    // Declared last so that the watcher thread stops before any other member is destroyed.
+    Array<Owned<DirectoryWatcher>> watchers;
+
+    // Invalidates every entry whenever a file under root changes.
+    PLY_NO_INLINE void watch(StringView root);
+
+    PLY_INLINE u64 getGeneration() const {
+        return this->generation.load(Acquire);
+    }
+    PLY_INLINE void invalidateAll() {
+        this->generation.fetchAdd(1, AcquireRelease);
+    }
+
+    // Returns null if there's no entry for path, or if it's stale.
+    PLY_NO_INLINE Reference<Entry> find(StringView path);
+
+    // Creates an entry from a response that was built from files read after calling
+    // getGeneration(). The entry is stored unless it's too large or already stale, and is returned
+    // either way so that it can be passed to respond(). Pass 0 for modificationTime if unknown.
+    PLY_NO_INLINE Reference<Entry> add(StringView path, u64 generation, StringView contentType,
+                                       StringView cacheControl, double modificationTime,
+                                       String&& content);
+
+    // Sends entry as a 304 response if the request's conditional header fields match it, or as a
+    // 200 response otherwise.
+    static PLY_NO_INLINE void respond(const Entry* entry, ResponseIface* responseIface);
+};
+
+} // namespace web
+} // namespace ply
@@ -7,24 +7,85 @@
 #include <ply-runtime/io/InStream.h>
 #include <ply-runtime/io/OutStream.h>
 #include <web-common/OutPipe_HTTPChunked.h>
+#if PLY_KERNEL_LINUX
+#include <ply-runtime/thread/Affinity.h>
+#include <ply-runtime/thread/ThreadPool.h>
+#include <ply-runtime/io/impl/Pipe_FD.h>
+#include <ply-runtime/time/CPUTimer.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
 
 namespace ply {
 namespace web {
 
 //-----------------------------------------------------------------------
-struct ThreadParams {
+static constexpr u32 MinReceiveBytes = 2048;
+
+struct Connection {
     Owned<TCPConnection> tcpConn;
-    RequestHandler reqHandler;
+    // Bytes received but not yet consumed. Holds the current request along with any requests
+    // pipelined after it.
+    Array<char> recvBuf;
+    u32 numBytesReceived = 0;
+    // The parser and request are reused for every request on this connection, so that serving a
+    // request doesn't allocate any memory.
+    RequestParser parser;
+    Request request;
+
+    PLY_INLINE Connection(Owned<TCPConnection>&& tcpConn, const RequestLimits& limits)
+        : tcpConn{std::move(tcpConn)}, parser{limits} {
+    }
+
+    PLY_INLINE MutableStringView receiveSpace() {
+        if (this->recvBuf.numItems() - this->numBytesReceived < MinReceiveBytes) {
+            u32 newSize = max(this->recvBuf.numItems() * 2, MinReceiveBytes);
+            this->recvBuf.resize(min(newSize, this->parser.maxBufferSize()));
+        }
+        return {this->recvBuf.begin() + this->numBytesReceived,
+                this->recvBuf.numItems() - this->numBytesReceived};
+    }
+
+    // Continues parsing the current request using any bytes received since the last call.
+    PLY_INLINE RequestParser::Result parse() {
+        return this->parser.parse(&this->request,
+                                  {this->recvBuf.begin(), this->numBytesReceived});
+    }
+
+    // Discards the current request and starts parsing the next pipelined one, if any.
+    PLY_NO_INLINE RequestParser::Result consumeRequest() {
+        u32 numBytesConsumed = this->parser.numBytesConsumed();
+        this->recvBuf.erase(0, numBytesConsumed);
+        this->numBytesReceived -= numBytesConsumed;
+        if (this->numBytesReceived == 0) {
+            // Don't hold onto a receive buffer while the connection is idle.
+            this->recvBuf.clear();
+        }
+        this->parser.reset(&this->request);
+        return this->parse();
+    }
 };
 
 PLY_NO_INLINE Tuple<StringView, StringView> getResponseDescription(ResponseCode responseCode) {
     switch (responseCode) {
         case ResponseCode::OK:
             return {"200", "OK"};
+        case ResponseCode::NotModified:
+            return {"304", "Not Modified"};
         case ResponseCode::BadRequest:
             return {"400", "Bad Request"};
         case ResponseCode::NotFound:
             return {"404", "Not Found"};
+        case ResponseCode::PayloadTooLarge:
+            return {"413", "Payload Too Large"};
+        case ResponseCode::HeaderFieldsTooLarge:
+            return {"431", "Request Header Fields Too Large"};
+        case ResponseCode::NotImplemented:
+            return {"501", "Not Implemented"};
         case ResponseCode::InternalError:
         default:
             return {"500", "Internal Server Error"};
@@ -36,52 +97,97 @@ struct ResponseIface_WebServer : ResponseIface {
 
     OutStream* outs = nullptr;
     State state = NoResponse;
-    bool isChunked = false; // implies keep-alive
+    bool isHTTP11 = false;
+    bool keepAlive = false;
+    bool isChunked = false;
     Owned<OutStream> outsChunked;
+    OutPipe_HTTPChunked* chunkedPipe = nullptr; // Owned by outsChunked
+    u64 contentLength = UnknownLength;
+    u64 contentStart = 0; // Seek position of the first byte of content
 
     PLY_INLINE ResponseIface_WebServer(OutStream* outs) : outs{outs} {
     }
-    virtual OutStream* beginResponseHeader(ResponseCode responseCode) override {
+    virtual OutStream* beginResponseHeader(ResponseCode responseCode,
+                                           u64 contentLength) override {
         // FIXME: Handle ResponseCode::InternalError the same way we would handle a crash
         this->state = BeganResponse;
         Tuple<StringView, StringView> responseDesc = getResponseDescription(responseCode);
         this->outs->format("HTTP/1.1 {} {}\r\n", responseDesc.first, responseDesc.second);
-        if (isChunked) {
-            *this->outs << "Transfer-Encoding: chunked\r\n"
-                           "Connection: keep-alive\r\n";
-            outsChunked =
-                Owned<OutStream>::create(Owned<OutPipe_HTTPChunked>::create(borrow(this->outs)));
-            return outsChunked;
+        if (responseCode == ResponseCode::NotModified) {
+            // A 304 response never has content, and doesn't say how long the content would be.
+            // https://tools.ietf.org/html/rfc7232#section-4.1
+            contentLength = 0;
+        } else if (contentLength != UnknownLength) {
+            this->outs->format("Content-Length: {}\r\n", contentLength);
+        } else if (this->keepAlive && this->isHTTP11) {
+            *this->outs << "Transfer-Encoding: chunked\r\n";
+            this->isChunked = true;
+        } else {
+            // The end of the content is marked by closing the connection.
+            this->keepAlive = false;
+        }
+        this->contentLength = contentLength;
+        if (!this->keepAlive) {
+            *this->outs << "Connection: close\r\n";
+        } else if (!this->isHTTP11) {
+            *this->outs << "Connection: keep-alive\r\n";
+        }
+        if (this->isChunked) {
+            Owned<OutPipe_HTTPChunked> chunkedPipe =
+                Owned<OutPipe_HTTPChunked>::create(borrow(this->outs));
+            // The header is sent along with the first chunk.
+            chunkedPipe->forwardFlush = false;
+            this->chunkedPipe = chunkedPipe;
+            this->outsChunked = Owned<OutStream>::create(std::move(chunkedPipe));
+            return this->outsChunked;
         } else {
             return this->outs;
         }
     }
     virtual void endResponseHeader() override {
-        if (isChunked) {
-            outsChunked->flushMem();
-            outsChunked->outPipe->cast<OutPipe_HTTPChunked>()->setChunkMode(true);
+        if (this->isChunked) {
+            this->outsChunked->flushMem();
+            this->chunkedPipe->setChunkMode(true);
+            this->chunkedPipe->forwardFlush = true;
+        } else if (this->contentLength != UnknownLength) {
+            this->contentStart = this->outs->getSeekPos();
         }
         this->state = EndedHeader;
     }
-    // Returns true if response was well-formed and it's possible to send another response over the
-    // same connection:
-    PLY_NO_INLINE bool handleMissingResponse() {
+    // Completes the response. Returns true if it was well-formed and it's possible to send another
+    // response over the same connection:
+    PLY_NO_INLINE bool finishResponse() {
         if (this->state == NoResponse) {
-            this->respondGeneric(ResponseCode::InternalError);
-            return true; // respondGeneric makes it a well-formed response
-        } else {
-            // FIXME: Log somewhere if this->state != EndedHeader
-            return this->state == EndedHeader;
+            this->respondGeneric(ResponseCode::InternalError); // Always well-formed
+        } else if (this->state != EndedHeader) {
+            // FIXME: Log somewhere
+            return false;
+        }
+        if (this->isChunked) {
+            // Write the last chunk without flushing, so that it's sent along with any responses to
+            // pipelined requests.
+            this->chunkedPipe->forwardFlush = false;
+            this->outsChunked.clear();
+        } else if (this->contentLength != UnknownLength &&
+                   this->outs->getSeekPos() - this->contentStart != this->contentLength) {
+            // FIXME: Log somewhere. The client can't tell where the next response begins.
+            return false;
         }
+        return this->keepAlive;
     }
 };
 
+void ResponseIface::respondWith(ResponseCode responseCode, StringView contentType,
+                                StringView content) {
+    OutStream* outs = this->beginResponseHeader(responseCode, content.numBytes);
+    outs->format("Content-Type: {}\r\n\r\n", contentType);
+    this->endResponseHeader();
+    outs->write(content);
+}
+
 void ResponseIface::respondGeneric(ResponseCode responseCode) {
-    OutStream* outs = this->beginResponseHeader(responseCode);
     Tuple<StringView, StringView> responseDesc = getResponseDescription(responseCode);
-    *outs << "Content-Type: text/html\r\n\r\n";
-    this->endResponseHeader();
-    outs->format(R"(<html>
+    String content = String::format(R"(<html>
 <head><title>{} {}</title></head>
 <body>
 <center><h1>{} {}</h1></center>
@@ -89,82 +195,418 @@ void ResponseIface::respondGeneric(ResponseCode responseCode) {
 </body>
 </html>
 )",
-                 responseDesc.first, responseDesc.second, responseDesc.first, responseDesc.second);
+                                    responseDesc.first, responseDesc.second, responseDesc.first,
+                                    responseDesc.second);
+    this->respondWith(responseCode, "text/html", content);
 }
 
-void serverThreadEntry(const ThreadParams& params) {
-    InStream ins = params.tcpConn->createInStream();
-    OutStream outs = params.tcpConn->createOutStream();
+// Handles the request that was parsed at the start of conn->recvBuf, writing the response to outs
+// without flushing it. Returns true if the connection can be kept alive for another request.
+PLY_NO_INLINE bool handleRequest(Connection* conn, const RequestHandler& reqHandler,
+                                 OutStream* outs) {
+    bool keepAlive = false;
+    {
+        // Create responseIface. It borrows the connection's request for the duration of the call.
+        ResponseIface_WebServer responseIface{outs};
+        Request& request = responseIface.request;
+        request = std::move(conn->request);
+        request.clientAddr = conn->tcpConn->remoteAddress();
+        request.clientPort = conn->tcpConn->remotePort();
 
-    for (;;) {
-        // Create responseIface
-        ResponseIface_WebServer responseIface{&outs};
-        responseIface.request.clientAddr = params.tcpConn->remoteAddress();
-        responseIface.request.clientPort = params.tcpConn->remotePort();
-
-        // Parse HTTP headers: Read input lines up until a blank one
-        // FIXME: Limit the size of the header to something like 16KB, otherwise someone could take
-        // down the server.
-        Array<String> lines;
+        if (conn->parser.state == RequestParser::State::Error) {
+            // Ill-formed request, or it exceeded the limits. Respond, then close the connection.
+            responseIface.respondGeneric(conn->parser.errorCode);
+        } else {
+            // HTTP/1.1 connections are persistent by default, and HTTP/1.0 connections aren't.
+            // https://tools.ietf.org/html/rfc7230#section-6.3
+            responseIface.isHTTP11 = (request.startLine.httpVersion == "HTTP/1.1");
+            responseIface.keepAlive = responseIface.isHTTP11
+                                          ? !request.hasHeaderToken("Connection", "close")
+                                          : request.hasHeaderToken("Connection", "keep-alive");
+
+            // Invoke request handler
+            reqHandler(request.startLine.uri, &responseIface);
+            keepAlive = responseIface.finishResponse();
+        }
+        conn->request = std::move(responseIface.request);
+    }
+    return keepAlive && !outs->atEOF();
+}
+
+#if PLY_KERNEL_LINUX
+
+//-----------------------------------------------------------------------
+// On Linux, a single thread waits on all connections using epoll, and complete requests are
+// handed off to a ThreadPool. Idle keep-alive connections only cost a file
+// descriptor and a small heap block.
+//
+// Each connection is registered with EPOLLONESHOT, so that at any given moment, it's owned either
+// by epoll, by the reactor thread or by a single worker thread. Sockets are non-blocking. Workers
+// still write each response from start to finish, waiting for the socket to become writable
+// whenever its send buffer is full, but each response has a deadline. A client that reads too
+// slowly, or stops reading, can't hold a worker for longer than that; its connection is dropped
+// instead.
+//-----------------------------------------------------------------------
+static constexpr u32 SendTimeoutMilliseconds = 30000;
+// How long the listener stays paused when the process runs out of file descriptors.
+static constexpr int ListenerPauseMilliseconds = 100;
+
+// Writes to a non-blocking socket until the deadline passes. The socket is owned by the
+// connection.
+struct OutPipe_SendDeadline : OutPipe {
+    static Funcs Funcs_;
+    int fd = -1;
+    CPUTimer::Point deadline;
+
+    PLY_INLINE OutPipe_SendDeadline(int fd) : OutPipe{&Funcs_}, fd{fd} {
+    }
+    PLY_INLINE void startResponse() {
+        static CPUTimer::Duration timeout =
+            CPUTimer::Converter{}.toDuration(SendTimeoutMilliseconds / 1000.f);
+        this->deadline = CPUTimer::get() + timeout;
+    }
+    // Called when the socket's send buffer is full. Returns false if the deadline passed before
+    // the socket became writable.
+    PLY_NO_INLINE bool waitUntilWritable() {
+        for (;;) {
+            s64 remaining = this->deadline - CPUTimer::get();
+            if (remaining <= 0)
+                return false;
+            struct pollfd pfd;
+            pfd.fd = this->fd;
+            pfd.events = POLLOUT;
+            // Round up, so that the deadline has passed if poll() times out.
+            int timeoutMs = (int) (CPUTimer::Converter{}.toSeconds({remaining}) * 1000.f) + 1;
+            int rc = ::poll(&pfd, 1, timeoutMs);
+            if (rc > 0)
+                return true; // Writable, or an error that the next write will report
+            if (rc < 0 && errno != EINTR)
+                return false;
+        }
+    }
+};
+
+PLY_NO_INLINE void OutPipe_SendDeadline_destroy(OutPipe*) {
+}
+
+PLY_NO_INLINE bool OutPipe_SendDeadline_writeMany(OutPipe* outPipe_,
+                                                  ArrayView<const StringView> bufs) {
+    OutPipe_SendDeadline* outPipe = static_cast<OutPipe_SendDeadline*>(outPipe_);
+    static constexpr u32 MaxIOVecs = 64;
+    struct iovec iov[MaxIOVecs];
+    u32 bufIndex = 0;
+    u32 offsetInBuf = 0;
+    while (bufIndex < bufs.numItems) {
+        // Fill the iovec array starting from the first unwritten byte.
+        u32 numIOVecs = 0;
+        for (u32 i = bufIndex; i < bufs.numItems && numIOVecs < MaxIOVecs; i++) {
+            u32 skip = (i == bufIndex) ? offsetInBuf : 0;
+            iov[numIOVecs].iov_base = (void*) (bufs[i].bytes + skip);
+            iov[numIOVecs].iov_len = bufs[i].numBytes - skip;
+            numIOVecs++;
+        }
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = numIOVecs;
+        ssize_t sent = ::sendmsg(outPipe->fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && outPipe->waitUntilWritable())
+                continue;
+            return false;
+        }
+
+        // Advance past the bytes that were written, which may end partway through a buffer.
+        uptr remaining = (uptr) sent;
+        while (bufIndex < bufs.numItems) {
+            u32 left = bufs[bufIndex].numBytes - offsetInBuf;
+            if (remaining < left) {
+                offsetInBuf += (u32) remaining;
+                break;
+            }
+            remaining -= left;
+            bufIndex++;
+            offsetInBuf = 0;
+        }
+        if (sent == 0 && bufIndex < bufs.numItems)
+            return false;
+    }
+    return true;
+}
+
+PLY_NO_INLINE bool OutPipe_SendDeadline_write(OutPipe* outPipe_, StringView buf) {
+    return OutPipe_SendDeadline_writeMany(outPipe_, {&buf, 1});
+}
+
+PLY_NO_INLINE bool OutPipe_SendDeadline_transferFrom(OutPipe* outPipe_, InPipe* src,
+                                                     u64 numBytes) {
+    OutPipe_SendDeadline* outPipe = static_cast<OutPipe_SendDeadline*>(outPipe_);
+    if (src->funcs == &InPipe_FD::Funcs_) {
+        // Same as OutPipe_FD, except that a full send buffer is waited on.
+        int srcFD = src->cast<InPipe_FD>()->fd;
+        bool anySent = false;
+        while (numBytes > 0) {
+            size_t count = (size_t) min<u64>(numBytes, 0x7ffff000);
+            ssize_t sent = ::sendfile(outPipe->fd, srcFD, nullptr, count);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && outPipe->waitUntilWritable())
+                    continue;
+                if (!anySent && (errno == EINVAL || errno == ENOSYS))
+                    break; // This pair of file descriptors isn't supported; copy instead
+                return false;
+            }
+            if (sent == 0)
+                return false; // Source reached EOF early
+            anySent = true;
+            numBytes -= sent;
+        }
+        if (numBytes == 0)
+            return true;
+    }
+    return OutPipe::transferFrom_Fallback(outPipe_, src, numBytes);
+}
+
+PLY_NO_INLINE bool OutPipe_SendDeadline_flush(OutPipe*, bool) {
+    return true;
+}
+
+OutPipe::Funcs OutPipe_SendDeadline::Funcs_ = {
+    OutPipe_SendDeadline_destroy,
+    OutPipe_SendDeadline_write,
+    OutPipe_SendDeadline_flush,
+    OutPipe::seek_Empty,
+    OutPipe_SendDeadline_writeMany,
+    OutPipe_SendDeadline_transferFrom,
+};
+
+struct Reactor {
+    int epollFD = -1;
+    TCPListener listener;
+    // Held in reserve so that, when the process runs out of file descriptors, it can be closed to
+    // accept and immediately close a pending connection. Otherwise, the level-triggered listener
+    // would wake the reactor again and again without making progress.
+    int reserveFD = -1;
+    bool listenerPaused = false;
+    RequestHandler reqHandler;
+    RequestLimits limits;
+    ThreadPool workers;
+
+    PLY_INLINE Reactor(u32 numWorkers) : workers{numWorkers} {
+    }
+    PLY_INLINE ~Reactor() {
+        if (this->epollFD >= 0) {
+            ::close(this->epollFD);
+        }
+        if (this->reserveFD >= 0) {
+            ::close(this->reserveFD);
+        }
+    }
+
+    PLY_INLINE void openReserveFD() {
+        if (this->reserveFD < 0) {
+            this->reserveFD = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+    }
+
+    // The listener is registered without EPOLLONESHOT, and its event data is null. While it's
+    // paused, it stays registered without any events.
+    PLY_NO_INLINE bool watchListener(bool isNew, bool paused) {
+        struct epoll_event event;
+        event.events = paused ? 0 : EPOLLIN;
+        event.data.ptr = nullptr;
+        int rc = epoll_ctl(this->epollFD, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                           this->listener.listenSocket, &event);
+        if (rc != 0)
+            return false;
+        this->listenerPaused = paused;
+        return true;
+    }
+
+    PLY_NO_INLINE void watch(Connection* conn, bool isNew) {
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = conn;
+        int rc = epoll_ctl(this->epollFD, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                           conn->tcpConn->getHandle(), &event);
+        if (rc != 0) {
+            // Closing the socket also removes it from the epoll set
+            delete conn;
+        }
+    }
+
+    PLY_NO_INLINE void acceptAll() {
         for (;;) {
-            String line = ins.readString<fmt::Line>();
-            if (!line && ins.atEOF()) {
-                if (!lines.isEmpty()) {
-                    // Ill-formed request
-                    responseIface.respondGeneric(ResponseCode::BadRequest);
+            Owned<TCPConnection> tcpConn = this->listener.accept();
+            if (!tcpConn) {
+                if (Socket::lastResult() == IPResult::NoSocket) {
+                    this->rejectPending();
                 }
-                return;
+                // FIXME: Return if port stopped listening
+                break;
+            }
+            if (!tcpConn->setNonBlocking(true))
+                continue;
+            this->watch(new Connection{std::move(tcpConn), this->limits}, true);
+        }
+    }
+
+    // Called when accept() fails because the process is out of file descriptors. Frees the reserved
+    // descriptor, accepts the pending connection and closes it, so that the client gets an
+    // immediate disconnect instead of waiting. If the descriptor can't be reserved again, the
+    // listener is paused for a moment instead.
+    PLY_NO_INLINE void rejectPending() {
+        bool rejected = false;
+        if (this->reserveFD >= 0) {
+            ::close(this->reserveFD);
+            this->reserveFD = -1;
+            // Close the connection before reserving the descriptor again.
+            rejected = (this->listener.accept() != nullptr);
+            this->openReserveFD();
+        }
+        if (!rejected || this->reserveFD < 0) {
+            this->watchListener(false, true);
+        }
+    }
+
+    // Called on the reactor thread when a connection's socket becomes readable.
+    PLY_NO_INLINE void onReadable(Connection* conn) {
+        // Parse as bytes arrive, until there's a complete (or ill-formed) request.
+        while (conn->parse() == RequestParser::Result::NeedMore) {
+            MutableStringView space = conn->receiveSpace();
+            PLY_ASSERT(space.numBytes > 0); // The limits guarantee a result before the buffer fills
+            s32 numBytesRead = conn->tcpConn->readNonBlocking(space);
+            if (numBytesRead > 0) {
+                conn->numBytesReceived += numBytesRead;
+                continue;
+            }
+            if (numBytesRead < 0 && Socket::lastResult() == IPResult::WouldBlock) {
+                this->watch(conn, false);
+            } else {
+                // Peer closed the connection, or an error occurred
+                delete conn;
             }
-            if (line.findByte([](char u) { return !isWhite(u); }) < 0)
-                break; // Blank line
-            lines.append(line);
-        }
-        if (lines.numItems() == 0)
-            return; // Ill-formed request
-
-        // Split the start line into tokens:
-        // FIXME: Add ability to split by any whitespace instead of just splitByte
-        Array<StringView> tokens = lines[0].rtrim(isWhite).splitByte(' ');
-        if (tokens.numItems() != 3) {
-            // Ill-formed request
-            responseIface.respondGeneric(ResponseCode::BadRequest);
             return;
         }
-        responseIface.request.startLine = {tokens[0], tokens[1], tokens[2]};
+        this->workers.run([this, conn] { this->serve(conn); });
+    }
+
+    // Called on a worker thread once a complete request has been received.
+    PLY_NO_INLINE void serve(Connection* conn) {
+        // Handle every complete request that was received, including pipelined ones, in order
+        // before giving the connection back to epoll. Their responses are sent together.
+        bool keepAlive = true;
+        {
+            OutPipe_SendDeadline outPipe{conn->tcpConn->getHandle()};
+            OutStream outs{borrow(&outPipe)};
+            do {
+                outPipe.startResponse();
+                keepAlive = handleRequest(conn, this->reqHandler, &outs);
+            } while (keepAlive && conn->consumeRequest() != RequestParser::Result::NeedMore);
+            outs.flushMem();
+            keepAlive = keepAlive && !outs.atEOF();
+        }
+        if (keepAlive) {
+            this->watch(conn, false);
+        } else {
+            delete conn;
+        }
+    }
 
-        // Split remaining lines into name/value pairs:
-        for (u32 i = 1; i < lines.numItems(); i++) {
-            // FIXME: Support unfolding https://tools.ietf.org/html/rfc822#section-3.1
-            if (isWhite(lines[i][0]))
+    PLY_NO_INLINE void run() {
+        static constexpr u32 MaxEvents = 64;
+        struct epoll_event events[MaxEvents];
+        for (;;) {
+            int numEvents = epoll_wait(this->epollFD, events, MaxEvents,
+                                       this->listenerPaused ? ListenerPauseMilliseconds : -1);
+            if (this->listenerPaused) {
+                // Try to get the reserved file descriptor back before resuming.
+                this->openReserveFD();
+                this->watchListener(false, false);
+            }
+            if (numEvents < 0) {
+                PLY_ASSERT(errno == EINTR);
                 continue;
-            s32 colonPos = lines[i].findByte(':');
-            if (colonPos < 0) {
-                // Ill-formed request
-                responseIface.respondGeneric(ResponseCode::BadRequest);
-                return;
             }
-            responseIface.request.headerFields.append(
-                {lines[i].left(colonPos).rtrim(isWhite),
-                 lines[i].subStr(colonPos + 1).trim(isWhite)});
+            for (int i = 0; i < numEvents; i++) {
+                Connection* conn = (Connection*) events[i].data.ptr;
+                if (conn) {
+                    this->onReadable(conn);
+                } else {
+                    this->acceptAll();
+                }
+            }
         }
+    }
+};
 
-        // FIXME: Decide isChunked/keep-alive based on HTTP request headers
-        responseIface.isChunked = (responseIface.request.startLine.httpVersion == "HTTP/1.1");
+bool runServer(u16 port, const RequestHandler& reqHandler, const RequestLimits& limits) {
+    // Workers block while writing responses, so use at least two of them.
+    Reactor reactor{max<u32>(Affinity{}.getNumHWThreads(), 2)};
+    reactor.reqHandler = reqHandler;
+    reactor.limits = limits;
+    reactor.listener = Socket::bindTCP(port);
+    if (!reactor.listener.isValid()) {
+        StdErr::text().format("Error: Can't bind to port {}\n", port);
+        return false;
+    }
+    reactor.epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor.epollFD < 0 || !reactor.listener.setNonBlocking(true)) {
+        StdErr::text() << "Error: Can't initialize epoll\n";
+        return false;
+    }
+    if (!reactor.watchListener(true, false)) {
+        StdErr::text() << "Error: Can't watch the listening socket using epoll\n";
+        return false;
+    }
+    reactor.openReserveFD();
+    reactor.run();
+    return true;
+}
 
-        // Note: ins is still open, so in the future, we could continue reading past the HTTP
-        // header to support POST requests and WebSockets.
+#else // PLY_KERNEL_LINUX
 
-        // Invoke request handler
-        params.reqHandler(tokens[1], &responseIface);
+//-----------------------------------------------------------------------
+// On other platforms, each connection is served by its own thread.
+//-----------------------------------------------------------------------
+void serverThreadEntry(Connection* conn, const RequestHandler& reqHandler) {
+    InPipe* inPipe = &conn->tcpConn->inPipe;
+    {
+        OutStream outs = conn->tcpConn->createOutStream();
+        RequestParser::Result result = conn->parse();
+        for (;;) {
+            if (result == RequestParser::Result::NeedMore) {
+                // Send the responses to any pipelined requests before waiting for more.
+                outs.flushMem();
+                if (outs.atEOF())
+                    break;
+            }
+            // Read until the buffer holds a complete (or ill-formed) request
+            bool closed = false;
+            while (result == RequestParser::Result::NeedMore) {
+                MutableStringView space = conn->receiveSpace();
+                PLY_ASSERT(space.numBytes > 0);
+                u32 numBytesRead = inPipe->readSome(space);
+                if (numBytesRead == 0) {
+                    closed = true; // Closed by peer
+                    break;
+                }
+                conn->numBytesReceived += numBytesRead;
+                result = conn->parse();
+            }
 
-        if (!responseIface.handleMissingResponse())
-            return; // Close connection if unable to distinguish between responses
-        if (!responseIface.isChunked)
-            return; // Close connection if not keep-alive
+            if (closed || !handleRequest(conn, reqHandler, &outs))
+                break;
+            result = conn->consumeRequest();
+        }
+        // outs is flushed by its destructor, before the connection is closed
     }
+    delete conn;
 }
 
-bool runServer(u16 port, const RequestHandler& reqHandler) {
+bool runServer(u16 port, const RequestHandler& reqHandler, const RequestLimits& limits) {
     TCPListener listener = Socket::bindTCP(port);
     if (!listener.isValid()) {
         StdErr::text().format("Error: Can't bind to port {}\n", port);
@@ -172,16 +614,19 @@ bool runServer(u16 port, const RequestHandler& reqHandler) {
     }
 
     for (;;) {
-        ThreadParams params;
-        params.tcpConn = listener.accept();
+        Owned<TCPConnection> tcpConn = listener.accept();
         // FIXME: Return if port stopped listening
+        if (!tcpConn)
+            continue;
 
-        params.reqHandler = reqHandler;
-        // FIXME: Use a thread pool instead of spawning a thread for every request
-        Thread{[params{std::move(params)}] { serverThreadEntry(params); }};
+        Connection* conn = new Connection{std::move(tcpConn), limits};
+        // FIXME: Use a thread pool instead of spawning a thread for every connection
+        Thread{[conn, reqHandler] { serverThreadEntry(conn, reqHandler); }};
     }
     return true;
 }
 
+#endif // PLY_KERNEL_LINUX
+
 } // namespace web
 } // namespace ply
@@ -5,11 +5,12 @@
 #pragma once
 #include <web-common/Core.h>
 #include <web-common/Response.h>
+#include <web-common/RequestParser.h>
 
 namespace ply {
 namespace web {
 
-bool runServer(u16 port, const RequestHandler& reqHandler);
+bool runServer(u16 port, const RequestHandler& reqHandler, const RequestLimits& limits = {});
 
 } // namespace web
 } // namespace ply
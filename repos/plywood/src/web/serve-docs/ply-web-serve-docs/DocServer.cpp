@@ -61,10 +61,18 @@ void DocServer::init(StringView dataRoot) {
 
     this->dataRoot = dataRoot;
     this->contentsPath = NativePath::join(dataRoot, "contents.pylon");
-    FileStatus contentsStatus = fs->getFileStatus(this->contentsPath);
-    if (contentsStatus.result == FSResult::OK) {
+    // Watch for changes to contents.pylon instead of checking its modification time on every
+    // request. An empty path means the watcher lost track of changes. Compare the whole filename
+    // so that other files ending in contents.pylon, and the temporary files that
+    // makeDirsAndSaveBinaryIfDifferent() writes before renaming them over contents.pylon, are
+    // ignored.
+    this->watcher = new DirectoryWatcher{dataRoot, [this](StringView path, bool) {
+        if (path.isEmpty() || NativePath::split(path).second == "contents.pylon") {
+            this->contentsChanged.store(1, MemoryOrder::Release);
+        }
+    }};
+    if (fs->exists(this->contentsPath) == ExistsResult::File) {
         this->reloadContents();
-        this->contentsModTime = contentsStatus.modificationTime;
     }
 }
 
@@ -101,7 +109,10 @@ void DocServer::reloadContents() {
     }
 }
 
-String getPageSource(DocServer* ds, StringView requestPath, ResponseIface* responseIface) {
+// Returns the page's HTML along with the time it was last modified, taking the table of contents
+// into account. Responds with an error and returns an empty string if the page can't be loaded.
+Tuple<String, double> getPageSource(DocServer* ds, StringView requestPath,
+                                    ResponseIface* responseIface) {
     FileSystem* fs = FileSystem::native();
     if (NativePath::isAbsolute(requestPath)) {
         responseIface->respondGeneric(ResponseCode::NotFound);
@@ -120,22 +131,54 @@ String getPageSource(DocServer* ds, StringView requestPath, ResponseIface* respo
         responseIface->respondGeneric(ResponseCode::NotFound);
         return {};
     }
-    return pageHtml;
+    double modificationTime = max(fs->getFileStatus(absPath).modificationTime,
+                                  fs->getFileStatus(ds->contentsPath).modificationTime);
+    return {std::move(pageHtml), modificationTime};
 }
 
-void DocServer::serve(StringView requestPath, ResponseIface* responseIface) {
-    FileSystem* fs = FileSystem::native();
+// Returns the part of requestPath before the first occurrence of separator. Query parameters
+// don't affect the page, so they're ignored, and left out of cache keys.
+PLY_INLINE StringView stripQuery(StringView requestPath, char separator) {
+    s32 pos = requestPath.findByte(separator);
+    return pos >= 0 ? requestPath.left(pos) : requestPath;
+}
+
+// Returns true if the page was sent from the cache. Otherwise, returns the cache generation to
+// pass to respondWithPage() once the page is generated. Generated pages are cached by their path
+// relative to the site root, with query parameters removed, so that requests for the same page
+// share a single entry.
+bool respondFromCache(DocServer* ds, StringView cacheKey, ResponseIface* responseIface,
+                      u64* generation) {
+    if (!ds->cache)
+        return false;
+    if (Reference<ResponseCache::Entry> entry = ds->cache->find(cacheKey)) {
+        ResponseCache::respond(entry, responseIface);
+        return true;
+    }
+    *generation = ds->cache->getGeneration();
+    return false;
+}
+
+// Sends a generated page, adding it to the cache if there is one. Pages are sent with "no-cache"
+// so that browsers revalidate them, which is cheap when they haven't changed.
+void respondWithPage(DocServer* ds, StringView cacheKey, u64 generation, double modificationTime,
+                     String&& html, ResponseIface* responseIface) {
+    static const StringView ContentType = "text/html; charset=utf-8";
+    if (ds->cache) {
+        Reference<ResponseCache::Entry> entry = ds->cache->add(
+            cacheKey, generation, ContentType, "no-cache", modificationTime, std::move(html));
+        ResponseCache::respond(entry, responseIface);
+    } else {
+        responseIface->respondWith(ResponseCode::OK, ContentType, html);
+    }
+}
 
+void DocServer::serve(StringView requestPath, ResponseIface* responseIface) {
     // Check if contents.pylon has been updated:
-    FileStatus contentsStatus = fs->getFileStatus(this->contentsPath);
-    if (contentsStatus.result == FSResult::OK) {
-        if (contentsStatus.modificationTime != this->contentsModTime.load(MemoryOrder::Acquire)) {
-            ply::LockGuard<ply::Mutex> guard{this->contentsMutex};
-            if (contentsStatus.modificationTime !=
-                this->contentsModTime.load(MemoryOrder::Relaxed)) {
-                this->reloadContents();
-            }
-            this->contentsModTime = contentsStatus.modificationTime;
+    if (this->contentsChanged.load(MemoryOrder::Relaxed)) {
+        ply::LockGuard<ply::Mutex> guard{this->contentsMutex};
+        if (this->contentsChanged.exchange(0, MemoryOrder::Acquire)) {
+            this->reloadContents();
         }
     }
 
@@ -144,11 +187,17 @@ void DocServer::serve(StringView requestPath, ResponseIface* responseIface) {
         return;
     }
 
+    requestPath = stripQuery(requestPath, '?');
+    String cacheKey = StringView{"/docs/"} + requestPath;
+    u64 generation = 0;
+    if (respondFromCache(this, cacheKey, responseIface, &generation))
+        return;
+
     // Load page
-    String pageHtml = getPageSource(this, requestPath, responseIface);
-    if (!pageHtml)
+    Tuple<String, double> pageSource = getPageSource(this, requestPath, responseIface);
+    if (!pageSource.first)
         return;
-    ViewInStream vins{pageHtml};
+    ViewInStream vins{pageSource.first};
     String pageTitle = vins.readView<fmt::Line>().trim(isWhite);
 
     // Figure out which TOC entries to expand
@@ -165,9 +214,9 @@ void DocServer::serve(StringView requestPath, ResponseIface* responseIface) {
         }
     }
 
-    OutStream* outs = responseIface->beginResponseHeader(ResponseCode::OK);
-    *outs << "Content-Type: text/html; charset=utf-8\r\n\r\n";
-    responseIface->endResponseHeader();
+    // Generate the page in memory so that it can be sent with a Content-Length and cached.
+    MemOutStream mout;
+    OutStream* outs = &mout;
     outs->format(R"#(<!DOCTYPE html>
 <html>
 <head>
@@ -218,19 +267,28 @@ void DocServer::serve(StringView requestPath, ResponseIface* responseIface) {
 </body>
 </html>
 )";
+    respondWithPage(this, cacheKey, generation, pageSource.second, mout.moveToString(),
+                    responseIface);
 }
 
 void DocServer::serveContentOnly(StringView requestPath, ResponseIface* responseIface) {
-    String pageHtml = getPageSource(this, requestPath, responseIface);
-    if (!pageHtml)
+    // requestPath is already part of the query, so any other parameters follow an '&'.
+    requestPath = stripQuery(requestPath, '&');
+    String cacheKey = StringView{"/content?path=/docs/"} + requestPath;
+    u64 generation = 0;
+    if (respondFromCache(this, cacheKey, responseIface, &generation))
+        return;
+
+    Tuple<String, double> pageSource = getPageSource(this, requestPath, responseIface);
+    if (!pageSource.first)
         return;
-    OutStream* outs = responseIface->beginResponseHeader(ResponseCode::OK);
-    ViewInStream vins{pageHtml};
+    ViewInStream vins{pageSource.first};
     String pageTitle = vins.readView<fmt::Line>().trim(isWhite);
-    *outs << "Content-Type: text/html\r\n\r\n";
-    responseIface->endResponseHeader();
-    outs->format("{}\n<h1>{}</h1>\n", pageTitle, pageTitle);
-    *outs << vins.viewAvailable();
+    MemOutStream mout;
+    mout.format("{}\n<h1>{}</h1>\n", pageTitle, pageTitle);
+    mout << vins.viewAvailable();
+    respondWithPage(this, cacheKey, generation, pageSource.second, mout.moveToString(),
+                    responseIface);
 }
 
 } // namespace web
@@ -5,7 +5,9 @@
 #pragma once
 #include <ply-web-serve-docs/Core.h>
 #include <web-common/Response.h>
+#include <web-common/ResponseCache.h>
 #include <web-documentation/Contents.h>
+#include <ply-runtime/filesystem/DirectoryWatcher.h>
 
 namespace ply {
 namespace web {
@@ -26,13 +28,19 @@ struct DocServer {
 
     String dataRoot;
     String contentsPath;
+    // Optional. If set, generated pages are served from memory until a file under dataRoot
+    // changes. The cache should be watching dataRoot.
+    ResponseCache* cache = nullptr;
+    Atomic<u32> contentsChanged = 0; // Set by the watcher thread
 
     // These members are protected by contentsMutex:
     Mutex contentsMutex;
-    Atomic<double> contentsModTime = 0;
     Array<Owned<Contents>> contents;
     HashMap<ContentsTraits> pathToContents;
 
+    // Declared last so that the watcher thread stops before any other member is destroyed.
+    Owned<DirectoryWatcher> watcher;
+
     void init(StringView dataRoot);
     void reloadContents();
     void serve(StringView requestPath, ResponseIface* responseIface);